@@ -11,11 +11,15 @@ LOCAL_CPPFLAGS += -fexceptions
 
 LOCAL_CFLAGS += -DINIT_CONF_DIR=\"/vendor/etc/\"
 
-LOCAL_SRC_FILES := client_hdl.cpp \
+LOCAL_SRC_FILES := async_file_wr.cpp \
+                   buf_pool.cpp \
+                   client_hdl.cpp \
                    client_hdl_miniap.cpp \
                    client_hdl_mipilog.cpp \
                    client_mgr.cpp \
                    client_req.cpp \
+                   commit_tuner.cpp \
+                   convey_throttle.cpp \
                    convey_unit.cpp \
                    convey_unit_base.cpp \
                    convey_workshop.cpp \
@@ -35,12 +39,15 @@ LOCAL_SRC_FILES := client_hdl.cpp \
                    dev_file_open.cpp \
                    diag_dev_hdl.cpp \
                    diag_stream_parser.cpp \
+                   evict_index.cpp \
                    evt_notifier.cpp \
                    ext_gnss_log.cpp \
                    ext_wcn_dump.cpp \
                    fd_hdl.cpp \
                    file_watcher.cpp \
+                   ingest_reactor.cpp \
                    io_chan.cpp \
+                   io_ring.cpp \
                    io_sched.cpp \
                    log_config.cpp \
                    log_config_with_modemtype.cpp \
@@ -48,8 +55,12 @@ LOCAL_SRC_FILES := client_hdl.cpp \
                    log_ctrl_miniap.cpp \
                    log_ctrl_mipilog.cpp \
                    log_file.cpp \
+                   log_frame.cpp \
+                   log_index.cpp \
                    log_pipe_dev.cpp \
                    log_pipe_hdl.cpp \
+                   log_reclaimer.cpp \
+                   lz4_block.cpp \
                    major_minor_num_a6.cpp \
                    media_stor.cpp \
                    media_stor_check.cpp \
@@ -143,6 +154,10 @@ ifeq ($(strip $(BOARD_SECURE_BOOT_ENABLE)), true)
     LOCAL_CFLAGS += -DSECURE_BOOT_ENABLE
 endif
 
+ifeq ($(strip $(SPRD_CP_LOG_IO_URING)), true)
+    LOCAL_CFLAGS += -DSUPPORT_IO_URING
+endif
+
 ifeq ($(strip $(USE_SPRD_ORCA_MODEM)), true)
     LOCAL_CFLAGS += -DUSE_ORCA_MODEM
     LOCAL_SRC_FILES += modem_utils.cpp \
@@ -204,6 +219,7 @@ LOCAL_SRC_FILES := client_req.cpp \
                    utility/cplogctl_cmn.cpp \
                    utility/en_evt_req.cpp \
                    utility/flush_req.cpp \
+                   utility/get_buf_geometry.cpp \
                    utility/get_cp_max_size.cpp \
                    utility/get_log_file_size.cpp \
                    utility/get_mipi_log.cpp \
@@ -215,6 +231,7 @@ LOCAL_SRC_FILES := client_req.cpp \
                    utility/save_last_log_req.cpp \
                    utility/set_ag_log_dest.cpp \
                    utility/set_ag_pcm.cpp \
+                   utility/set_buf_geometry.cpp \
                    utility/set_cp_max_size.cpp \
                    utility/set_log_file_size.cpp \
                    utility/set_mini_ap.cpp \
@@ -230,5 +247,13 @@ LOCAL_SHARED_LIBRARIES := libc \
 LOCAL_CFLAGS += -DLOG_TAG=\"CPLOG_CTL\"
 include $(BUILD_EXECUTABLE)
 
+# Decompressor of the compressed log files on the host
+include $(CLEAR_VARS)
+LOCAL_MODULE := cplogunpack
+LOCAL_SRC_FILES := lz4_block.cpp \
+                   utility/cplogunpack.cpp
+LOCAL_CPPFLAGS += -std=c++11
+include $(BUILD_HOST_EXECUTABLE)
+
 CUSTOM_MODULES += slogmodem flush_slog_modem cplogctl
 include $(call all-makefiles-under,$(LOCAL_PATH))
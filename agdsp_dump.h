@@ -72,7 +72,7 @@ class AgdspDump : public FdHandler {
   pthread_t m_save_thread;
   // Mutex for sync between main thread and agdsp_dump thread
   pthread_mutex_t m_lock;
-  TimerManager::Timer* m_timer;
+  TimerManager::TimerHandle m_timer;
   // The socket descriptor used by the dump saving thread (agdsp_dump)
   int m_sock_fd;
   std::weak_ptr<LogFile> m_dump_file;
@@ -13,12 +13,14 @@
 #include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "agdsp_log.h"
 #include "audio_dsp_ioctl.h"
 #include "client_mgr.h"
 #include "cp_stor.h"
+#include "def_config.h"
 #include "log_ctrl.h"
 #include "multiplexer.h"
 #include "parse_utils.h"
@@ -32,6 +34,8 @@ AgDspLogHandler::AgDspLogHandler(LogController* ctrl, Multiplexer* multi,
       m_pcm_controller{ctrl, multi, "/dev/audio_dsp_pcm"},
       m_dump{ctrl, multi, "/dev/audio_dsp_mem"},
       m_sn{0} {
+  // The log is committed by the buffer fill level in save_log().
+  m_commit_tuning = false;
   m_dump.set_dump_start_callback(this, dump_callback);
   m_dump.set_dump_result_notifier(this, dump_result_notifiy);
   m_pcm_controller.set_notify(notify_pcm, this);
@@ -156,21 +160,40 @@ void AgDspLogHandler::process(int /*events*/) {
 }
 
 void AgDspLogHandler::save_log(int fd, DspLogType type) {
-  if (!m_buffer) {
-    m_buffer = storage()->get_buffer();
-    if (!m_buffer) {  // No free buffers
-      del_events(POLLIN);
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  size_t total = 0;
+
+  // Read until EAGAIN or the budget is used up. Each read gets its own
+  // SMP and message header, so the data is not read across buffers.
+  while (total < LOG_READ_BUDGET) {
+    if (!m_buffer) {
+      m_buffer = storage()->get_buffer();
+      if (!m_buffer) {  // No free buffers
+        del_events(POLLIN);
+        return;
+      }
+    }
+
+    // Process AG-DSP log
+    size_t wr_start = m_buffer->data_start + m_buffer->data_len;
+    uint8_t* wr_ptr = m_buffer->buffer + wr_start;
+    size_t rlen = m_buffer->buf_size - wr_start;
+    ssize_t nr = read(fd, wr_ptr + 20, rlen - 20);
+
+    if (nr <= 0) {
+      if (-1 == nr) {
+        if (EAGAIN != errno && EINTR != errno) {
+          err_log("read AG-DSP log or PCM error");
+        }
+      } else {
+        err_log("AG-DSP log or PCM device driver bug: read returns 0");
+      }
       return;
     }
-  }
 
-  // Process AG-DSP log
-  size_t wr_start = m_buffer->data_start + m_buffer->data_len;
-  uint8_t* wr_ptr = m_buffer->buffer + wr_start;
-  size_t rlen = m_buffer->buf_size - wr_start;
-  ssize_t nr = read(fd, wr_ptr + 20, rlen - 20);
+    total += nr;
 
-  if (nr > 0) {
     // Add SMP and message header
     add_headers(wr_ptr, nr, type);
     nr += 20;
@@ -189,13 +212,13 @@ void AgDspLogHandler::save_log(int fd, DspLogType type) {
         m_buffer = nullptr;
       }
     }
-  } else {
-    if (-1 == nr) {
-      if (EAGAIN != errno && EINTR != errno) {
-        err_log("read AG-DSP log or PCM error");
-      }
-    } else {
-      err_log("AG-DSP log or PCM device driver bug: read returns 0");
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((now.tv_sec - start.tv_sec) * 1000 +
+            (now.tv_nsec - start.tv_nsec) / 1000000 >=
+        static_cast<long>(LOG_READ_BUDGET_TIME)) {
+      break;
     }
   }
 }
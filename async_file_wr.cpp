@@ -0,0 +1,230 @@
+/*
+ *  async_file_wr.cpp - asynchronous file writer of diag transactions.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cstring>
+#include <poll.h>
+
+#include "async_file_wr.h"
+#include "cp_log_cmn.h"
+#include "def_config.h"
+#include "fd_hdl.h"
+#include "log_file.h"
+
+AsyncFileWriter::AsyncFileWriter(size_t read_size)
+    :m_min_free{(read_size + DIAG_WRITER_BUF_SIZE - 1) / DIAG_WRITER_BUF_SIZE},
+     m_buf_inited{false},
+     m_async{false},
+     m_src{nullptr},
+     m_cur{nullptr},
+     m_throttled{false},
+     m_start_size{0},
+     m_total{0},
+     m_dropped{0},
+     m_err{0} {
+  if (!m_min_free) {
+    m_min_free = 1;
+  }
+  m_sched.set_buffer_size(DIAG_WRITER_BUF_SIZE,
+                          DIAG_WRITER_BUF_NUM + m_min_free - 1);
+  // Full buffers are committed at once.
+  m_sched.set_commit_threshold(DIAG_WRITER_BUF_SIZE);
+  m_sched.set_max_requests(2);
+  m_sched.set_file_written_callback(this, file_written);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  if (m_file) {
+    discard();
+  }
+}
+
+int AsyncFileWriter::open(std::shared_ptr<LogFile> f, IoChannel* chan,
+                          FdHandler* src) {
+  if (m_file || !f) {
+    return -1;
+  }
+
+  if (chan) {
+    if (!m_buf_inited) {
+      m_sched.init_buffer();
+      m_buf_inited = true;
+    }
+    m_sched.bind(chan);
+    m_sched.open(f.get());
+    m_async = true;
+  } else {
+    info_log("no I/O channel for %s, write synchronously",
+             ls2cstring(f->base_name()));
+    m_async = false;
+  }
+
+  m_file = f;
+  m_src = src;
+  m_start_size = f->size();
+  m_total = 0;
+  m_dropped = 0;
+  m_err = 0;
+
+  return 0;
+}
+
+int AsyncFileWriter::write(const void* data, size_t len) {
+  if (!m_file || m_err) {
+    return -1;
+  }
+
+  if (!m_async) {
+    ssize_t n = m_file->write(data, len);
+
+    if (static_cast<size_t>(n) != len) {
+      m_err = n < 0 ? LogFile::FIO_ERROR : LogFile::FIO_DISK_FULL;
+      return -1;
+    }
+    m_total += len;
+    return 0;
+  }
+
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+
+  while (len) {
+    if (!m_cur) {
+      m_cur = m_sched.get_free_buffer();
+      if (!m_cur) {
+        // More data than the buffers can hold arrived before the
+        // source handler was throttled. Don't block the event loop
+        // on the outstanding writes: drop the rest and stop reading
+        // until the writes finish.
+        err_log("no buffer for %s, %lu bytes dropped",
+                ls2cstring(m_file->base_name()),
+                static_cast<unsigned long>(len));
+        m_dropped += len;
+        throttle();
+        break;
+      }
+    }
+
+    size_t n = m_cur->buf_size - m_cur->data_len;
+
+    if (n > len) {
+      n = len;
+    }
+    memcpy(m_cur->buffer + m_cur->data_len, p, n);
+    m_cur->data_len += n;
+    m_total += n;
+    p += n;
+    len -= n;
+    if (m_cur->data_len == m_cur->buf_size) {
+      commit_cur();
+    }
+  }
+
+  if (m_sched.free_buffer_num() < m_min_free) {
+    throttle();
+  }
+
+  return m_err ? -1 : 0;
+}
+
+void AsyncFileWriter::commit_cur() {
+  DataBuffer* buf = m_cur;
+
+  m_cur = nullptr;
+  m_sched.enqueue(buf);
+}
+
+int AsyncFileWriter::close() {
+  if (!m_file) {
+    return -1;
+  }
+
+  if (m_async) {
+    if (m_cur) {
+      if (m_cur->data_len) {
+        commit_cur();
+      } else {
+        m_sched.free_buffer(m_cur);
+        m_cur = nullptr;
+      }
+    }
+    m_sched.flush();
+    m_sched.close();
+  }
+
+  int ret = 0;
+  // Errors of the writes waited for by flush() are not reported by
+  // the callback, so check the file size.
+  if (m_err || m_file->size() - m_start_size != m_total) {
+    err_log("%s: %lu bytes written, %lu expected",
+            ls2cstring(m_file->base_name()),
+            static_cast<unsigned long>(m_file->size() - m_start_size),
+            static_cast<unsigned long>(m_total));
+    ret = -1;
+  }
+  if (m_dropped) {
+    err_log("%s: %lu bytes dropped", ls2cstring(m_file->base_name()),
+            static_cast<unsigned long>(m_dropped));
+    ret = -1;
+  }
+
+  reset();
+
+  return ret;
+}
+
+void AsyncFileWriter::discard() {
+  if (!m_file) {
+    return;
+  }
+
+  if (m_async) {
+    if (m_cur) {
+      m_sched.free_buffer(m_cur);
+      m_cur = nullptr;
+    }
+    m_sched.discard_queue();
+    m_sched.close();
+  }
+
+  reset();
+}
+
+void AsyncFileWriter::reset() {
+  resume();
+  m_src = nullptr;
+  m_file.reset();
+  m_async = false;
+}
+
+void AsyncFileWriter::throttle() {
+  if (!m_throttled && m_src) {
+    m_src->del_events(POLLIN);
+    m_throttled = true;
+  }
+}
+
+void AsyncFileWriter::resume() {
+  if (m_throttled) {
+    m_throttled = false;
+    m_src->add_events(POLLIN);
+  }
+}
+
+void AsyncFileWriter::file_written(void* client, LogFile* /*lf*/, int err) {
+  AsyncFileWriter* wr = static_cast<AsyncFileWriter*>(client);
+
+  if (err && !wr->m_err) {
+    err_log("write %s error %d", ls2cstring(wr->m_file->base_name()), err);
+    wr->m_err = err;
+  }
+
+  if (wr->m_sched.free_buffer_num() >= wr->m_min_free) {
+    wr->resume();
+  }
+}
@@ -0,0 +1,116 @@
+/*
+ *  async_file_wr.h - asynchronous file writer of diag transactions.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _ASYNC_FILE_WR_H_
+#define _ASYNC_FILE_WR_H_
+
+#include <memory>
+
+#include "io_sched.h"
+
+class FdHandler;
+class LogFile;
+
+/*  AsyncFileWriter - write a dump/sleep log/event log file through an
+ *                    IoChannel.
+ *
+ *  Data is copied into the writer's own buffers and written by the
+ *  IoChannel of the media, so the event loop does not block on the
+ *  file system. When the free buffers can not hold one more read,
+ *  POLLIN of the source handler is disabled until writes finish, so
+ *  the data is left in the device instead of being lost or blocking
+ *  the event loop.
+ *
+ *  When there is no IoChannel, the data is written synchronously.
+ */
+class AsyncFileWriter {
+ public:
+  /*  AsyncFileWriter - constructor
+   *  @read_size: max number of bytes the source handler reads at once.
+   *
+   *  The source handler is throttled when the free buffers can not
+   *  hold read_size bytes.
+   */
+  explicit AsyncFileWriter(size_t read_size = 1024 * 32);
+  AsyncFileWriter(const AsyncFileWriter&) = delete;
+  ~AsyncFileWriter();
+
+  AsyncFileWriter& operator = (const AsyncFileWriter&) = delete;
+
+  /*  open - start writing the file.
+   *  @f: the file.
+   *  @chan: the IoChannel of the media of f. May be nullptr.
+   *  @src: the handler to throttle when all buffers are in use.
+   *        May be nullptr.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int open(std::shared_ptr<LogFile> f, IoChannel* chan, FdHandler* src);
+
+  bool is_open() const { return static_cast<bool>(m_file); }
+  /*  throttled - whether POLLIN of the source handler is disabled.
+   *
+   *  The source handler shall stop reading when throttled() is true.
+   */
+  bool throttled() const { return m_throttled; }
+
+  /*  write - queue data for writing.
+   *
+   *  Data that does not fit into the free buffers, e.g. when the
+   *  source handler reads on while throttled, is dropped and counted
+   *  instead of waiting for the outstanding writes.
+   *
+   *  Return 0 on success, -1 if the data or earlier data can not be
+   *  written.
+   */
+  int write(const void* data, size_t len);
+  /*  close - write all queued data and stop writing the file.
+   *
+   *  The file itself is not closed.
+   *
+   *  Return 0 if all data is written, -1 otherwise (including when
+   *  data has been dropped).
+   */
+  int close();
+  /*  discard - drop queued data and stop writing the file.
+   *
+   *  Outstanding writes are waited for, so the file can be closed
+   *  or removed after discard() returns.
+   */
+  void discard();
+
+ private:
+  IoScheduler m_sched;
+  // Free buffers needed to read the source handler
+  size_t m_min_free;
+  bool m_buf_inited;
+  std::shared_ptr<LogFile> m_file;
+  bool m_async;
+  FdHandler* m_src;
+  // Buffer being filled
+  DataBuffer* m_cur;
+  bool m_throttled;
+  // Size of the file on open
+  size_t m_start_size;
+  // Number of bytes accepted by write()
+  size_t m_total;
+  // Number of bytes dropped for lack of buffers
+  size_t m_dropped;
+  // Error of the last failed write
+  int m_err;
+
+  void commit_cur();
+  void throttle();
+  void resume();
+  void reset();
+
+  static void file_written(void* client, LogFile* lf, int err);
+};
+
+#endif  // !_ASYNC_FILE_WR_H_
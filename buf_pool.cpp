@@ -0,0 +1,230 @@
+/*
+ *  buf_pool.cpp - the log buffer pool shared by all subsystems.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <algorithm>
+
+#include "buf_pool.h"
+
+BufferPool::BufferPool(size_t shared_size)
+    : m_shared_size{shared_size},
+      m_reserved_size{0},
+      m_alloc_size{0},
+      m_notifying{false} {}
+
+BufferPool::~BufferPool() {
+  m_waiters.clear();
+  while (!m_clients.empty()) {
+    remove_client(m_clients.back());
+  }
+}
+
+BufferPool::Client* BufferPool::add_client(size_t block_size,
+                                           size_t reserved,
+                                           void* cb_client,
+                                           buffer_avail_callback_t cb) {
+  Client* c = new Client{block_size, reserved, 0, 0, 0, {}, false, false,
+                         cb_client, cb};
+
+  reserve(c);
+  c->reserved = c->owned;
+
+  m_reserved_size += c->reserved * block_size;
+  m_clients.push_back(c);
+
+  return c;
+}
+
+void BufferPool::remove_client(Client* c) {
+  for (auto buf : c->idle) {
+    delete buf;
+  }
+  m_reserved_size -= c->reserved * c->block_size;
+  m_alloc_size -= c->alloc_size;
+
+  m_clients.erase(std::find(m_clients.begin(), m_clients.end(), c));
+  auto it = std::find(m_waiters.begin(), m_waiters.end(), c);
+  if (it != m_waiters.end()) {
+    m_waiters.erase(it);
+  }
+  delete c;
+
+  notify_waiters();
+}
+
+int BufferPool::resize_client(Client* c, size_t block_size,
+                              size_t reserved) {
+  if (c->stale) {
+    err_log("%u buffers of the previous size still in use",
+            static_cast<unsigned>(c->stale));
+    return -1;
+  }
+
+  for (auto buf : c->idle) {
+    c->alloc_size -= buf->buf_size;
+    m_alloc_size -= buf->buf_size;
+    delete buf;
+  }
+  c->owned -= c->idle.size();
+  c->idle.clear();
+  m_reserved_size -= c->reserved * c->block_size;
+
+  if (block_size != c->block_size) {
+    // The buffers in use are released when they are returned.
+    c->stale = c->owned;
+    c->owned = 0;
+    c->block_size = block_size;
+  }
+  c->reserved = reserved;
+  reserve(c);
+  if (c->owned < reserved) {
+    c->reserved = c->owned;
+  }
+  m_reserved_size += c->reserved * block_size;
+
+  notify_waiters();
+
+  return 0;
+}
+
+DataBuffer* BufferPool::get(Client* c) {
+  DataBuffer* buf = nullptr;
+  bool granted = c->granted;
+
+  c->granted = false;
+  if (!c->idle.empty()) {
+    buf = c->idle.back();
+    c->idle.pop_back();
+  } else if (m_waiters.empty() || m_waiters.front() == c || granted) {
+    // Borrow in the waiting order.
+    if (!can_borrow(c)) {
+      reclaim_idle(c);
+    }
+    if (can_borrow(c)) {
+      buf = alloc_data_buf(c->block_size);
+      if (buf) {
+        ++c->owned;
+        c->alloc_size += c->block_size;
+        m_alloc_size += c->block_size;
+      }
+    }
+  }
+
+  if (buf) {
+    if (c->waiting) {
+      c->waiting = false;
+      m_waiters.erase(std::find(m_waiters.begin(), m_waiters.end(), c));
+    }
+  } else {
+    add_waiter(c);
+  }
+
+  return buf;
+}
+
+void BufferPool::put(Client* c, DataBuffer* buf) {
+  // Return the borrowed memory when another client is waiting.
+  if (stale(c, buf) ||
+      (borrowing(c) && !m_waiters.empty() && m_waiters.front() != c)) {
+    release(c, buf);
+  } else {
+    c->idle.push_back(buf);
+  }
+
+  notify_waiters();
+}
+
+void BufferPool::release(Client* c, DataBuffer* buf) {
+  if (stale(c, buf)) {
+    --c->stale;
+  } else {
+    --c->owned;
+  }
+  c->alloc_size -= buf->buf_size;
+  m_alloc_size -= buf->buf_size;
+  delete buf;
+}
+
+void BufferPool::reserve(Client* c) {
+  c->idle.reserve(c->reserved);
+  while (c->owned < c->reserved) {
+    DataBuffer* buf = alloc_data_buf(c->block_size);
+    if (!buf) {
+      err_log("allocate %u bytes buffer error",
+              static_cast<unsigned>(c->block_size));
+      break;
+    }
+    c->idle.push_back(buf);
+    ++c->owned;
+    c->alloc_size += c->block_size;
+    m_alloc_size += c->block_size;
+  }
+}
+
+void BufferPool::reclaim_idle(const Client* c) {
+  for (auto other : m_clients) {
+    if (other == c) {
+      continue;
+    }
+    while (borrowing(other) && !other->idle.empty()) {
+      release(other, other->idle.back());
+      other->idle.pop_back();
+      if (can_borrow(c)) {
+        return;
+      }
+    }
+  }
+}
+
+void BufferPool::add_waiter(Client* c) {
+  if (!c->waiting) {
+    c->waiting = true;
+    m_waiters.push_back(c);
+  }
+}
+
+void BufferPool::notify_waiters() {
+  // The callbacks may get buffers and return them.
+  if (m_notifying) {
+    return;
+  }
+  m_notifying = true;
+
+  size_t i = 0;
+  while (i < m_waiters.size()) {
+    Client* c = m_waiters[i];
+
+    // Only the first waiter may borrow.
+    if (c->idle.empty()) {
+      if (i) {
+        ++i;
+        continue;
+      }
+      if (!can_borrow(c)) {
+        reclaim_idle(c);
+        if (!can_borrow(c)) {
+          ++i;
+          continue;
+        }
+      }
+    }
+
+    c->waiting = false;
+    m_waiters.erase(m_waiters.begin() + i);
+    // The client keeps its turn until it gets a buffer.
+    c->granted = true;
+    if (c->cb) {
+      c->cb(c->cb_client);
+    }
+    // The callback may change the list, so start over.
+    i = 0;
+  }
+
+  m_notifying = false;
+}
@@ -0,0 +1,143 @@
+/*
+ *  buf_pool.h - the log buffer pool shared by all subsystems.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _BUF_POOL_H_
+#define _BUF_POOL_H_
+
+#include <vector>
+
+#include "cp_log_cmn.h"
+#include "data_buf.h"
+
+/*  BufferPool - DataBuffer arena of all IoSchedulers.
+ *
+ *  Each client (one IoScheduler) has its own block size and a number
+ *  of reserved buffers, which are allocated when the client is added
+ *  and are always available to it. A client whose reserved buffers are
+ *  all in use may borrow more buffers as long as the memory of all
+ *  clients stays under the cap, which is the sum of the reservations
+ *  plus the shared size.
+ *
+ *  When a client can't get a buffer it's put on the waiting list, and
+ *  the idle borrowed buffers of the other clients are released. While
+ *  a client is waiting, borrowed buffers are released when they are
+ *  freed instead of being kept by the borrower, and new borrowing is
+ *  served in the waiting order. The waiting clients are notified by
+ *  their buffer available callbacks.
+ *
+ *  The pool is used by the main thread only.
+ */
+class BufferPool {
+ public:
+  typedef void (*buffer_avail_callback_t)(void* client);
+
+  struct Client {
+    size_t block_size;
+    // Number of reserved buffers
+    size_t reserved;
+    // Number of buffers of block_size allocated for the client
+    size_t owned;
+    // Number of buffers of an earlier block size still in use
+    size_t stale;
+    // Total size of the client's buffers
+    size_t alloc_size;
+    std::vector<DataBuffer*> idle;
+    bool waiting;
+    // Notified of available buffers and may borrow out of the waiting
+    // order on its next get()
+    bool granted;
+    void* cb_client;
+    buffer_avail_callback_t cb;
+  };
+
+  explicit BufferPool(size_t shared_size);
+  BufferPool(const BufferPool&) = delete;
+  ~BufferPool();
+
+  BufferPool& operator = (const BufferPool&) = delete;
+
+  /*  add_client - add a client and allocate its reserved buffers.
+   *  @block_size: size of the client's buffers.
+   *  @reserved: number of buffers reserved for the client.
+   *  @cb_client: parameter of the buffer available callback.
+   *  @cb: the buffer available callback.
+   *
+   *  Return the Client pointer on success, nullptr on failure.
+   */
+  Client* add_client(size_t block_size, size_t reserved, void* cb_client,
+                     buffer_avail_callback_t cb);
+  /*  remove_client - remove the client and free its idle buffers.
+   *
+   *  The buffers still used by the client shall be deleted by the
+   *  caller.
+   */
+  void remove_client(Client* c);
+
+  /*  resize_client - change the block size and the reservation.
+   *
+   *  The idle buffers are freed and the new reserved buffers are
+   *  allocated. When the block size changes, the buffers in use are
+   *  released when they are returned.
+   *
+   *  Return 0 on success, -1 if the buffers of the previous block size
+   *  are still in use.
+   */
+  int resize_client(Client* c, size_t block_size, size_t reserved);
+
+  /*  get - get an idle buffer or borrow a new one for the client.
+   *
+   *  Return nullptr if no buffer is available, and the client is
+   *  notified when one is available. The notified client keeps its
+   *  turn until its next get().
+   */
+  DataBuffer* get(Client* c);
+  /*  put - return the buffer got by get().
+   */
+  void put(Client* c, DataBuffer* buf);
+
+  size_t cap() const { return m_reserved_size + m_shared_size; }
+  size_t allocated() const { return m_alloc_size; }
+
+ private:
+  size_t m_shared_size;
+  // Total size of the reserved buffers
+  size_t m_reserved_size;
+  // Total size of the allocated buffers
+  size_t m_alloc_size;
+  LogVector<Client*> m_clients;
+  // Clients waiting for buffers, in the waiting order
+  LogVector<Client*> m_waiters;
+  bool m_notifying;
+
+  static bool borrowing(const Client* c) { return c->owned > c->reserved; }
+  static bool stale(const Client* c, const DataBuffer* buf) {
+    return c->stale && buf->buf_size != c->block_size;
+  }
+
+  bool can_borrow(const Client* c) const {
+    return m_alloc_size + c->block_size <= cap();
+  }
+  /*  release - delete the buffer borrowed by the client.
+   */
+  void release(Client* c, DataBuffer* buf);
+  /*  reserve - allocate idle buffers until the client owns the
+   *            reserved number of buffers.
+   */
+  void reserve(Client* c);
+  /*  reclaim_idle - release the idle borrowed buffers of the clients
+   *                 other than c until c can borrow a buffer.
+   */
+  void reclaim_idle(const Client* c);
+  void add_waiter(Client* c);
+  /*  notify_waiters - notify the waiting clients that can get buffers.
+   */
+  void notify_waiters();
+};
+
+#endif  // !_BUF_POOL_H_
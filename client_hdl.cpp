@@ -242,6 +242,21 @@ void ClientHandler::process_req(const uint8_t* req, size_t len) {
       } else if (!memcmp(token, "SET_MD_STOR_POS", 15)) {
         proc_set_md_pos(req, len);
         known_req = true;
+      } else if (!memcmp(token, "GET_CONVEY_STAT", 15)) {
+        proc_get_convey_stat(req, len);
+        known_req = true;
+      } else if (!memcmp(token, "GET_COMMIT_STAT", 15)) {
+        proc_get_commit_stat(req, len);
+        known_req = true;
+      }
+      break;
+    case 16:
+      if (!memcmp(token, "GET_BUF_GEOMETRY", 16)) {
+        proc_get_buf_geometry(req, len);
+        known_req = true;
+      } else if (!memcmp(token, "SET_BUF_GEOMETRY", 16)) {
+        proc_set_buf_geometry(req, len);
+        known_req = true;
       }
       break;
     case 17:
@@ -659,6 +674,73 @@ void ClientHandler::proc_get_storage_choice(const uint8_t* req, size_t len) {
   info_log("GET_STORAGE_CHOICE %s.", ext_stor ? "EXTERNAL" : "INTERNAL");
 }
 
+void ClientHandler::proc_get_convey_stat(const uint8_t* req, size_t len) {
+  size_t tlen;
+
+  const uint8_t* tok = get_token(req, len, tlen);
+  if (tok) {
+    err_log("GET_CONVEY_STAT with extral param");
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  ConveyWorkshop* cw = controller()->convey_workshop();
+  if (!cw) {
+    send_response(fd(), REC_FAILURE);
+    return;
+  }
+
+  // OK <class> <queued units> <bytes/s> ...
+  static const char* const kClassNames[ConveyUnitBase::PRIORITY_NUM] = {
+      "LIVE", "INTERACTIVE", "BACKGROUND"};
+  char rsp[256];
+  int rsp_len = snprintf(rsp, sizeof rsp, "OK");
+
+  for (unsigned i = 0; i < ConveyUnitBase::PRIORITY_NUM; ++i) {
+    ConveyUnitBase::Priority prio = static_cast<ConveyUnitBase::Priority>(i);
+    rsp_len += snprintf(rsp + rsp_len, sizeof rsp - rsp_len, " %s %u %u",
+                        kClassNames[i], cw->material_num(prio),
+                        cw->class_rate(prio));
+  }
+  rsp[rsp_len++] = '\n';
+  write(fd(), rsp, rsp_len);
+}
+
+void ClientHandler::proc_get_commit_stat(const uint8_t* req, size_t len) {
+  const uint8_t* tok;
+  size_t tlen;
+
+  tok = get_token(req, len, tlen);
+  if (!tok) {
+    err_log("GET_COMMIT_STAT no param");
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  CpType cpt = get_cp_type(tok, tlen);
+  if (CT_UNKNOWN == cpt) {
+    err_log("GET_COMMIT_STAT invalid CP type");
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  LogPipeHandler* cp = controller()->get_cp(cpt);
+  if (!cp) {
+    send_response(fd(), trans_result_to_req_result(LCR_CP_NONEXISTENT));
+    return;
+  }
+
+  // OK <bytes/s> <buf commit> <log commit> <max age> <age p50> <age p99>
+  const CommitTuner& tuner = cp->commit_tuner();
+  char rsp[128];
+  int rsp_len = snprintf(rsp, sizeof rsp, "OK %u %u %u %u %u %u\n",
+                         tuner.rate(),
+                         static_cast<unsigned>(tuner.buf_threshold()),
+                         static_cast<unsigned>(tuner.log_threshold()),
+                         tuner.max_age(), tuner.age_p50(), tuner.age_p99());
+  write(fd(), rsp, rsp_len);
+}
+
 void ClientHandler::proc_set_storage_choice(const uint8_t* req, size_t len) {
   const uint8_t* tok;
   size_t tlen;
@@ -774,6 +856,101 @@ void ClientHandler::proc_get_log_file_size(const uint8_t* req, size_t len) {
   }
 }
 
+void ClientHandler::proc_get_buf_geometry(const uint8_t* req, size_t len) {
+  const uint8_t* tok;
+  size_t tlen;
+
+  tok = get_token(req, len, tlen);
+  if (!tok) {
+    err_log("GET_BUF_GEOMETRY no param");
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  CpType cpt = get_cp_type(tok, tlen);
+  if (CT_UNKNOWN == cpt) {
+    err_log("GET_BUF_GEOMETRY invalid CP type");
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  LogConfig::BufGeometry geo;
+  int err = controller()->get_buf_geometry(cpt, geo);
+
+  if (err != LCR_SUCCESS) {
+    err_log("GET_BUF_GEOMETRY fail, err code %d", err);
+    send_response(fd(), trans_result_to_req_result(err));
+  } else {
+    // OK <buf size> <buf num> <log commit> <buf commit>
+    char rsp[64];
+    int rsp_len = snprintf(rsp, sizeof rsp, "OK %u %u %u %u\n",
+                           static_cast<unsigned>(geo.max_buf),
+                           static_cast<unsigned>(geo.max_buf_num),
+                           static_cast<unsigned>(geo.log_commit_threshold),
+                           static_cast<unsigned>(geo.buf_commit_threshold));
+    write(fd(), rsp, rsp_len);
+  }
+}
+
+void ClientHandler::proc_set_buf_geometry(const uint8_t* req, size_t len) {
+  // SET_BUF_GEOMETRY <cp> <buf size> <buf num> <log commit> <buf commit>
+  const uint8_t* tok;
+  const uint8_t* endp = req + len;
+  size_t tlen;
+
+  tok = get_token(req, len, tlen);
+  if (!tok) {
+    err_log("SET_BUF_GEOMETRY no param");
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  CpType cpt = get_cp_type(tok, tlen);
+  if (CT_UNKNOWN == cpt) {
+    err_log("SET_BUF_GEOMETRY invalid CP type");
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  LogString cp_name;
+  str_assign(cp_name, reinterpret_cast<const char*>(tok), tlen);
+
+  // Zero keeps the current value.
+  unsigned vals[4];
+
+  for (auto& val : vals) {
+    req = tok + tlen;
+    len = endp - req;
+    tok = get_token(req, len, tlen);
+    if (!tok || parse_number(tok, tlen, val)) {
+      err_log("SET_BUF_GEOMETRY invalid parameter");
+      send_response(fd(), REC_INVAL_PARAM);
+      return;
+    }
+  }
+
+  req = tok + tlen;
+  len = endp - req;
+  if (len && get_token(req, len, tlen)) {
+    send_response(fd(), REC_INVAL_PARAM);
+    return;
+  }
+
+  info_log("SET_BUF_GEOMETRY %s %u %u %u %u", ls2cstring(cp_name),
+           vals[0], vals[1], vals[2], vals[3]);
+
+  LogConfig::BufGeometry geo{vals[0], vals[1], vals[2], vals[3]};
+  int err = controller()->set_buf_geometry(cpt, geo);
+
+  if (err != LCR_SUCCESS) {
+    err_log("SET_BUF_GEOMETRY %s fail, err code %d", ls2cstring(cp_name),
+            err);
+    send_response(fd(), trans_result_to_req_result(err));
+  } else {
+    send_response(fd(), REC_SUCCESS);
+  }
+}
+
 void ClientHandler::proc_set_cp_log_size(const uint8_t* req, size_t len) {
   const uint8_t* tok;
   const uint8_t* endp = req + len;
@@ -70,6 +70,8 @@ class ClientHandler : public DataProcessHandler {
   void proc_mini_dump(const uint8_t* req, size_t len);
   void proc_get_log_file_size(const uint8_t* req, size_t len);
   void proc_set_log_file_size(const uint8_t* req, size_t len);
+  void proc_get_buf_geometry(const uint8_t* req, size_t len);
+  void proc_set_buf_geometry(const uint8_t* req, size_t len);
   void proc_get_data_part_size(const uint8_t* req, size_t len);
   void proc_set_data_part_size(const uint8_t* req, size_t len);
   void proc_get_md_pos(const uint8_t* req, size_t len);
@@ -99,6 +101,8 @@ class ClientHandler : public DataProcessHandler {
   void proc_save_last_log(const uint8_t* req, size_t len);
   void proc_get_storage_choice(const uint8_t* req, size_t len);
   void proc_set_storage_choice(const uint8_t* req, size_t len);
+  void proc_get_convey_stat(const uint8_t* req, size_t len);
+  void proc_get_commit_stat(const uint8_t* req, size_t len);
   void proc_set_miniap_status(const uint8_t* req, size_t len);
   void proc_sleep_log_result(int result);
   void proc_ringbuf_result(int result);
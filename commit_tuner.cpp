@@ -0,0 +1,129 @@
+/*
+ *  commit_tuner.cpp - adapt the log commit thresholds to the log rate.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include "commit_tuner.h"
+#include "def_config.h"
+
+void AgeHistogram::add(uint64_t age) {
+  unsigned i = 0;
+
+  while (age && i < BUCKET_NUM - 1) {
+    age >>= 1;
+    ++i;
+  }
+  ++m_buckets[i];
+  ++m_count;
+}
+
+void AgeHistogram::clear() {
+  for (auto& n : m_buckets) {
+    n = 0;
+  }
+  m_count = 0;
+}
+
+unsigned AgeHistogram::percentile(unsigned pct) const {
+  if (!m_count) {
+    return 0;
+  }
+
+  // Rank of the sample, starting from 1
+  uint64_t rank = (m_count * pct + 99) / 100;
+  uint64_t below = 0;
+  unsigned i = 0;
+
+  if (!rank) {
+    rank = 1;
+  }
+  while (below + m_buckets[i] < rank) {
+    below += m_buckets[i];
+    ++i;
+  }
+
+  if (!i) {
+    return 0;
+  }
+
+  uint64_t low = 1ULL << (i - 1);
+
+  return static_cast<unsigned>(low + low * (rank - below) / m_buckets[i]);
+}
+
+CommitTuner::CommitTuner()
+    : m_buf_max{0},
+      m_log_max{0},
+      m_buf_threshold{0},
+      m_log_threshold{0},
+      m_max_age{LOG_DATA_MAX_AGE},
+      m_bytes{0},
+      m_rate{0},
+      m_age_p50{0},
+      m_age_p99{0} {}
+
+void CommitTuner::set_bounds(size_t buf_max, size_t log_max) {
+  m_buf_max = buf_max;
+  m_log_max = log_max;
+  m_buf_threshold = buf_max;
+  m_log_threshold = log_max;
+  m_max_age = LOG_DATA_MAX_AGE;
+}
+
+size_t CommitTuner::fit(size_t want, size_t max) {
+  size_t thr = LOG_COMMIT_MIN_THRESHOLD;
+
+  while (thr < want && thr < max) {
+    thr <<= 1;
+  }
+
+  return thr < max ? thr : max;
+}
+
+bool CommitTuner::adjust(unsigned period) {
+  if (!period) {
+    return false;
+  }
+
+  uint64_t sample = m_bytes * 1000 / period;
+
+  m_bytes = 0;
+  // Follow a burst at once, and slow down gradually.
+  if (sample >= m_rate) {
+    m_rate = static_cast<unsigned>(sample);
+  } else {
+    m_rate = static_cast<unsigned>((m_rate + sample) / 2);
+  }
+
+  size_t want = static_cast<uint64_t>(m_rate) * LOG_COMMIT_AGE_TARGET / 1000;
+  size_t buf_thr = fit(want, m_buf_max);
+  size_t log_thr = fit(want, m_log_max);
+  // The age is checked as soon as the log slows down, since the
+  // thresholds follow the smoothed rate.
+  size_t last = sample * LOG_COMMIT_AGE_TARGET / 1000;
+  unsigned max_age = last < buf_thr ? LOG_DATA_MAX_AGE : 0;
+  bool changed = buf_thr != m_buf_threshold || log_thr != m_log_threshold ||
+                 max_age != m_max_age;
+
+  m_buf_threshold = buf_thr;
+  m_log_threshold = log_thr;
+  m_max_age = max_age;
+
+  return changed;
+}
+
+void CommitTuner::set_data_age(const AgeHistogram& hist) {
+  if (hist.count()) {
+    m_age_p50 = hist.percentile(50);
+    m_age_p99 = hist.percentile(99);
+  }
+}
+
+unsigned CommitTuner::tick() const {
+  return m_max_age ? m_max_age / 2 : LOG_COMMIT_TUNE_PERIOD;
+}
@@ -0,0 +1,111 @@
+/*
+ *  commit_tuner.h - adapt the log commit thresholds to the log rate.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _COMMIT_TUNER_H_
+#define _COMMIT_TUNER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+/*  AgeHistogram - distribution of the log data age in milliseconds.
+ *
+ *  Bucket 0 counts the ages under 1 ms, and bucket i counts the ages
+ *  in [2^(i-1), 2^i) ms.
+ */
+class AgeHistogram {
+ public:
+  AgeHistogram() { clear(); }
+
+  void add(uint64_t age);
+  void clear();
+  uint64_t count() const { return m_count; }
+  /*  percentile - get the age under which pct percent of the samples
+   *               are.
+   *
+   *  Return the age in ms interpolated in its bucket, 0 if there is no
+   *  sample.
+   */
+  unsigned percentile(unsigned pct) const;
+
+ private:
+  static const unsigned BUCKET_NUM = 24;
+
+  uint64_t m_buckets[BUCKET_NUM];
+  uint64_t m_count;
+};
+
+/*  CommitTuner - the commit thresholds of a log stream.
+ *
+ *  The thresholds are chosen so that the log is committed about
+ *  LOG_COMMIT_AGE_TARGET ms after it's read. At low log rates they are
+ *  lowered so that the log doesn't stay in RAM for long, and at high
+ *  rates they grow up to the bounds set by the buffer geometry so that
+ *  fewer writes are made. When even the lowest thresholds can't be
+ *  reached in time, the max data age is set, and the owner shall
+ *  commit the log older than it.
+ *
+ *  The thresholds are powers of 2 (or the bounds), so that they don't
+ *  change with small variations of the rate.
+ */
+class CommitTuner {
+ public:
+  CommitTuner();
+
+  /*  set_bounds - set the upper bounds of the thresholds.
+   *
+   *  The thresholds are reset to the bounds until the next adjust().
+   */
+  void set_bounds(size_t buf_max, size_t log_max);
+  /*  account - count the bytes read in the current period.
+   */
+  void account(size_t len) { m_bytes += len; }
+  /*  adjust - choose the thresholds for the rate of the current period.
+   *  @period: length of the period in ms.
+   *
+   *  Return true if the thresholds or the max age are changed.
+   */
+  bool adjust(unsigned period);
+  /*  set_data_age - save the data age of the period.
+   */
+  void set_data_age(const AgeHistogram& hist);
+
+  size_t buf_threshold() const { return m_buf_threshold; }
+  size_t log_threshold() const { return m_log_threshold; }
+  /*  max_age - the max data age in ms, or 0 if the thresholds are
+   *            reached in time.
+   */
+  unsigned max_age() const { return m_max_age; }
+  /*  tick - interval in ms of the next check of the data age.
+   */
+  unsigned tick() const;
+  // Smoothed log rate in bytes/s
+  unsigned rate() const { return m_rate; }
+  unsigned age_p50() const { return m_age_p50; }
+  unsigned age_p99() const { return m_age_p99; }
+
+ private:
+  size_t m_buf_max;
+  size_t m_log_max;
+  // Data size to commit a buffer
+  size_t m_buf_threshold;
+  // Data size to start a write
+  size_t m_log_threshold;
+  unsigned m_max_age;
+  // Bytes read in the current period
+  uint64_t m_bytes;
+  unsigned m_rate;
+  unsigned m_age_p50;
+  unsigned m_age_p99;
+
+  /*  fit - get the threshold for want bytes.
+   */
+  static size_t fit(size_t want, size_t max);
+};
+
+#endif  // !_COMMIT_TUNER_H_
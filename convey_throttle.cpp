@@ -0,0 +1,139 @@
+/*
+ * convey_throttle.cpp - I/O rate limit of the convey work
+ *
+ * Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ * History:
+ * 2026-10-17
+ * Initial version
+ *
+ */
+
+#include <chrono>
+#include <time.h>
+
+#include "convey_throttle.h"
+#include "def_config.h"
+
+ConveyThrottle::ConveyThrottle() : interrupt_seq_{0} {
+  int64_t tnow = now_ns();
+
+  for (unsigned i = 0; i < kMediaNum; ++i) {
+    buckets_[i].rate = CONVEY_MAX_RATE;
+    buckets_[i].tokens = 0;
+    buckets_[i].last = tnow;
+  }
+
+  for (unsigned i = 0; i < ConveyUnitBase::PRIORITY_NUM; ++i) {
+    class_bytes_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+int64_t ConveyThrottle::now_ns() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<int64_t>(t.tv_sec) * 1000000000 + t.tv_nsec;
+}
+
+void ConveyThrottle::refill(Bucket& b, int64_t tnow) {
+  // At most a quarter second of tokens are saved for a burst.
+  int64_t burst = b.rate / 4;
+  // Time in ns to fill the bucket. A longer time adds no more tokens,
+  // so the product below does not overflow after a long idle time.
+  int64_t fill_time = (burst - b.tokens) * 1000000000 / b.rate;
+  int64_t elapsed = tnow - b.last;
+
+  if (elapsed >= fill_time) {
+    b.tokens = burst;
+  } else {
+    b.tokens += elapsed * b.rate / 1000000000;
+  }
+  b.last = tnow;
+}
+
+void ConveyThrottle::restart() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t tnow = now_ns();
+
+  for (unsigned i = 0; i < kMediaNum; ++i) {
+    buckets_[i].last = tnow;
+  }
+}
+
+void ConveyThrottle::consume(unsigned media, ConveyUnitBase::Priority prio,
+                             size_t len) {
+  class_bytes_[prio].fetch_add(len, std::memory_order_relaxed);
+
+  unsigned idx = bucket_index(media);
+
+  if (ConveyUnitBase::LivePath == prio || idx >= kMediaNum) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  Bucket& b = buckets_[idx];
+  unsigned seq = interrupt_seq_;
+
+  refill(b, now_ns());
+  b.tokens -= static_cast<int64_t>(len);
+  while (b.tokens < 0 && seq == interrupt_seq_) {
+    int64_t wait_ns = -b.tokens * 1000000000 / b.rate + 1;
+
+    cond_.wait_for(lock, std::chrono::nanoseconds(wait_ns));
+    refill(b, now_ns());
+  }
+}
+
+void ConveyThrottle::interrupt() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++interrupt_seq_;
+  }
+  cond_.notify_all();
+}
+
+void ConveyThrottle::adjust(unsigned media, unsigned latency) {
+  unsigned idx = bucket_index(media);
+
+  if (idx >= kMediaNum) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Bucket& b = buckets_[idx];
+    unsigned rate = b.rate;
+
+    // Take the tokens of the old rate.
+    refill(b, now_ns());
+    if (latency > CONVEY_LATENCY_BUDGET) {
+      rate /= 2;
+      if (rate < CONVEY_MIN_RATE) {
+        rate = CONVEY_MIN_RATE;
+      }
+      if (rate != b.rate) {
+        info_log("live log write latency %u ms on media %u, convey rate %u",
+                 latency, media, rate);
+      }
+    } else if (CONVEY_MAX_RATE - rate > CONVEY_RATE_STEP) {
+      rate += CONVEY_RATE_STEP;
+    } else {
+      rate = CONVEY_MAX_RATE;
+    }
+    b.rate = rate;
+  }
+  // The waiting time depends on the rate.
+  cond_.notify_all();
+}
+
+unsigned ConveyThrottle::rate(unsigned media) {
+  unsigned idx = bucket_index(media);
+
+  if (idx >= kMediaNum) {
+    return 0;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  return buckets_[idx].rate;
+}
@@ -0,0 +1,109 @@
+/*
+ * convey_throttle.h - I/O rate limit of the convey work
+ *
+ * Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ * History:
+ * 2026-10-17
+ * Initial version
+ *
+ */
+
+#ifndef _CONVEY_THROTTLE_
+#define _CONVEY_THROTTLE_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "convey_unit_base.h"
+
+/*
+ * ConveyThrottle - token buckets of the media written by convey units
+ *
+ * There is one token bucket for each media type. The work
+ * routines take tokens for the bytes they write, and wait when the
+ * bucket is in debt. The rate of a bucket is adjusted by the main
+ * thread according to the latency of the live log writes on the media,
+ * so that the convey work does not delay the live log.
+ *
+ * LivePath units are only accounted, never throttled.
+ */
+class ConveyThrottle {
+ public:
+  // Number of media types
+  static const unsigned kMediaNum = 2;
+
+  ConveyThrottle();
+  ConveyThrottle(const ConveyThrottle&) = delete;
+  ConveyThrottle& operator=(const ConveyThrottle&) = delete;
+
+  /*
+   * consume - account the bytes written and wait for the tokens
+   *
+   * @media: priority of the destination media
+   * @prio: scheduling class of the unit
+   * @len: number of bytes written
+   *
+   * This function is called by the work routines.
+   */
+  void consume(unsigned media, ConveyUnitBase::Priority prio, size_t len);
+  /*
+   * interrupt - wake up the work routines waiting for tokens
+   *
+   * The work routines return from consume() so that they can inspect
+   * the workshop events. The debt is kept.
+   */
+  void interrupt();
+  /*
+   * adjust - adapt the rate of the media to the live log write latency
+   *
+   * @media: priority of the media
+   * @latency: max live log write latency in ms of the last period
+   */
+  void adjust(unsigned media, unsigned latency);
+  /*
+   * restart - start the buckets when the convey work starts again
+   *
+   * The time without convey work adds no tokens.
+   */
+  void restart();
+
+  unsigned rate(unsigned media);
+  /*
+   * class_bytes - total bytes written by the units of the class
+   */
+  uint64_t class_bytes(ConveyUnitBase::Priority prio) const {
+    return class_bytes_[prio].load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Bucket {
+    // Bytes/s
+    unsigned rate;
+    // Available bytes, negative for debt
+    int64_t tokens;
+    // Time of the last refill in ns
+    int64_t last;
+  };
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  Bucket buckets_[kMediaNum];
+  // Increased by interrupt()
+  unsigned interrupt_seq_;
+  std::atomic<uint64_t> class_bytes_[ConveyUnitBase::PRIORITY_NUM];
+
+  void refill(Bucket& b, int64_t tnow);
+
+  /*
+   * bucket_index - get the bucket of the media
+   *
+   * @media: media storage priority, (MediaType << 8) + MediaPrior
+   */
+  static unsigned bucket_index(unsigned media) { return media >> 8; }
+  static int64_t now_ns();
+};
+
+#endif // !_CONVEY_THROTTLE_
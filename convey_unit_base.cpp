@@ -9,6 +9,7 @@
  *
  */
 
+#include "convey_throttle.h"
 #include "convey_unit_base.h"
 
 ConveyUnitBase::ConveyUnitBase(StorageManager* sm,
@@ -23,4 +24,12 @@ ConveyUnitBase::ConveyUnitBase(StorageManager* sm,
       src_priority_{src_priority},
       dest_priority_{dest_priority},
       tag_{UINT8_MAX},
-      auto_dest_{UINT_MAX == dest_priority} {}
+      auto_dest_{UINT_MAX == dest_priority},
+      priority_{Background},
+      throttle_{nullptr} {}
+
+void ConveyUnitBase::io_done(size_t len) {
+  if (throttle_) {
+    throttle_->consume(dest_priority_, priority_, len);
+  }
+}
@@ -17,6 +17,7 @@
 
 #include "cp_log_cmn.h"
 
+class ConveyThrottle;
 class StorageManager;
 
 class ConveyUnitBase {
@@ -35,6 +36,15 @@ class ConveyUnitBase {
     Done
   };
 
+  // Scheduling class of the unit. A class is served before the
+  // classes after it.
+  enum Priority {
+    LivePath,     // the live log needs it to be parsed, never throttled
+    Interactive,  // requested by the user, such as COLLECT_LOG
+    Background,   // migration and maintenance
+    PRIORITY_NUM
+  };
+
   ConveyUnitBase(StorageManager* sm, CpType type, CpClass cpclass,
                  unsigned src_priority = UINT_MAX,
                  unsigned dest_priority = UINT_MAX);
@@ -52,6 +62,11 @@ class ConveyUnitBase {
   void set_tag(uint8_t tag) { tag_ = tag; }
   uint8_t tag() const { return tag_; }
 
+  Priority priority() const { return priority_; }
+  void set_priority(Priority prio) { priority_ = prio; }
+
+  void set_throttle(ConveyThrottle* throttle) { throttle_ = throttle; }
+
   void unit_start() { state_ = OnGoing; }
   void unit_done(State state) { state_ = state; }
 
@@ -98,6 +113,17 @@ class ConveyUnitBase {
    */
   virtual bool check_dest() = 0;
 
+ protected:
+  /*
+   * io_done - account the bytes written to the destination
+   *
+   * @len: number of bytes
+   *
+   * The calling work routine may be blocked for the I/O rate limit
+   * of the destination media.
+   */
+  void io_done(size_t len);
+
  protected:
   // convey state
   State state_;
@@ -110,6 +136,9 @@ class ConveyUnitBase {
   uint8_t tag_;
   // if destination is not set initially
   bool auto_dest_;
+  Priority priority_;
+  // I/O rate limit of the work routine
+  ConveyThrottle* throttle_;
 };
 
 #endif // !_CONVEY_UNIT_BASE_
@@ -8,17 +8,32 @@
  *  Initial version.
  */
 #include <algorithm>
+#include <climits>
 #include <fcntl.h>
+#include <linux/futex.h>
 #include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
 #include "convey_workshop.h"
+#include "io_chan.h"
 #include "media_stor.h"
+#include "multiplexer.h"
 #include "rw_buffer.h"
 #include "stor_mgr.h"
 
+static void futex_wait(std::atomic<uint32_t>* word, uint32_t val) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+          FUTEX_WAIT_PRIVATE, val, nullptr, nullptr, 0);
+}
+
+static void futex_wake_all(std::atomic<uint32_t>* word) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+          FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
 ConveyWorkshop::ConveyWorkshop(LogController* log_ctrl,
                                StorageManager* stor_mgr,
                                Multiplexer* multi)
@@ -26,16 +41,28 @@ ConveyWorkshop::ConveyWorkshop(LogController* log_ctrl,
       inited_{false},
       stor_mgr_{stor_mgr},
       multi_{multi},
-      feedback_fd_{-1} {}
+      next_routine_{0},
+      new_item_seq_{0},
+      wake_seq_{0},
+      feedback_fd_{-1},
+      throttle_timer_{nullptr} {
+  for (unsigned i = 0; i < ConveyUnitBase::PRIORITY_NUM; ++i) {
+    material_num_[i].store(0, std::memory_order_relaxed);
+    period_bytes_[i] = 0;
+    class_rate_[i] = 0;
+  }
+}
 
 ConveyWorkshop::~ConveyWorkshop() {
   clear();
 
-  for (int i = 0; i != CONCURRENCY_CAPACITY; ++i) {
-    messages_[i].push(std::unique_ptr<unsigned>{
-        new unsigned(static_cast<unsigned>(Stop << 16))});
+  if (throttle_timer_) {
+    multi_->timer_mgr().del_timer(throttle_timer_);
+    throttle_timer_ = nullptr;
   }
 
+  post_event(static_cast<unsigned>(Stop << 16));
+
   for (unsigned i = 0; i != work_machines_.size(); ++i) {
     if (work_machines_[i].joinable()) {
       work_machines_[i].join();
@@ -147,6 +174,24 @@ bool ConveyWorkshop::attach_request(
       // storage media event should be notified
       stor_mgr_->subscribe_media_change_evt(this, current_media_changed);
       stor_mgr_->subscribe_stor_inactive_evt(this, media_inactive);
+
+      if (!throttle_timer_) {
+        for (int i = 0; i < StorageManager::MT_STOR_END; ++i) {
+          // Drop the latency before the convey work.
+          IoChannel* chan = stor_mgr_->created_io_channel(
+              static_cast<StorageManager::MediaType>(i));
+          if (chan) {
+            chan->take_max_latency();
+          }
+        }
+        throttle_.restart();
+        for (unsigned i = 0; i < ConveyUnitBase::PRIORITY_NUM; ++i) {
+          period_bytes_[i] = throttle_.class_bytes(
+              static_cast<ConveyUnitBase::Priority>(i));
+        }
+        throttle_timer_ = multi_->timer_mgr().create_timer(
+            CONVEY_THROTTLE_PERIOD, throttle_timer, this);
+      }
     }
 
     tag = static_cast<unsigned>(client_table_.size());
@@ -164,16 +209,12 @@ bool ConveyWorkshop::attach_request(
 
   for (auto it = cu_list.begin(); it != cu_list.end(); ++it) {
     (*it)->set_tag(tag);
-    raw_material_.push(std::move(*it));
+    push_material(std::move(*it));
     ret = true;
   }
 
   // inform the work routine to process the request
-  for (int i = 0; i != CONCURRENCY_CAPACITY; ++i) {
-    messages_[i].push(
-        std::unique_ptr<unsigned>{
-            new unsigned(static_cast<unsigned>(NewItem << 16))});
-  }
+  new_item_arrived();
 
   return ret;
 }
@@ -195,13 +236,9 @@ bool ConveyWorkshop::add_new_unit(void* client, std::unique_ptr<ConveyUnitBase>
   cu->set_tag(tag);
 
   client_table_[tag]->add_num();
-  raw_material_.push(std::move(cu));
+  push_material(std::move(cu));
   // inform the work routine to process the request
-  for (int i = 0; i != CONCURRENCY_CAPACITY; ++i) {
-    messages_[i].push(
-        std::unique_ptr<unsigned>{
-            new unsigned(static_cast<unsigned>(NewItem << 16))});
-  }
+  new_item_arrived();
 
   return true;
 }
@@ -239,11 +276,10 @@ void ConveyWorkshop::item_done(std::unique_ptr<ConveyUnitBase>& item) {
 
 void ConveyWorkshop::work_routine(unsigned index) {
   // inspect interface for synchronisation with main thread's events
-  Inspector inspect_interface = [=] (bool block) {
-    unsigned ret = None;
-    auto msg = messages_[index].get_next(block);
-    if (msg) {
-      ret = *msg;
+  uint32_t item_seq = 0;
+  Inspector inspect_interface = [=, &item_seq] (bool block) {
+    unsigned ret = next_event(index, item_seq, block);
+    if (ret != None) {
       info_log("event info 0X%x - event id: %u",
                static_cast<unsigned>(ret),
                static_cast<unsigned>(ret >> 16));
@@ -261,9 +297,10 @@ void ConveyWorkshop::work_routine(unsigned index) {
           // allocate a buffer
           RwBuffer rw_buf;
           while (run) {
-            auto material{raw_material_.get_next(false)};
+            auto material{fetch_material(index)};
             if (material) {
               info_log("has material");
+              material->set_throttle(&throttle_);
               material->unit_start();
               material->convey_method(inspect_interface,
                                       rw_buf.get_buf(),
@@ -272,7 +309,7 @@ void ConveyWorkshop::work_routine(unsigned index) {
               switch (material->state()) {
                 case ConveyUnitBase::NoWorkload:
                   // this work routine is closing, give it back to raw materials
-                  raw_material_.push(std::move(material));
+                  push_material(std::move(material), index);
                   run = false;
                   fb = static_cast<uint8_t>(WorkRoutineExit);
                   ::write(feedback_fd_, &fb, 1);
@@ -314,6 +351,145 @@ void ConveyWorkshop::work_routine(unsigned index) {
   }
 }
 
+void ConveyWorkshop::push_material(std::unique_ptr<ConveyUnitBase>&& cu,
+                                   unsigned index) {
+  ConveyUnitBase::Priority prio = cu->priority();
+
+  material_num_[prio].fetch_add(1, std::memory_order_relaxed);
+  raw_material_[index][prio].push(std::move(cu));
+}
+
+void ConveyWorkshop::push_material(std::unique_ptr<ConveyUnitBase>&& cu) {
+  push_material(std::move(cu), next_routine_);
+  next_routine_ = (next_routine_ + 1) % CONCURRENCY_CAPACITY;
+}
+
+std::unique_ptr<ConveyUnitBase> ConveyWorkshop::fetch_material(
+    unsigned index) {
+  for (unsigned prio = 0; prio < ConveyUnitBase::PRIORITY_NUM; ++prio) {
+    // Own queue first, then steal from the other work routines.
+    for (unsigned i = 0; i < CONCURRENCY_CAPACITY; ++i) {
+      unsigned routine = (index + i) % CONCURRENCY_CAPACITY;
+      auto cu = raw_material_[routine][prio].get_next(false);
+
+      if (cu) {
+        material_num_[prio].fetch_sub(1, std::memory_order_relaxed);
+        if (i) {
+          info_log("work routine %u takes unit of work routine %u",
+                   index, routine);
+        }
+        return cu;
+      }
+    }
+  }
+
+  return nullptr;
+}
+
+void ConveyWorkshop::take_all_material(ConcurrentQueue<ConveyUnitBase>& semi) {
+  for (unsigned prio = 0; prio < ConveyUnitBase::PRIORITY_NUM; ++prio) {
+    for (unsigned i = 0; i < CONCURRENCY_CAPACITY; ++i) {
+      while (true) {
+        auto cu = raw_material_[i][prio].get_next(false);
+
+        if (!cu) {
+          break;
+        }
+        material_num_[prio].fetch_sub(1, std::memory_order_relaxed);
+        semi.push(std::move(cu));
+      }
+    }
+  }
+}
+
+void ConveyWorkshop::drop_all_material() {
+  ConcurrentQueue<ConveyUnitBase> semi;
+
+  take_all_material(semi);
+}
+
+void ConveyWorkshop::throttle_timer(void* param) {
+  ConveyWorkshop* cw = static_cast<ConveyWorkshop*>(param);
+
+  cw->throttle_timer_ = nullptr;
+
+  for (int i = 0; i < StorageManager::MT_STOR_END; ++i) {
+    StorageManager::MediaType mt = static_cast<StorageManager::MediaType>(i);
+    IoChannel* chan = cw->stor_mgr_->created_io_channel(mt);
+
+    if (chan) {
+      cw->throttle_.adjust(cw->stor_mgr_->get_media_stor(mt)->priority(),
+                           chan->take_max_latency());
+    }
+  }
+
+  bool idle = cw->client_table_.empty();
+
+  for (unsigned i = 0; i < ConveyUnitBase::PRIORITY_NUM; ++i) {
+    ConveyUnitBase::Priority prio = static_cast<ConveyUnitBase::Priority>(i);
+    uint64_t bytes = cw->throttle_.class_bytes(prio);
+
+    cw->class_rate_[i] = idle ? 0 : static_cast<unsigned>(
+        (bytes - cw->period_bytes_[i]) * 1000 / CONVEY_THROTTLE_PERIOD);
+    cw->period_bytes_[i] = bytes;
+  }
+
+  if (!idle) {
+    cw->throttle_timer_ = cw->multi_->timer_mgr().create_timer(
+        CONVEY_THROTTLE_PERIOD, throttle_timer, param);
+  }
+}
+
+void ConveyWorkshop::wake_all() {
+  wake_seq_.fetch_add(1, std::memory_order_release);
+  futex_wake_all(&wake_seq_);
+}
+
+void ConveyWorkshop::post_event(unsigned event) {
+  for (int i = 0; i != CONCURRENCY_CAPACITY; ++i) {
+    // The queue is only full when the work routine is busy, let it
+    // consume the events.
+    while (!messages_[i].push(event)) {
+      wake_all();
+      std::this_thread::yield();
+    }
+  }
+  wake_all();
+  // Let the work routines waiting for I/O tokens check the event.
+  throttle_.interrupt();
+}
+
+void ConveyWorkshop::new_item_arrived() {
+  new_item_seq_.fetch_add(1, std::memory_order_release);
+  wake_all();
+}
+
+unsigned ConveyWorkshop::next_event(unsigned index, uint32_t& item_seq,
+                                    bool block) {
+  while (true) {
+    // Read the futex word before checking for events, so the wakeup
+    // of an event posted after the check is not lost.
+    uint32_t wake = wake_seq_.load(std::memory_order_acquire);
+    unsigned event;
+
+    if (messages_[index].pop(event)) {
+      return event;
+    }
+
+    uint32_t seq = new_item_seq_.load(std::memory_order_acquire);
+    if (seq != item_seq) {
+      item_seq = seq;
+      return static_cast<unsigned>(NewItem << 16);
+    }
+
+    if (!block) {
+      return None;
+    }
+
+    futex_wait(&wake_seq_, wake);
+  }
+}
+
 void ConveyWorkshop::current_media_changed(void* client) {
   ConveyWorkshop* cw = static_cast<ConveyWorkshop*>(client);
 
@@ -326,14 +502,11 @@ void ConveyWorkshop::current_media_changed(void* client) {
   unsigned cur_priority = cur_media->priority();
   // move the original raw material queue to a tmp queue for preparation check
   // which will leave the raw material queue empty, thus block the work routines
-  ConcurrentQueue<ConveyUnitBase> semi_material(std::move(cw->raw_material_));
+  ConcurrentQueue<ConveyUnitBase> semi_material;
+  cw->take_all_material(semi_material);
   // inform the media change event
-  for (int i = 0; i != CONCURRENCY_CAPACITY; ++i) {
-    (cw->messages_)[i].push(
-        std::unique_ptr<unsigned>{
-            new unsigned(static_cast<unsigned>(CommonDestChange << 16) +
-                         cur_priority)});
-  }
+  cw->post_event(static_cast<unsigned>(CommonDestChange << 16) +
+                 cur_priority);
 
   // check for the pending raw material
   while (1) {
@@ -348,7 +521,7 @@ void ConveyWorkshop::current_media_changed(void* client) {
 
         cw->item_done(cu_next);
       } else {
-        cw->raw_material_.push(std::move(cu_next));
+        cw->push_material(std::move(cu_next));
       }
     } else {
       break;
@@ -359,13 +532,10 @@ void ConveyWorkshop::current_media_changed(void* client) {
 void ConveyWorkshop::media_inactive(void* client, unsigned priority) {
   ConveyWorkshop* cw = static_cast<ConveyWorkshop*>(client);
   // same as media change event
-  auto semi_material(std::move(cw->raw_material_));
+  ConcurrentQueue<ConveyUnitBase> semi_material;
+  cw->take_all_material(semi_material);
   // inform the media vanish event with correspond media priority
-  for (int i = 0; i != CONCURRENCY_CAPACITY; ++i) {
-    (cw->messages_)[i].push(
-        std::unique_ptr<unsigned>{
-            new unsigned(static_cast<unsigned>(Vanish << 16) + priority)});
-  }
+  cw->post_event(static_cast<unsigned>(Vanish << 16) + priority);
 
   while (1) {
     auto cu_next = semi_material.get_next(false);
@@ -383,7 +553,7 @@ void ConveyWorkshop::media_inactive(void* client, unsigned priority) {
 
         cw->item_done(cu_next);
       } else {
-        cw->raw_material_.push(std::move(cu_next));
+        cw->push_material(std::move(cu_next));
       }
     } else {
       break;
@@ -397,14 +567,12 @@ void ConveyWorkshop::clear() {
   }
 
   // clear all the material
-  raw_material_.clear();
+  drop_all_material();
 
-  int i = 0;
   // inform the work routine
-  for (i = 0; i != CONCURRENCY_CAPACITY; ++i) {
-    messages_[i].push(std::unique_ptr<unsigned>{
-        new unsigned(static_cast<unsigned>(Clean << 16))});
-  }
+  post_event(static_cast<unsigned>(Clean << 16));
+
+  int i = CONCURRENCY_CAPACITY;
 
   struct pollfd rsp_pol;
   int err = 0;
@@ -449,15 +617,12 @@ void ConveyWorkshop::cancel_client(void* client) {
     return;
   }
 
-  auto current_raw(std::move(raw_material_));
+  ConcurrentQueue<ConveyUnitBase> current_raw;
+  take_all_material(current_raw);
 
   uint8_t tag = static_cast<uint8_t>(client_it - client_table_.begin());
   // inform the work routine to cancel the correspond unit
-  for (int i = 0; i != CONCURRENCY_CAPACITY; ++i) {
-    messages_[i].push(
-        std::unique_ptr<unsigned>{
-            new unsigned(static_cast<unsigned>(Cancel << 16) + tag)});
-  }
+  post_event(static_cast<unsigned>(Cancel << 16) + tag);
 
   (*client_it)->client_ptr = nullptr;
   (*client_it)->client_callback = nullptr;
@@ -470,7 +635,7 @@ void ConveyWorkshop::cancel_client(void* client) {
         continue;
       }
 
-      raw_material_.push(std::move(cu_next));
+      push_material(std::move(cu_next));
     } else {
       break;
     }
@@ -11,13 +11,18 @@
 #ifndef _CONVEY_WORKSHOP_
 #define _CONVEY_WORKSHOP_
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <thread>
 
+#include "convey_throttle.h"
 #include "convey_unit_base.h"
 #include "def_config.h"
 #include "fd_hdl.h"
 #include "concurrent_queue.h"
+#include "mpmc_queue.h"
+#include "timer_mgr.h"
 
 class LogController;
 class Multiplexer;
@@ -72,6 +77,23 @@ class ConveyWorkshop : public FdHandler {
 
   void cancel_client(void* client);
   void clear();
+  /*
+   * material_num - number of units waiting for a work routine
+   *
+   * @prio: scheduling class
+   */
+  unsigned material_num(ConveyUnitBase::Priority prio) const {
+    return material_num_[prio].load(std::memory_order_relaxed);
+  }
+  /*
+   * class_rate - bytes/s written by the units of the class in the last
+   *              throttle period
+   *
+   * @prio: scheduling class
+   */
+  unsigned class_rate(ConveyUnitBase::Priority prio) const {
+    return class_rate_[prio];
+  }
 
  private:
   /*
@@ -82,13 +104,65 @@ class ConveyWorkshop : public FdHandler {
   void work_routine(unsigned index);
 
   void item_done(std::unique_ptr<ConveyUnitBase>& item);
+  /*
+   * push_material - queue a unit to the work routine
+   *
+   * @cu: the unit
+   * @index: index of the work routine
+   */
+  void push_material(std::unique_ptr<ConveyUnitBase>&& cu, unsigned index);
+  /*
+   * push_material - queue a unit to the work routines in turn
+   *
+   * @cu: the unit
+   */
+  void push_material(std::unique_ptr<ConveyUnitBase>&& cu);
+  /*
+   * fetch_material - get the next unit for the work routine
+   *
+   * @index: index of the work routine
+   *
+   * The unit of the highest scheduling class is returned. Units of
+   * other work routines are taken when the work routine's own queue
+   * of the class is empty.
+   */
+  std::unique_ptr<ConveyUnitBase> fetch_material(unsigned index);
+  /*
+   * take_all_material - move all queued units to semi
+   */
+  void take_all_material(ConcurrentQueue<ConveyUnitBase>& semi);
+  void drop_all_material();
+  /*
+   * post_event - send the event to all work routines
+   *
+   * @event: (InspectEvent << 16) + parameter
+   */
+  void post_event(unsigned event);
+  /*
+   * new_item_arrived - wake up all work routines for new raw material
+   */
+  void new_item_arrived();
+  /*
+   * next_event - get the next event of the work routine
+   *
+   * @index: index of message queue
+   * @item_seq: the last new item sequence seen by the work routine
+   * @block: whether to wait for an event
+   *
+   * Return Value:
+   *  The event, or None if block is false and there is no event.
+   */
+  unsigned next_event(unsigned index, uint32_t& item_seq, bool block);
+  void wake_all();
 
   static void current_media_changed(void* client);
   static void media_inactive(void* client, unsigned priority);
+  static void throttle_timer(void* param);
 
  private:
   using Inspector = std::function<unsigned(bool)>;
-  using MsgQueue = ConcurrentQueue<unsigned>;
+  // Control events only. New raw material is notified by new_item_seq_.
+  using MsgQueue = MpmcQueue<unsigned, 32>;
 
   enum WorkFeedback {
     ItemFinish,
@@ -124,15 +198,32 @@ class ConveyWorkshop : public FdHandler {
   bool inited_;
   StorageManager* stor_mgr_;
   Multiplexer* multi_;
-  // raw material queue contains items to be processed
-  ConcurrentQueue<ConveyUnitBase> raw_material_;
+  // raw material queues contain items to be processed, one for each
+  // scheduling class of each work routine
+  ConcurrentQueue<ConveyUnitBase>
+      raw_material_[CONCURRENCY_CAPACITY][ConveyUnitBase::PRIORITY_NUM];
+  // number of raw material items of each class
+  std::atomic<unsigned> material_num_[ConveyUnitBase::PRIORITY_NUM];
+  // work routine to queue the next raw material to
+  unsigned next_routine_;
   // products contains finished items
   ConcurrentQueue<ConveyUnitBase> products_;
   // work loads
   LogVector<std::thread> work_machines_;
   MsgQueue messages_[CONCURRENCY_CAPACITY];
+  // Increased on every raw material push
+  std::atomic<uint32_t> new_item_seq_;
+  // Futex word the idle work routines wait on, increased on every event
+  std::atomic<uint32_t> wake_seq_;
   int feedback_fd_;
   LogVector<std::unique_ptr<ConveyClient>> client_table_;
+  // I/O rate limit of the work routines
+  ConveyThrottle throttle_;
+  TimerManager::TimerHandle throttle_timer_;
+  // class bytes at the start of the throttle period
+  uint64_t period_bytes_[ConveyUnitBase::PRIORITY_NUM];
+  // bytes/s of the classes in the last throttle period
+  unsigned class_rate_[ConveyUnitBase::PRIORITY_NUM];
 };
 
 #endif // !_CONVEY_WORKSHOP_
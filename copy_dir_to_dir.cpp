@@ -8,6 +8,7 @@
  * Initial version
  *
  */
+#include <cerrno>
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
@@ -137,6 +138,11 @@ void CopyDirToDirUnit::clear_result() {
   }
 }
 
+bool CopyDirToDirUnit::convey_by_rename(const LogString& /*src_file_path*/,
+                                        std::unique_ptr<LogFile>& /*lf*/) {
+  return false;
+}
+
 void CopyDirToDirUnit::convey_method(std::function<unsigned(bool)> inspector,
                                      uint8_t* const buf,
                                      size_t buf_size) {
@@ -163,13 +169,19 @@ void CopyDirToDirUnit::convey_method(std::function<unsigned(bool)> inspector,
       continue;
     }
 
+    LogString src_file_path = src_->path() + "/" + *base_name;
+    info_log("src file: %s", ls2cstring(src_file_path));
+
+    if (convey_by_rename(src_file_path, lf)) {
+      ++dest_count;
+      continue;
+    }
+
     if (lf->create()) {
       err_log("fail to create file: %s", ls2cstring(lf->base_name()));
       continue;
     }
 
-    LogString src_file_path = src_->path() + "/" + *base_name;
-    info_log("src file: %s", ls2cstring(src_file_path));
     int fd_src = ::open(ls2cstring(src_file_path), O_RDONLY);
     if (fd_src < 0) {
       lf->remove(lf->dir()->path());
@@ -177,12 +189,30 @@ void CopyDirToDirUnit::convey_method(std::function<unsigned(bool)> inspector,
       continue;
     }
 
-    while (no_evt) {
-      ssize_t n = read(fd_src, buf, buf_size);
+    // Copy in the kernel until copy_file_range() is found not to
+    // work between the file systems.
+    bool in_kernel = true;
 
-      if (n < 0) {
-        err_log("fail to read %s", ls2cstring(lf->base_name()));
-        break;
+    while (no_evt) {
+      ssize_t n;
+
+      if (in_kernel) {
+        n = lf->copy_range(fd_src, kCopyRangeSize);
+        if (n < 0) {
+          if (EXDEV != errno && EINVAL != errno && ENOSYS != errno &&
+              EOPNOTSUPP != errno) {
+            err_log("fail to copy %s", ls2cstring(lf->base_name()));
+            break;
+          }
+          in_kernel = false;
+          continue;
+        }
+      } else {
+        n = read(fd_src, buf, buf_size);
+        if (n < 0) {
+          err_log("fail to read %s", ls2cstring(lf->base_name()));
+          break;
+        }
       }
 
       if (!n) {  // End of file
@@ -192,11 +222,14 @@ void CopyDirToDirUnit::convey_method(std::function<unsigned(bool)> inspector,
         break;
       }
 
-      // thread unsafe file write
-      ssize_t nwr = lf->write_raw(buf, n);
-      if (nwr != n) {
-        break;
+      if (!in_kernel) {
+        // thread unsafe file write
+        ssize_t nwr = lf->write_raw(buf, n);
+        if (nwr != n) {
+          break;
+        }
       }
+      io_done(n);
 
       // inspect event
       no_evt = inspect_event_check(inspector(false));
@@ -11,6 +11,8 @@
 #ifndef _COPY_DIR_TO_DIR_
 #define _COPY_DIR_TO_DIR_
 
+#include <memory>
+
 #include "convey_unit.h"
 #include "cp_log_cmn.h"
 #include "concurrent_queue.h"
@@ -39,6 +41,24 @@ class CopyDirToDirUnit : public ConveyUnit<CpDirectory, CpDirectory> {
   void clear_result() override;
 
  protected:
+  /*
+   * convey_by_rename - convey a source file without copying the data
+   *
+   * @src_file_path: path of the source file
+   * @lf: the destination file, which does not exist
+   *
+   * This function is called in the work routine.
+   *
+   * Return Value:
+   *  True if the file is conveyed, false if the file shall be copied.
+   */
+  virtual bool convey_by_rename(const LogString& src_file_path,
+                                std::unique_ptr<LogFile>& lf);
+
+ protected:
+  // Max bytes copied by one copy_file_range() between event inspections
+  static const size_t kCopyRangeSize = 1024 * 1024;
+
   ConcurrentQueue<LogFile> copied_dest_files_;
   ConcurrentQueue<LogString> src_base_names_;
 };
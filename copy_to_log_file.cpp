@@ -184,6 +184,7 @@ void CopyToLogFile::convey_method(std::function<unsigned(bool)> inspector,
     }
 
     size_written += nwr;
+    io_done(nwr);
 
     // inspect event
     if (!inspect_event_check(inspector(false))) {
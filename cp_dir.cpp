@@ -9,6 +9,7 @@
  */
 #include <algorithm>
 #include <dirent.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <stdlib.h>
@@ -18,6 +19,7 @@
 #include "cp_set_dir.h"
 #include "def_config.h"
 #include "log_file.h"
+#include "log_index.h"
 #include "media_stor.h"
 #include "stor_mgr.h"
 
@@ -27,12 +29,26 @@ CpDirectory::CpDirectory(CpSetDirectory* par_dir, CpType ct,
       m_ct{ct},
       m_path(dir),
       m_size{},
+      m_evict_group{},
       m_log_watch{},
-      m_store_full{} {}
+      m_set_watch{},
+      m_store_full{} {
+  MediaStorage* ms = par_dir ? par_dir->get_media() : nullptr;
+
+  if (ms) {
+    m_evict_group = ms->evict_index().group(par_dir->cp_class(), ct);
+  }
+}
 
 CpDirectory::~CpDirectory() {
-  // TODO: cancel file watch
-  // cancel_watch();
+  cancel_watch();
+
+  if (m_evict_group) {
+    for (auto& f : m_log_files) {
+      EvictionIndex::remove_file(m_evict_group, f.get());
+    }
+    m_evict_group->size -= m_size;
+  }
 }
 
 int CpDirectory::stat() {
@@ -61,31 +77,150 @@ int CpDirectory::stat() {
           std::make_shared<LogFile>(LogString(dent->d_name), this,
                                     LogFile::LT_UNKNOWN, file_stat.st_size);
       log->get_type();
-      insert_ascending(m_log_files, std::move(log));
-      m_size += file_stat.st_size;
+      insert_file(std::move(log), true);
+      size_added(file_stat.st_size);
     }
   }
 
   closedir(pd);
 
+  remove_orphan_indexes();
+
   return 0;
 }
 
-void CpDirectory::insert_ascending(LogList<std::shared_ptr<LogFile>>& lst,
-                                   std::shared_ptr<LogFile>&& f) {
-  LogList<std::shared_ptr<LogFile>>::iterator it;
-  for (it = lst.begin(); it != lst.end(); ++it) {
-    std::shared_ptr<LogFile>& p = *it;
-    if (*f <= *p) {
+void CpDirectory::remove_orphan_indexes() {
+  auto it = m_log_files.begin();
+
+  while (it != m_log_files.end()) {
+    LogFile* f = it->get();
+
+    if (LogFile::LT_LOG_INDEX != f->type()) {
+      ++it;
+      continue;
+    }
+
+    // The name of the log file is the name of the index without ".idx".
+    LogString log_name;
+    str_assign(log_name, ls2cstring(f->base_name()),
+               f->base_name().length() - 4);
+
+    if (find_name(f->file_time(), log_name) != m_log_files.end() ||
+        discard_file(f)) {
+      ++it;
+      continue;
+    }
+
+    info_log("remove orphan index %s", ls2cstring(f->base_name()));
+    size_removed(f->size());
+    it = erase_file(it);
+  }
+}
+
+void CpDirectory::insert_file(std::shared_ptr<LogFile>&& f,
+                              bool ascending) {
+  FileIter pos = m_log_files.end();
+
+  if (ascending) {
+    // Before the first file not older than f
+    auto it = m_time_index.lower_bound(f->file_time());
+    if (it != m_time_index.end()) {
+      pos = it->second;
+    }
+  }
+
+  LogFile* lf = f.get();
+  FileIter it = m_log_files.insert(pos, std::move(f));
+
+  m_time_index.insert(std::make_pair(lf->file_time(), it));
+  // Index files are evicted with their log files.
+  if (m_evict_group && lf->overwritable() &&
+      LogFile::LT_LOG_INDEX != lf->type()) {
+    EvictionIndex::add_file(m_evict_group, lf);
+  }
+}
+
+CpDirectory::FileIter CpDirectory::erase_file(FileIter it) {
+  LogFile* lf = it->get();
+  auto range = m_time_index.equal_range(lf->file_time());
+
+  for (auto i = range.first; i != range.second; ++i) {
+    if (i->second == it) {
+      m_time_index.erase(i);
       break;
     }
   }
-  lst.insert(it, f);
+  if (m_evict_group) {
+    EvictionIndex::remove_file(m_evict_group, lf);
+  }
+
+  return m_log_files.erase(it);
+}
+
+CpDirectory::FileIter CpDirectory::find_file(const LogFile* f) {
+  auto range = m_time_index.equal_range(f->file_time());
+
+  for (auto i = range.first; i != range.second; ++i) {
+    if (i->second->get() == f) {
+      return i->second;
+    }
+  }
+
+  return m_log_files.end();
+}
+
+CpDirectory::FileIter CpDirectory::find_name(const LogFile::FileTime& t,
+                                             const LogString& name) {
+  auto range = m_time_index.equal_range(t);
+
+  for (auto i = range.first; i != range.second; ++i) {
+    if ((*i->second)->base_name() == name) {
+      return i->second;
+    }
+  }
+
+  return m_log_files.end();
+}
+
+uint64_t CpDirectory::discard_index(const LogFile* lf) {
+  if (LogFile::LT_LOG != lf->type()) {
+    return 0;
+  }
+
+  auto it = find_name(lf->file_time(), LogIndex::index_name(lf->base_name()));
+  if (it == m_log_files.end()) {
+    return 0;
+  }
+
+  LogFile* f = it->get();
+  if (discard_file(f)) {
+    err_log("delete %s error", ls2cstring(f->base_name()));
+    return 0;
+  }
+
+  uint64_t size = f->size();
+  erase_file(it);
+
+  return size;
+}
+
+void CpDirectory::size_added(uint64_t len) {
+  m_size += len;
+  if (m_evict_group) {
+    m_evict_group->size += len;
+  }
+}
+
+void CpDirectory::size_removed(uint64_t len) {
+  m_size -= len;
+  if (m_evict_group) {
+    m_evict_group->size -= len;
+  }
 }
 
 void CpDirectory::add_log_file(LogFile* lf) {
   add_size(lf->size());
-  insert_ascending(m_log_files, std::shared_ptr<LogFile>(lf));
+  insert_file(std::shared_ptr<LogFile>(lf), true);
 }
 
 int CpDirectory::create() {
@@ -133,25 +268,16 @@ const char* CpDirectory::type_to_cp_name(CpType ct) {
   return name;
 }
 
-std::weak_ptr<LogFile> CpDirectory::create_log_file(int flags) {
-  if (CLASS_MIX == m_cp_set_dir->cp_class()) {
-    if (false == trim_log_file_num(MIX_FILE_MAX_NUM)) {
-      err_log("fail to limit the number of log files to %d",
-              MIX_FILE_MAX_NUM);
-      return std::weak_ptr<LogFile>();
-    }
-  }
-
+LogString CpDirectory::next_log_name(struct tm& lt) {
   time_t t = time(0);
-  struct tm lt;
 
   if (static_cast<time_t>(-1) == t || !localtime_r(&t, &lt)) {
-    return std::weak_ptr<LogFile>();
+    return LogString();
   }
 
   const char* name = type_to_cp_name(m_ct);
   if (!name) {
-    return std::weak_ptr<LogFile>();
+    return LogString();
   }
 
   char s[64];
@@ -159,13 +285,55 @@ std::weak_ptr<LogFile> CpDirectory::create_log_file(int flags) {
            name, lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
            lt.tm_hour, lt.tm_min, lt.tm_sec);
 
-  std::shared_ptr<LogFile> log_file(new LogFile(LogString(s), this, lt));
+  return LogString(s);
+}
+
+std::weak_ptr<LogFile> CpDirectory::adopt_log_file(const LogString& name,
+                                                   const struct tm& lt,
+                                                   int fd,
+                                                   size_t prealloc_size) {
+  if (CLASS_MIX == m_cp_set_dir->cp_class()) {
+    if (false == trim_log_file_num(MIX_FILE_MAX_NUM)) {
+      err_log("fail to limit the number of log files to %d",
+              MIX_FILE_MAX_NUM);
+      ::close(fd);
+      return std::weak_ptr<LogFile>();
+    }
+  }
+
+  std::shared_ptr<LogFile> log_file(new LogFile(name, this, lt));
+  if (log_file->adopt(fd, prealloc_size)) {
+    ::close(fd);
+    return std::weak_ptr<LogFile>();
+  }
+
+  m_cur_log = log_file;
+  insert_file(std::shared_ptr<LogFile>(log_file), false);
+  watch_log(log_file.get());
+
+  return log_file;
+}
+
+std::weak_ptr<LogFile> CpDirectory::create_log_file(int flags) {
+  if (CLASS_MIX == m_cp_set_dir->cp_class()) {
+    if (false == trim_log_file_num(MIX_FILE_MAX_NUM)) {
+      err_log("fail to limit the number of log files to %d",
+              MIX_FILE_MAX_NUM);
+      return std::weak_ptr<LogFile>();
+    }
+  }
+
+  struct tm lt;
+  LogString name = next_log_name(lt);
+  if (str_empty(name)) {
+    return std::weak_ptr<LogFile>();
+  }
+
+  std::shared_ptr<LogFile> log_file(new LogFile(name, this, lt));
   if (0 == log_file->create(flags)) {
-    m_log_files.push_back(log_file);
     m_cur_log = log_file;
-    // TODO: Watch the current log
-    // FileWatcher* fw = cp_set_dir()->get_media()->file_watcher();
-    // fw->add(this, log_delete_notify, s, m_log_watch);
+    insert_file(std::shared_ptr<LogFile>(log_file), false);
+    watch_log(log_file.get());
   }
 
   return log_file;
@@ -178,28 +346,30 @@ int CpDirectory::close_log_file() {
     } catch(...) {
       err_log("current_log->close");
     }
+    current_log->watch_existence(false);
     m_cur_log.reset();
   }
-  // TODO: Cancel file watch
-  // cancel_watch();
+  cancel_watch();
   return 0;
 }
 
 void CpDirectory::add_size(size_t len) {
-  m_size += len;
+  size_added(len);
   m_cp_set_dir->add_size(len);
 }
 
 void CpDirectory::dec_size(size_t len) {
-  m_size -= len;
+  size_removed(len);
   m_cp_set_dir->dec_size(len);
 }
 
 void CpDirectory::stop() {
   if (auto current_log = m_cur_log.lock()) {
     current_log->close();
+    current_log->watch_existence(false);
     m_cur_log.reset();
   }
+  cancel_watch();
 }
 
 int CpDirectory::remove() {
@@ -217,7 +387,7 @@ int CpDirectory::remove() {
       ++it;
     } else {
       dec_size(lf->size());
-      it = m_log_files.erase(it);
+      it = erase_file(it);
     }
   }
 
@@ -235,6 +405,16 @@ int CpDirectory::remove() {
   return ret;
 }
 
+int CpDirectory::discard_file(LogFile* f) {
+  MediaStorage* ms = m_cp_set_dir->get_media();
+
+  if (ms && !ms->trash(m_path + "/" + f->base_name(), f->size())) {
+    return 0;
+  }
+
+  return f->remove(m_path);
+}
+
 bool CpDirectory::trim_log_file_num(unsigned num) {
   bool ret = true;
 
@@ -252,14 +432,14 @@ bool CpDirectory::trim_log_file_num(unsigned num) {
   // check if older log file exist, if true, delete it.
   for (auto id = m_log_files.begin(); id != it; ) {
     auto& lf = *id;
-    if (lf->overwritable()) {
-      if (lf->remove(m_path)) {
+    if (lf->overwritable() && LogFile::LT_LOG_INDEX != lf->type()) {
+      if (discard_file(lf.get())) {
         ret = false;
         err_log("delete %s error", ls2cstring(lf->base_name()));
         ++id;
       } else {
-        m_size -= lf->size();
-        id = m_log_files.erase(id);
+        size_removed(lf->size() + discard_index(lf.get()));
+        id = erase_file(id);
       }
     } else {
       ++id;
@@ -294,42 +474,57 @@ void CpDirectory::rm_oldest_log_file() {
   auto it = m_log_files.begin();
   while (it != m_log_files.end()) {
     auto& f = *it;
-    if (!f->overwritable()) {
+    if (!f->overwritable() || LogFile::LT_LOG_INDEX == f->type()) {
       ++it;
       continue;
     }
 
-    if (f->remove(m_path)) {
+    if (discard_file(f.get())) {
       err_log("delete %s error", ls2cstring(f->base_name()));
       ++it;
     } else {
       info_log("delete %s ok", ls2cstring(f->base_name()));
-      m_size -= f->size();
-      it = m_log_files.erase(it);
+      size_removed(f->size() + discard_index(f.get()));
+      it = erase_file(it);
       break;
     }
   }
 }
 
 int CpDirectory::remove(std::shared_ptr<LogFile>& rmf) {
-  int ret = -1;
-  auto it = m_log_files.begin();
+  auto it = find_file(rmf.get());
 
-  while (it != m_log_files.end()) {
-    auto& f = *it;
-    if (rmf == f) {
-      f->remove(m_path);
-      info_log("remove log file %s",ls2cstring(m_path));
-      dec_size(f->size());
-      it = m_log_files.erase(it);
-      ret = 0;
-      break;
-    } else {
-      ++it;
-    }
+  if (it == m_log_files.end()) {
+    return -1;
   }
 
-  return ret;
+  auto& f = *it;
+  f->remove(m_path);
+  info_log("remove log file %s",ls2cstring(m_path));
+  dec_size(f->size());
+  erase_file(it);
+
+  return 0;
+}
+
+int CpDirectory::evict(LogFile* f) {
+  auto it = find_file(f);
+
+  if (it == m_log_files.end()) {
+    err_log("%s not in %s", ls2cstring(f->base_name()), ls2cstring(m_path));
+    return -1;
+  }
+
+  if (discard_file(f)) {
+    err_log("delete %s error", ls2cstring(f->base_name()));
+    return -1;
+  }
+
+  info_log("delete %s ok", ls2cstring(f->base_name()));
+  dec_size(f->size() + discard_index(f));
+  erase_file(it);
+
+  return 0;
 }
 
 int CpDirectory::remove(const LogString& base_name) {
@@ -348,7 +543,7 @@ int CpDirectory::remove(const LogString& base_name) {
   f->remove(m_path);
   info_log("remove log file %s",ls2cstring(m_path));
   dec_size(f->size());
-  m_log_files.erase(lf_it);
+  erase_file(lf_it);
 
   return 0;
 }
@@ -359,18 +554,19 @@ uint64_t CpDirectory::trim(uint64_t sz) {
 
   while (it != m_log_files.end()) {
     auto& f = *it;
-    if (!f->overwritable()) {
+    if (!f->overwritable() || LogFile::LT_LOG_INDEX == f->type()) {
       ++it;
       continue;
     }
 
-    if (f->remove(m_path)) {
+    if (discard_file(f.get())) {
       err_log("delete %s error", ls2cstring(f->base_name()));
       break;
     }
 
-    uint64_t dec_size = static_cast<uint64_t>(f->size());
-    it = m_log_files.erase(it);
+    uint64_t dec_size = static_cast<uint64_t>(f->size()) +
+                        discard_index(f.get());
+    it = erase_file(it);
 
     total_dec += dec_size;
     if (dec_size >= sz) {
@@ -379,7 +575,7 @@ uint64_t CpDirectory::trim(uint64_t sz) {
     sz -= dec_size;
   }
 
-  m_size -= total_dec;
+  size_removed(total_dec);
 
   return total_dec;
 }
@@ -390,7 +586,7 @@ std::weak_ptr<LogFile> CpDirectory::create_file(const LogString& fname,
   std::shared_ptr<LogFile> log_file{new LogFile(fname, this, t)};
 
   if (!log_file->create(flags)) {
-    m_log_files.push_back(log_file);
+    insert_file(std::shared_ptr<LogFile>(log_file), false);
   } else {
     log_file.reset();
   }
@@ -398,40 +594,107 @@ std::weak_ptr<LogFile> CpDirectory::create_file(const LogString& fname,
   return log_file;
 }
 
+std::weak_ptr<LogFile> CpDirectory::create_index_file(const LogFile* lf) {
+  LogString name = LogIndex::index_name(lf->base_name());
+
+  // A stale index of the same name is overwritten.
+  auto it = find_name(lf->file_time(), name);
+  if (it != m_log_files.end()) {
+    dec_size((*it)->size());
+    erase_file(it);
+  }
+
+  std::shared_ptr<LogFile> f{new LogFile(name, this,
+                                         LogFile::LT_LOG_INDEX)};
+  // Get the file time from the name.
+  f->get_type();
+  if (f->create(O_TRUNC)) {
+    err_log("create %s error", ls2cstring(name));
+    return std::weak_ptr<LogFile>();
+  }
+  insert_file(std::shared_ptr<LogFile>(f), false);
+
+  return f;
+}
+
+void CpDirectory::watch_log(LogFile* lf) {
+  cancel_watch();
+
+  MediaStorage* ms = m_cp_set_dir->get_media();
+  FileWatcher* fw = ms ? ms->file_watcher() : nullptr;
+  if (!fw) {
+    return;
+  }
+
+  if (fw->add(this, log_delete_notify, m_path, m_log_watch,
+              IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF)) {
+    err_log("watch %s error", ls2cstring(m_path));
+    return;
+  }
+  if (fw->add(this, set_delete_notify, m_cp_set_dir->path(), m_set_watch,
+              IN_DELETE_SELF | IN_MOVE_SELF)) {
+    err_log("watch %s error", ls2cstring(m_cp_set_dir->path()));
+    cancel_watch();
+    return;
+  }
+
+  lf->watch_existence(true);
+}
+
 void CpDirectory::cancel_watch() {
-  if (m_log_watch) {
+  if (m_log_watch || m_set_watch) {
     FileWatcher* fw = cp_set_dir()->get_media()->file_watcher();
     if (fw) {
-      fw->del(m_log_watch);
+      if (m_log_watch) {
+        fw->del(m_log_watch);
+      }
+      if (m_set_watch) {
+        fw->del(m_set_watch);
+      }
     }
     m_log_watch = 0;
+    m_set_watch = 0;
   }
 }
 
-void CpDirectory::log_delete_notify(void* client, uint32_t evt) {
+void CpDirectory::log_delete_notify(void* client, uint32_t evt,
+                                    const char* name) {
   CpDirectory* cp_dir = static_cast<CpDirectory*>(client);
+  auto current_log = cp_dir->m_cur_log.lock();
+
+  // The current log is recreated on the next size update.
+  if (current_log) {
+    if (evt & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+      current_log->vanished();
+    } else if (name && current_log->base_name() == name) {
+      current_log->vanished();
+    }
+  }
 
-  if ((evt & IN_DELETE_SELF) && cp_dir->m_log_watch) {
-    // TODO: inform the StorageManager
-    // cp_dir->cp_set_dir()->get_media()->stor_mgr()->
-    cp_dir->close_log_file();
+  if (evt & IN_IGNORED) {
+    cp_dir->m_log_watch = 0;
   }
 }
 
-void CpDirectory::file_removed(LogFile* f) {
-  bool found = false;
+void CpDirectory::set_delete_notify(void* client, uint32_t evt,
+                                    const char* /*name*/) {
+  CpDirectory* cp_dir = static_cast<CpDirectory*>(client);
 
-  for (auto it = m_log_files.begin(); it != m_log_files.end(); ++it) {
-    auto& pf = *it;
-    if (f == pf.get()) {
-      m_log_files.erase(it);
-      found = true;
-      break;
-    }
+  if (auto current_log = cp_dir->m_cur_log.lock()) {
+    current_log->vanished();
   }
 
-  if (found) {
-    m_size -= f->size();
+  if (evt & IN_IGNORED) {
+    cp_dir->m_set_watch = 0;
+  }
+}
+
+void CpDirectory::file_removed(LogFile* f) {
+  auto it = find_file(f);
+
+  if (it != m_log_files.end()) {
+    size_removed(f->size() + discard_index(f));
+    erase_file(it);
   } else {
     err_log("log %s does not exist in dir %s", ls2cstring(f->base_name()),
             ls2cstring(m_path));
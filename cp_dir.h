@@ -10,9 +10,11 @@
 #ifndef _CP_DIR_H_
 #define _CP_DIR_H_
 
+#include <map>
 #include <memory>
 
 #include "cp_log_cmn.h"
+#include "evict_index.h"
 #include "log_file.h"
 #include "file_watcher.h"
 
@@ -72,6 +74,26 @@ class CpDirectory {
    *  Return LogFile pointer on success, 0 on failure.
    */
   std::weak_ptr<LogFile> create_log_file(int flags = 0);
+  /*  next_log_name - get the name of a log file created now.
+   *  @lt: the local time in the name.
+   *
+   *  Return the base name on success, an empty string on failure.
+   */
+  LogString next_log_name(struct tm& lt);
+  /*  adopt_log_file - make the file opened in the background the current
+   *                   log file.
+   *  @name: the base name returned by next_log_name().
+   *  @lt: the local time in the name.
+   *  @fd: the opened file.
+   *  @prealloc_size: the disk space reserved for the file.
+   *
+   *  On failure fd is closed.
+   *
+   *  Return LogFile pointer on success, empty pointer on failure.
+   */
+  std::weak_ptr<LogFile> adopt_log_file(const LogString& name,
+                                        const struct tm& lt, int fd,
+                                        size_t prealloc_size);
   /*  close_log_file - close current log file.
    *
    *  Return 0 on success, -1 on failure.
@@ -81,6 +103,14 @@ class CpDirectory {
   // Non-log file
   std::weak_ptr<LogFile> create_file(const LogString& fname, LogFile::LogType t,
                                      int flags = 0);
+  /*  create_index_file - create the time index file of the log file.
+   *  @lf: the log file in the directory.
+   *
+   *  The index file is removed with its log file. See log_index.h.
+   *
+   *  Return LogFile pointer on success, empty pointer on failure.
+   */
+  std::weak_ptr<LogFile> create_index_file(const LogFile* lf);
 
   /*  file_removed - inform the CpDirectory object of the file removal.
    *  @f: the LogFile that has been removed.
@@ -115,8 +145,16 @@ class CpDirectory {
    */
   int check_quota(uint64_t max_size, bool overwrite);
   void rm_oldest_log_file();
+  /*  evict - remove the file for the media quota. Update the size.
+   *  @f: the file, which shall be in the directory.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int evict(LogFile* f);
 
  private:
+  typedef LogList<std::shared_ptr<LogFile>>::iterator FileIter;
+
   /*
    * trim_log_file_num - check if the log files' number is no greater than num
    *
@@ -127,19 +165,74 @@ class CpDirectory {
    */
   bool trim_log_file_num(unsigned num);
 
+  /*  watch_log - watch the directory and the CP set directory so that
+   *              the deletion of the current log is detected without
+   *              checking the file system on each write.
+   *  @lf: the current log file.
+   */
+  void watch_log(LogFile* lf);
   void cancel_watch();
 
   const char* type_to_cp_name(CpType ct);
 
-  static void insert_ascending(LogList<std::shared_ptr<LogFile>>& lst,
-                               std::shared_ptr<LogFile>&& f);
+  /*  insert_file - add the file to the file list and the indexes.
+   *  @f: the file.
+   *  @ascending: true - keep the file list in ascending time order,
+   *              false - append the file to the list.
+   */
+  void insert_file(std::shared_ptr<LogFile>&& f, bool ascending);
+  /*  erase_file - remove the file from the file list and the indexes.
+   *
+   *  Return the iterator of the next file.
+   */
+  FileIter erase_file(FileIter it);
+  /*  find_file - find the file in the file list.
+   *
+   *  Return the iterator of the file, or m_log_files.end().
+   */
+  FileIter find_file(const LogFile* f);
+  /*  find_name - find the file of the name and the file time.
+   *
+   *  Return the iterator of the file, or m_log_files.end().
+   */
+  FileIter find_name(const LogFile::FileTime& t, const LogString& name);
+  /*  discard_index - discard the index file of the log file.
+   *  @lf: the log file.
+   *
+   *  The index file is removed from the file list, and the size is not
+   *  changed. This function shall be called before lf is erased from
+   *  the file list.
+   *
+   *  Return the size of the index file removed.
+   */
+  uint64_t discard_index(const LogFile* lf);
+  /*  remove_orphan_indexes - remove the index files without log files.
+   */
+  void remove_orphan_indexes();
+  /*  discard_file - move the log file to the trash of the media, or
+   *                 remove it when the trash can not be used.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int discard_file(LogFile* f);
+  // Change m_size and the size of the eviction group
+  void size_added(uint64_t len);
+  void size_removed(uint64_t len);
+
   /*  log_delete_notify - current log file deletion notification
    *                      function.
    *  @client: pointer to the CpDirectory object
    *  @evt: the file events, represented in IN_xxx macros
+   *  @name: name of the file deleted or moved in the directory
    *
    */
-  static void log_delete_notify(void* client, uint32_t evt);
+  static void log_delete_notify(void* client, uint32_t evt,
+                                const char* name);
+  /*  set_delete_notify - CP set directory deletion notification
+   *                      function.
+   */
+  static void set_delete_notify(void* client, uint32_t evt,
+                                const char* name);
 
  private:
   CpSetDirectory* m_cp_set_dir;
@@ -149,10 +242,17 @@ class CpDirectory {
   uint64_t m_size;
   // Log list
   LogList<std::shared_ptr<LogFile>> m_log_files;
+  // Files in m_log_files by file time
+  std::multimap<LogFile::FileTime, FileIter, EvictionIndex::FileTimeLess>
+      m_time_index;
+  // Eviction group of the directory on the media
+  EvictionIndex::Group* m_evict_group;
   // Current log file
   std::weak_ptr<LogFile> m_cur_log;
-  // File watch on current log
+  // File watch on the directory of current log
   FileWatcher::FileWatch* m_log_watch;
+  // File watch on the CP set directory of current log
+  FileWatcher::FileWatch* m_set_watch;
   bool m_store_full;
 };
 
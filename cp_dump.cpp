@@ -16,12 +16,19 @@
 */
 
 #include <poll.h>
+#include <sys/eventfd.h>
+#include <system_error>
+#include <time.h>
+#include <unistd.h>
+
 #include "cp_dir.h"
 #include "cp_dump.h"
 #include "cp_stor.h"
 #include "def_config.h"
+#include "diag_dev_hdl.h"
 #include "log_file.h"
 #include "log_pipe_hdl.h"
+#include "multiplexer.h"
 
 TransCpDump::TransCpDump(TransactionManager* tmgr,
                          Type t,
@@ -38,9 +45,13 @@ TransCpDump::TransCpDump(TransactionManager* tmgr,
       region_{},
       region_size_{},
 #endif
-      name_prefix_{prefix} {}
+      name_prefix_{prefix},
+      m_copy_left{0},
+      m_copy_notifier{nullptr} {}
 
 TransCpDump::~TransCpDump() {
+  wait_dump_contents();
+  m_dump_writer.discard();
   if (auto dump_file = m_dump_file.lock()) {
     dump_file->close();
   }
@@ -56,7 +67,9 @@ bool TransCpDump::open_dump_file() {
            m_time.tm_sec);
   LogString dump_file_name = name_prefix_ + log_name;
   m_dump_file = storage_.create_file(dump_file_name, LogFile::LT_DUMP);
-  if (0 == m_dump_file.use_count()) {
+  if (auto dump_file = m_dump_file.lock()) {
+    m_dump_writer.open(dump_file, storage_.io_channel(), diag_handler());
+  } else {
     ret = false;
     err_log("open dump file %s failed", ls2cstring(dump_file_name));
   }
@@ -81,7 +94,20 @@ LogFile* TransCpDump::open_dump_mem_file(const char* type) {
   }
 }
 
+int TransCpDump::close_dump_file() {
+  int ret = m_dump_writer.close();
+
+  if (auto dump_file = m_dump_file.lock()) {
+    dump_file->close();
+    m_dump_file.reset();
+  }
+
+  return ret;
+}
+
 void TransCpDump::remove_dump_file() {
+  m_dump_writer.discard();
+
   auto dump_file = m_dump_file.lock();
   if (dump_file) {
     dump_file->close();
@@ -96,24 +122,137 @@ bool TransCpDump::copy_dump_content(const char* mem_name,
   bool ret{};
 
   if (mem_file) {
+    ret = copy_region(mem_file, mem_path);
+    mem_file->close();
+  }
+
+  return ret;
+}
+
+int TransCpDump::start_copy_dump_contents(const DumpRegion* regions,
+                                          size_t num) {
+  if (m_copy_notifier || !num) {
+    return -1;
+  }
+
+  int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (-1 == efd) {
+    err_log("create dump eventfd error");
+    return -1;
+  }
+  m_copy_notifier = new CopyNotifier{efd, this};
+  subsys_->multiplexer()->register_fd(m_copy_notifier, POLLIN);
+
+  // The files are created in this thread because the storage is not
+  // thread safe.
+  m_regions.clear();
+  for (size_t i = 0; i < num; ++i) {
+    LogFile* f = open_dump_mem_file(regions[i].name);
+
+    if (!f) {
+      err_log("create dump file %s failed", regions[i].name);
+    }
+    m_mem_files.push_back(f);
+    m_regions.push_back(regions[i]);
+    m_regions.back().saved = false;
+  }
+
+  m_copy_left = static_cast<unsigned>(num);
+  for (size_t i = 0; i < num; ++i) {
+    try {
+      m_copy_workers.push_back(std::thread{&TransCpDump::copy_one, this, i});
+    } catch (const std::system_error& e) {
+      err_log("create dump thread error: %s", e.what());
+      copy_one(i);
+    }
+  }
+
+  return 0;
+}
+
+void TransCpDump::copy_one(size_t i) {
+  if (m_mem_files[i]) {
+    m_regions[i].saved = copy_region(m_mem_files[i], m_regions[i].path);
+  }
+
+  if (1 == m_copy_left.fetch_sub(1)) {
+    uint64_t n = 1;
+
+    if (sizeof n != ::write(m_copy_notifier->fd(), &n, sizeof n)) {
+      err_log("notify dump copy done error");
+    }
+  }
+}
+
+void TransCpDump::wait_dump_contents() {
+  if (m_copy_notifier) {
+    end_copy();
+  }
+}
+
+void TransCpDump::on_copy_done() {
+  end_copy();
+  on_dump_contents_copied(m_regions.data(), m_regions.size());
+}
+
+void TransCpDump::end_copy() {
+  // The workers have finished or are about to exit.
+  for (auto& t : m_copy_workers) {
+    t.join();
+  }
+  m_copy_workers.clear();
+
+  for (auto f : m_mem_files) {
+    if (f) {
+      f->close();
+    }
+  }
+  m_mem_files.clear();
+
+  delete m_copy_notifier;
+  m_copy_notifier = nullptr;
+}
+
+TransCpDump::CopyNotifier::CopyNotifier(int fd, TransCpDump* dump)
+    : FdHandler(fd, dump->subsys()->controller(),
+                dump->subsys()->multiplexer()),
+      m_dump{dump} {}
+
+void TransCpDump::CopyNotifier::process(int /*events*/) {
+  uint64_t n;
+
+  if (sizeof n != ::read(fd(), &n, sizeof n)) {
+    return;
+  }
+  // The notifier is deleted in on_copy_done().
+  m_dump->on_copy_done();
+}
+
+bool TransCpDump::copy_region(LogFile* mem_file, const char* mem_path) {
+  struct timespec start;
+  struct timespec end;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
 #ifdef USE_ORCA_MODEM
-    size_t buf_size = std::min(region_size_, DUMP_ONCE_READ_SIZE);
+  size_t buf_size = std::min(region_size_, DUMP_ONCE_READ_SIZE);
 
-    mem_file->reset_buffer(buf_size);
-    modem_iocmd(MODEM_READ_LOCK_CMD, mem_path, nullptr);
+  mem_file->reset_buffer(buf_size);
+  modem_iocmd(MODEM_READ_LOCK_CMD, mem_path, nullptr);
 #endif
-    if (mem_file->copy(mem_path)) {
-      err_log("dump memory: %s failed.", mem_path);
-    } else {
-      ret = true;
-      info_log("dump memory: %s successfully.", mem_path);
-    }
-    mem_file->close();
+  bool ret = !mem_file->copy(mem_path);
 #ifdef USE_ORCA_MODEM
-    modem_iocmd(MODEM_READ_UNLOCK_CMD, mem_path, nullptr);
+  modem_iocmd(MODEM_READ_UNLOCK_CMD, mem_path, nullptr);
 #endif
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  long ms = (end.tv_sec - start.tv_sec) * 1000 +
+            (end.tv_nsec - start.tv_nsec) / 1000000;
+
+  if (ret) {
+    info_log("dump memory: %s successfully, %lu bytes in %ld ms.",
+             mem_path, static_cast<unsigned long>(mem_file->size()), ms);
   } else {
-    err_log("create dump file %s failed", mem_name);
+    err_log("dump memory: %s failed after %ld ms.", mem_path, ms);
   }
 
   return ret;
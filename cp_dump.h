@@ -21,8 +21,12 @@
 #ifdef USE_ORCA_MODEM
 #include <algorithm>
 #endif
+#include <atomic>
 #include <memory>
+#include <thread>
 
+#include "async_file_wr.h"
+#include "fd_hdl.h"
 #include "log_file.h"
 #ifdef USE_ORCA_MODEM
 #include "modem_ioctl.h"
@@ -63,14 +67,58 @@ class TransCpDump : public TransDiagDevice {
       return nullptr;
     }
   }
-  void close_dump_file() {
-    if (auto dump_file = m_dump_file.lock()) {
-      dump_file->close();
-      m_dump_file.reset();
-    }
+  /*  write_dump - queue data to the dump file opened by open_dump_file().
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int write_dump(const void* data, size_t len) {
+    return m_dump_writer.write(data, len);
   }
+  /*  dump_throttled - whether the diag device shall not be read until
+   *                   the queued dump data is written.
+   */
+  bool dump_throttled() const { return m_dump_writer.throttled(); }
+  /*  close_dump_file - write the queued data and close the dump file.
+   *
+   *  Return 0 if all data is written, -1 otherwise.
+   */
+  int close_dump_file();
   void remove_dump_file();
+
+  // Memory region to be saved in a .mem file
+  struct DumpRegion {
+    const char* name;
+    const char* path;
+    // Set when the region is copied
+    bool saved;
+  };
+
   bool copy_dump_content(const char* mem_name, const char* mem_path);
+  /*  start_copy_dump_contents - save memory regions in .mem files.
+   *  @regions: the regions.
+   *  @num: number of regions.
+   *
+   *  The regions are copied in parallel, one worker thread for each
+   *  region, and on_dump_contents_copied() is called in the main
+   *  thread when all of them are finished.
+   *
+   *  Return 0 if the copy is started, -1 otherwise.
+   */
+  int start_copy_dump_contents(const DumpRegion* regions, size_t num);
+  bool copying_dump_contents() const { return m_copy_notifier != nullptr; }
+  /*  wait_dump_contents - wait for the copy in progress.
+   *
+   *  on_dump_contents_copied() is not called.
+   */
+  void wait_dump_contents();
+  /*  on_dump_contents_copied - the regions have been copied.
+   *  @regions: the regions with saved set.
+   *  @num: number of regions.
+   *
+   *  The transaction may be finished in the function.
+   */
+  virtual void on_dump_contents_copied(const DumpRegion* /*regions*/,
+                                       size_t /*num*/) {}
 
   bool open_dump_etb_file();
   LogFile* dump_etb_file() {
@@ -95,13 +143,47 @@ class TransCpDump : public TransDiagDevice {
   size_t region_size_;
 #endif
 
+ private:
+  /*  copy_region - copy one memory region.
+   *
+   *  This function may be called in worker threads.
+   */
+  bool copy_region(LogFile* mem_file, const char* mem_path);
+  /*  copy_one - copy the i-th region and notify the main thread if it
+   *             is the last one.
+   *
+   *  This function is called in worker threads.
+   */
+  void copy_one(size_t i);
+  void on_copy_done();
+  void end_copy();
+
+  // Notifier of the finished region copy
+  class CopyNotifier : public FdHandler {
+   public:
+    CopyNotifier(int fd, TransCpDump* dump);
+
+    void process(int events) override;
+
+   private:
+    TransCpDump* m_dump;
+  };
+
  private:
   LogPipeHandler* subsys_;
   CpStorage& storage_;
   struct tm m_time;
   LogString name_prefix_;
   std::weak_ptr<LogFile> m_dump_file;
+  AsyncFileWriter m_dump_writer;
   std::weak_ptr<LogFile> m_dump_etb_file;
+  // Regions being copied and their .mem files
+  LogVector<DumpRegion> m_regions;
+  LogVector<LogFile*> m_mem_files;
+  LogVector<std::thread> m_copy_workers;
+  // Number of regions not copied yet
+  std::atomic<unsigned> m_copy_left;
+  CopyNotifier* m_copy_notifier;
 };
 
 #endif  // !_CP_DUMP_H_
@@ -298,6 +298,13 @@ int operator - (const timeval& t1, const timeval& t2) {
   return diff;
 }
 
+uint64_t monotonic_ms() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return static_cast<uint64_t>(t.tv_sec) * 1000 + t.tv_nsec / 1000000;
+}
+
 bool is_data_mounted() {
   return 0 == access(WORK_CONF_DIR, W_OK | X_OK);
 }
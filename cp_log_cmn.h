@@ -254,6 +254,10 @@ int get_calendar_time(timeval& tnow, CalendarTime& ct);
 
 int operator - (const timeval& t1, const timeval& t2);
 
+/*  monotonic_ms - get the CLOCK_MONOTONIC time in milliseconds.
+ */
+uint64_t monotonic_ms();
+
 bool is_data_mounted();
 int is_vendor_version();
 
@@ -8,10 +8,19 @@
  *  Initial version.
  */
 
+#include <chrono>
+#include <fcntl.h>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
 #include "cp_dir.h"
 #include "cp_set_dir.h"
 #include "cp_stor.h"
+#include "def_config.h"
 #include "log_file.h"
+#include "log_frame.h"
+#include "log_index.h"
 #include "log_pipe_hdl.h"
 #include "media_stor_check.h"
 #include "stor_mgr.h"
@@ -20,17 +29,17 @@ CpStorage::CpStorage(StorageManager& stor_mgr, LogPipeHandler& cp)
     : m_stor_mgr{stor_mgr},
       m_cp{cp},
       m_new_log_cb{nullptr},
+      m_time_sync_cb{nullptr},
       m_shall_stop{false},
-      m_log_chan{nullptr} {
+      m_compress_log{false},
+      m_next_file{} {
   m_log_scheduler.set_file_written_callback(this, file_wr_callback);
 }
 
 CpStorage::~CpStorage() {
-  if (m_log_chan) {
-    m_log_scheduler.close();
-    m_log_chan->stop();
-    delete m_log_chan;
-  }
+  discard_next_file();
+  m_log_scheduler.close();
+  close_retired_files();
 
   if (auto cur_file = m_cur_file.lock()) {
     CpDirectory* cp_dir = cur_file->dir();
@@ -46,6 +55,10 @@ void CpStorage::set_log_commit_threshold(size_t size) {
   m_log_scheduler.set_commit_threshold(size);
 }
 
+void CpStorage::set_log_max_requests(unsigned num) {
+  m_log_scheduler.set_max_requests(num);
+}
+
 DataBuffer* CpStorage::get_buffer() {
   return m_log_scheduler.get_free_buffer();
 }
@@ -60,19 +73,66 @@ void CpStorage::set_buf_avail_callback(void* client,
 }
 
 int CpStorage::init() {
-  int ret = 0;
+  return m_log_scheduler.init_buffer();
+}
 
-  m_log_chan = new IoChannel{m_cp.controller(), m_cp.multiplexer()};
-  if (m_log_chan->init()) {
-    delete m_log_chan;
-    m_log_chan = nullptr;
-    ret = -1;
-  } else {
-    m_log_scheduler.init_buffer();
-    m_log_scheduler.bind(m_log_chan);
+int CpStorage::open_log_file(LogFile* lf) {
+  StorageManager::MediaType mt = m_stor_mgr.current_storage()->mt();
+  IoChannel* chan = m_stor_mgr.io_channel(mt);
+
+  if (!chan) {
+    err_log("no I/O channel for %s", ls2cstring(lf->base_name()));
+    lf->dir()->close_log_file();
+    m_cur_file.reset();
+    return -1;
   }
 
-  return ret;
+  // Reserve the space of the whole file to avoid fragmentation
+  // and file system metadata updates on each append.
+  bool prealloc = StorageManager::MT_EXT_STOR == mt
+                      ? EXT_STOR_LOG_PREALLOC : INT_STOR_LOG_PREALLOC;
+  if (prealloc) {
+    lf->preallocate(static_cast<size_t>(m_cp.get_max_log_file_size()));
+  }
+
+  // The header shall precede the prologue written by the new log
+  // callback.
+  if (m_compress_log && write_log_file_header(lf)) {
+    lf->dir()->close_log_file();
+    m_cur_file.reset();
+    return -1;
+  }
+
+  if (LOG_INDEX_INTERVAL) {
+    open_log_index(lf);
+  }
+
+  m_log_scheduler.bind(chan);
+  m_log_scheduler.open(lf);
+
+  return 0;
+}
+
+void CpStorage::open_log_index(LogFile* lf) {
+  auto f = lf->dir()->create_index_file(lf);
+
+  if (f.expired()) {
+    return;
+  }
+
+  LogIndex* index = new LogIndex(f, this, index_time_sync);
+  if (index->start()) {
+    // The index file is closed. It's ignored without a valid header.
+    delete index;
+    return;
+  }
+  lf->set_index(index);
+}
+
+bool CpStorage::index_time_sync(void* client, time_sync& ts) {
+  CpStorage* stor = static_cast<CpStorage*>(client);
+
+  return stor->m_time_sync_cb && stor->m_time_sync_cb(&stor->m_cp, ts);
 }
 
 void CpStorage::subscribe_media_change_event(
@@ -153,17 +213,21 @@ int CpStorage::write(DataBuffer* data) {
       return LogFile::FIO_ERROR;
     }
 
+    discard_next_file();
+
     bool cp_dir_created{false};
     m_cur_file = ms->create_file(m_cp.type(), m_cp.cp_class(),
                                  LogFile::LT_LOG,
                                  cp_dir_created);
 
     if (auto cur_file = m_cur_file.lock()) {
+      if (open_log_file(cur_file.get())) {
+        return LogFile::FIO_ERROR;
+      }
+
       if (m_new_log_cb) {
         m_new_log_cb(&m_cp, cur_file.get());
       }
-
-      m_log_scheduler.open(cur_file.get());
     } else {
       err_log("create log file failed");
       return LogFile::FIO_ERROR;
@@ -182,20 +246,31 @@ int CpStorage::write(DataBuffer* data) {
 int CpStorage::flush() {
   int ret = 0;
   info_log("CpStorage::flush() enter");
-  if (!m_cur_file.expired()) {
+  if (auto cur_file = m_cur_file.lock()) {
     ret = m_log_scheduler.flush();
+    if (cur_file->index()) {
+      cur_file->index()->flush();
+    }
   }
 
   return ret;
 }
 
 void CpStorage::stop() {
+  discard_next_file();
   if (auto cur_file = m_cur_file.lock()) {
     m_log_scheduler.close();
     info_log("m_log_scheduler.close()");
     cur_file->close();
     m_cur_file.reset();
   }
+  close_retired_files();
+}
+
+IoChannel* CpStorage::io_channel() {
+  MediaStorCheck* cur = m_stor_mgr.current_storage();
+
+  return cur ? m_stor_mgr.io_channel(cur->mt()) : nullptr;
 }
 
 std::weak_ptr<LogFile> CpStorage::create_file(const LogString& fname,
@@ -245,9 +320,11 @@ int CpStorage::check_quota(StorageManager::MediaType mt) {
 
 void CpStorage::file_wr_callback(void* client, LogFile* lf, int err) {
   CpStorage* stor = static_cast<CpStorage*>(client);
-  if (lf) {
+  // The size of the replaced log file does not matter any more.
+  if (lf && !stor->retired(lf)) {
     stor->on_file_size_update(lf, err);
   }
+  stor->close_retired_files();
 }
 
 void CpStorage::on_file_size_update(LogFile* lf, int err) {
@@ -255,6 +332,7 @@ void CpStorage::on_file_size_update(LogFile* lf, int err) {
   if (m_stor_mgr.check_media_change()) {
     // Media changed and current log file closed
     info_log("check the media was changed");
+    discard_next_file();
     MediaStorage* m = m_stor_mgr.get_media_stor();
 
     if (!m) {
@@ -281,8 +359,8 @@ void CpStorage::on_file_size_update(LogFile* lf, int err) {
                                   LogFile::LT_LOG,
                                   cp_dir_created);
 
-      if (auto cur_file = m_cur_file.lock()) {
-        m_log_scheduler.open(cur_file.get());
+      auto cur_file = m_cur_file.lock();
+      if (cur_file && !open_log_file(cur_file.get())) {
         info_log("a new log file created");
         if (m_new_log_cb) {
           m_new_log_cb(&m_cp, cur_file.get());
@@ -303,15 +381,18 @@ void CpStorage::on_file_size_update(LogFile* lf, int err) {
   CpDirectory* cp_dir = lf->dir();
 
   // if no space is left in current media storage
-  if (LogFile::FIO_DISK_FULL == err && m_cp.get_overwrite()) {
-    cp_dir->rm_oldest_log_file();
+  if (LogFile::FIO_DISK_FULL == err) {
+    // The free space estimation was wrong, sample it again.
+    m_stor_mgr.get_media_stor()->invalidate_space();
+    if (m_cp.get_overwrite()) {
+      cp_dir->rm_oldest_log_file();
+    }
   }
 
   if (lf->exists()) {
     // Check current log file size
     if (lf->size() >= m_cp.get_max_log_file_size()) {
-      cp_dir->close_log_file();
-      m_cur_file.reset();
+      rotate_log_file(lf);
     }
     // Check total log size
     if (m_stor_mgr.get_media_stor()->check_cp_quota(
@@ -322,6 +403,7 @@ void CpStorage::on_file_size_update(LogFile* lf, int err) {
       m_shall_stop = true;
     }
   } else {  // Current log file removed
+    m_log_scheduler.close();
     cp_dir->close_log_file();
     cp_dir->file_removed(lf);
   }
@@ -336,13 +418,14 @@ void CpStorage::on_file_size_update(LogFile* lf, int err) {
   } else if (m_cur_file.expired()) {
     bool cp_dir_created{false};
 
+    discard_next_file();
     m_cur_file =
         m_stor_mgr.get_media_stor()->
             create_file(m_cp.type(), m_cp.cp_class(),
                         LogFile::LT_LOG, cp_dir_created);
 
-    if (auto cur_file = m_cur_file.lock()) {
-      m_log_scheduler.open(cur_file.get());
+    auto cur_file = m_cur_file.lock();
+    if (cur_file && !open_log_file(cur_file.get())) {
       if (m_new_log_cb) {
         m_new_log_cb(&m_cp, cur_file.get());
       }
@@ -352,10 +435,197 @@ void CpStorage::on_file_size_update(LogFile* lf, int err) {
   }
 }
 
+void CpStorage::rotate_log_file(LogFile* lf) {
+  CpDirectory* cp_dir = lf->dir();
+
+  if (!m_next_file.file.valid()) {
+    int ret = prepare_next_file(cp_dir, lf->base_name());
+    if (ret < 0) {
+      close_cur_file(cp_dir);
+      return;
+    }
+    if (ret > 0) {
+      return;
+    }
+  }
+
+  // Keep writing the current log file until the next one is ready.
+  if (std::future_status::ready !=
+      m_next_file.file.wait_for(std::chrono::seconds(0))) {
+    return;
+  }
+
+  if (swap_log_file(cp_dir)) {
+    close_cur_file(cp_dir);
+  }
+}
+
+void CpStorage::close_cur_file(CpDirectory* cp_dir) {
+  m_log_scheduler.close();
+  cp_dir->close_log_file();
+  m_cur_file.reset();
+}
+
+int CpStorage::prepare_next_file(CpDirectory* cp_dir,
+                                 const LogString& cur_name) {
+  NextLogFile& next = m_next_file;
+
+  next.name = cp_dir->next_log_name(next.time);
+  if (str_empty(next.name)) {
+    return -1;
+  }
+  // The current log file is filled within one second, and the next
+  // log file would have the same name.
+  if (next.name == cur_name) {
+    return 1;
+  }
+
+  StorageManager::MediaType mt = m_stor_mgr.current_storage()->mt();
+  bool prealloc = StorageManager::MT_EXT_STOR == mt
+                      ? EXT_STOR_LOG_PREALLOC : INT_STOR_LOG_PREALLOC;
+  size_t prealloc_size = prealloc ?
+      static_cast<size_t>(m_cp.get_max_log_file_size()) : 0;
+
+  next.dir = cp_dir;
+  next.path = cp_dir->path() + "/" + next.name;
+  clock_gettime(CLOCK_MONOTONIC, &next.due_time);
+
+  LogString path = next.path;
+  try {
+    next.file = std::async(std::launch::async, [path, prealloc_size] {
+      OpenedFile f{::open(ls2cstring(path), O_CREAT | O_RDWR,
+                          S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH),
+                   prealloc_size};
+      if (f.fd >= 0 && f.prealloc_size &&
+          fallocate(f.fd, FALLOC_FL_KEEP_SIZE, 0,
+                    static_cast<off_t>(f.prealloc_size))) {
+        info_log("preallocate %s error %d", ls2cstring(path), errno);
+        f.prealloc_size = 0;
+      }
+      return f;
+    });
+  } catch (const std::system_error& e) {
+    err_log("prepare %s error: %s", ls2cstring(path), e.what());
+    return -1;
+  }
+
+  return 0;
+}
+
+int CpStorage::swap_log_file(CpDirectory* cp_dir) {
+  NextLogFile& next = m_next_file;
+  OpenedFile f = next.file.get();
+
+  if (f.fd < 0) {
+    err_log("create next log file %s error", ls2cstring(next.path));
+    return -1;
+  }
+  if (next.dir != cp_dir) {
+    // The current log file has moved to another directory.
+    ::close(f.fd);
+    unlink(ls2cstring(next.path));
+    return -1;
+  }
+
+  struct timespec t0;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  // Don't wait for the writes in flight on the current log file. It's
+  // closed when they finish.
+  auto old_file = m_cur_file.lock();
+  if (m_log_scheduler.detach_file() && old_file) {
+    old_file->watch_existence(false);
+    m_retired_files.push_back(old_file);
+  } else {
+    cp_dir->close_log_file();
+  }
+
+  m_cur_file = cp_dir->adopt_log_file(next.name, next.time, f.fd,
+                                      f.prealloc_size);
+  auto cur_file = m_cur_file.lock();
+  if (!cur_file || open_log_file(cur_file.get())) {
+    err_log("adopt next log file %s error", ls2cstring(next.path));
+    return -1;
+  }
+  if (m_new_log_cb) {
+    m_new_log_cb(&m_cp, cur_file.get());
+  }
+
+  struct timespec t1;
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  long swap_us = (t1.tv_sec - t0.tv_sec) * 1000000 +
+                 (t1.tv_nsec - t0.tv_nsec) / 1000;
+  long gap_us = (t1.tv_sec - next.due_time.tv_sec) * 1000000 +
+                (t1.tv_nsec - next.due_time.tv_nsec) / 1000;
+  info_log("rotate to %s: swap %ld us, %ld us after the log was full",
+           ls2cstring(next.name), swap_us, gap_us);
+
+  return 0;
+}
+
+bool CpStorage::retired(const LogFile* lf) const {
+  for (auto& f : m_retired_files) {
+    if (f.get() == lf) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void CpStorage::close_retired_files() {
+  auto it = m_retired_files.begin();
+
+  while (it != m_retired_files.end()) {
+    if (m_log_scheduler.writing(it->get())) {
+      ++it;
+    } else {
+      (*it)->close();
+      it = m_retired_files.erase(it);
+    }
+  }
+}
+
+void CpStorage::discard_next_file() {
+  if (!m_next_file.file.valid()) {
+    return;
+  }
+
+  auto file = std::make_shared<std::future<OpenedFile>>(
+      std::move(m_next_file.file));
+
+  if (std::future_status::ready ==
+      file->wait_for(std::chrono::seconds(0))) {
+    remove_next_file(file, m_next_file.path);
+    return;
+  }
+
+  // Don't block the main thread on the pending creation.
+  try {
+    std::thread(remove_next_file, file, m_next_file.path).detach();
+  } catch (const std::system_error& e) {
+    err_log("discard %s error: %s", ls2cstring(m_next_file.path),
+            e.what());
+    remove_next_file(file, m_next_file.path);
+  }
+}
+
+void CpStorage::remove_next_file(std::shared_ptr<std::future<OpenedFile>> file,
+                                 LogString path) {
+  OpenedFile f = file->get();
+  if (f.fd >= 0) {
+    ::close(f.fd);
+    // The file is empty. The directory may have been removed.
+    unlink(ls2cstring(path));
+  }
+}
+
 void CpStorage::on_cur_media_disabled() {
+  discard_next_file();
   // Flush and close current file.
   m_log_scheduler.flush();
   m_log_scheduler.close();
+  close_retired_files();
   if (!m_cur_file.expired()) {
     std::shared_ptr<LogFile> f = m_cur_file.lock();
     CpDirectory* pdir = f->dir();
@@ -10,7 +10,9 @@
 #ifndef _CP_STOR_H_
 #define _CP_STOR_H_
 
+#include <future>
 #include <memory>
+#include <time.h>
 
 #include "cp_log_cmn.h"
 #include "io_sched.h"
@@ -23,6 +25,7 @@ class LogPipeHandler;
 class CpStorage {
  public:
   using new_log_callback_t = void (*)(LogPipeHandler*, LogFile* f);
+  using time_sync_callback_t = bool (*)(LogPipeHandler*, time_sync& ts);
 
   CpStorage(StorageManager& stor_mgr, LogPipeHandler& cp);
   CpStorage(const CpStorage&) = delete;
@@ -32,9 +35,43 @@ class CpStorage {
 
   bool current_file_saving() const { return !m_cur_file.expired(); }
   void set_log_buffer_size(size_t max_buf, size_t max_num);
+  /*  resize_log_buffers - change the log buffer geometry after init().
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int resize_log_buffers(size_t max_buf, size_t max_num) {
+    return m_log_scheduler.resize_buffers(max_buf, max_num);
+  }
   void set_log_commit_threshold(size_t size);
+  /*  set_log_compression - write compressed log files.
+   *
+   *  The setting takes effect from the next log file.
+   */
+  void set_log_compression(bool on) { m_compress_log = on; }
+  /*  commit_aged_log - commit the queued log if it's read max_age ms
+   *                    before now.
+   */
+  void commit_aged_log(uint64_t now, unsigned max_age) {
+    m_log_scheduler.commit_aged(now, max_age);
+  }
+  AgeHistogram& log_data_age() { return m_log_scheduler.data_age(); }
+  /*  set_log_max_requests - set the maximum number of write requests
+   *                         in flight.
+   *  @num: number of requests
+   */
+  void set_log_max_requests(unsigned num);
+  /*  set_buffer_pool - get the log buffers from the shared pool.
+   *
+   *  This function shall be called before init().
+   */
+  void set_buffer_pool(BufferPool* pool) {
+    m_log_scheduler.set_buffer_pool(pool);
+  }
 
-  /* init - initialize the I/O channel.
+  /* init - initialize the log buffers.
+   *
+   * The log scheduler is bound to the I/O channel of the media when
+   * the log file is opened.
    *
    * Return: 0 on success, -1 on failure.
    */
@@ -74,6 +111,21 @@ class CpStorage {
   void stop();
 
   void set_new_log_callback(new_log_callback_t cb) { m_new_log_cb = cb; }
+  /*  set_time_sync_callback - set the callback to get the MODEM time
+   *                           sync info for the time index.
+   */
+  void set_time_sync_callback(time_sync_callback_t cb) {
+    m_time_sync_cb = cb;
+  }
+
+  /*  io_channel - get the IoChannel of the current media.
+   *
+   *  Non-log files created by create_file() on the current media can
+   *  be written through the returned channel.
+   *
+   *  Return the IoChannel pointer, nullptr if there is no media.
+   */
+  IoChannel* io_channel();
 
   // Non-log files
   std::weak_ptr<LogFile> create_file(const LogString& name, LogFile::LogType t,
@@ -134,21 +186,114 @@ class CpStorage {
    *           if necessary.
    */
   void on_file_size_update(LogFile* lf, int err);
+  /*  open_log_file - bind the log scheduler to the I/O channel of the
+   *                  current media and start writing lf.
+   *  @lf: the new current log file.
+   *
+   *  If there is no I/O channel for the media, lf will be closed.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int open_log_file(LogFile* lf);
+  /*  open_log_index - start the time index of the log file.
+   *  @lf: the new current log file.
+   *
+   *  The log is written without the index if the index file can not
+   *  be created.
+   */
+  void open_log_index(LogFile* lf);
+  /*  close_cur_file - close the current log file.
+   *  @cp_dir: directory of the current log file.
+   *
+   *  The write requests in flight are finished before the file is
+   *  closed.
+   */
+  void close_cur_file(CpDirectory* cp_dir);
+
+  /*  rotate_log_file - switch to the next log file when the current
+   *                    log file is full.
+   *  @cp_dir: directory of the current log file.
+   *
+   *  The next log file is created and preallocated in the background,
+   *  and the current log file is written until the next one is ready.
+   *  If the next log file can not be prepared in the background, the
+   *  current log file is closed and a new one is created on the next
+   *  size update or write.
+   */
+  void rotate_log_file(LogFile* lf);
+  /*  prepare_next_file - start creating the next log file in the
+   *                      background.
+   *  @cur_name: base name of the current log file.
+   *
+   *  Return 0 if started, 1 if the next file shall be prepared later,
+   *  -1 on failure.
+   */
+  int prepare_next_file(CpDirectory* cp_dir, const LogString& cur_name);
+  /*  swap_log_file - make the prepared file the current log file.
+   *
+   *  The old log file is closed when its writes in flight finish.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int swap_log_file(CpDirectory* cp_dir);
+  /*  discard_next_file - remove the prepared file that will not be used.
+   *
+   *  If the file is still being created, it is removed by a detached
+   *  thread when the creation finishes.
+   */
+  void discard_next_file();
+  /*  retired - check whether the file is replaced by rotation and its
+   *            writes are still in flight.
+   */
+  bool retired(const LogFile* lf) const;
+  /*  close_retired_files - close the replaced log files whose writes
+   *                        have finished.
+   */
+  void close_retired_files();
 
   static void file_wr_callback(void* client, LogFile* lf, int err);
+  static bool index_time_sync(void* client, time_sync& ts);
 
  private:
+  struct OpenedFile {
+    // The file descriptor, -1 on failure
+    int fd;
+    // The disk space reserved
+    size_t prealloc_size;
+  };
+  // The next log file being prepared in the background
+  struct NextLogFile {
+    CpDirectory* dir;
+    LogString name;
+    LogString path;
+    struct tm time;
+    std::future<OpenedFile> file;
+    // When the current log file is full
+    struct timespec due_time;
+  };
+
+  /*  remove_next_file - wait for the prepared file and remove it.
+   *  @file: the result of the creation.
+   *  @path: path of the file.
+   */
+  static void remove_next_file(std::shared_ptr<std::future<OpenedFile>> file,
+                               LogString path);
+
   StorageManager& m_stor_mgr;
   LogPipeHandler& m_cp;
   new_log_callback_t m_new_log_cb;
+  time_sync_callback_t m_time_sync_cb;
   // Current log file
   std::weak_ptr<LogFile> m_cur_file;
   // Log capacity state
   bool m_shall_stop;
+  // Write the log files compressed
+  bool m_compress_log;
   // I/O scheduler for current log
   IoScheduler m_log_scheduler;
-  // I/O thread for current log
-  IoChannel* m_log_chan;
+  NextLogFile m_next_file;
+  // Log files replaced by rotation with writes still in flight
+  LogList<std::shared_ptr<LogFile>> m_retired_files;
 };
 
 #endif  // !_CP_STOR_H_
@@ -8,12 +8,22 @@
  *  Initial version.
  */
 
+#include <new>
+
 #include "data_buf.h"
 
 DataBuffer* alloc_data_buf(size_t buf_size) {
-  DataBuffer* buf = new DataBuffer;
+  DataBuffer* buf = new (std::nothrow) DataBuffer;
+
+  if (!buf) {
+    return nullptr;
+  }
 
-  buf->buffer = new uint8_t[buf_size];
+  buf->buffer = new (std::nothrow) uint8_t[buf_size];
+  if (!buf->buffer) {
+    delete buf;
+    return nullptr;
+  }
   buf->buf_size = buf_size;
   buf->data_start = buf->data_len = 0;
   buf->dst_offset = -1;
@@ -31,7 +41,8 @@ DataBuffer::DataBuffer(uint8_t* buf, size_t sz,
      buf_size{sz},
      data_start{ds},
      data_len{dl},
-     dst_offset{doff} {}
+     dst_offset{doff},
+     stamp{0} {}
 
 DataBuffer::~DataBuffer() {
   if (buffer) {
@@ -19,6 +19,8 @@ struct DataBuffer {
   size_t data_start;
   size_t data_len;
   int dst_offset;
+  // CLOCK_MONOTONIC ms when the first byte is read in, 0 if not stamped
+  uint64_t stamp;
 
   DataBuffer();
   DataBuffer(uint8_t* buf, size_t sz, size_t ds, size_t dl, int doff);
@@ -28,6 +30,10 @@ struct DataBuffer {
   DataBuffer& operator = (const DataBuffer&) = delete;
 };
 
+/*  alloc_data_buf - allocate a DataBuffer and its buffer.
+ *
+ *  Return the DataBuffer, nullptr if the memory can not be allocated.
+ */
 DataBuffer* alloc_data_buf(size_t buf_size);
 
 #endif  //!DATA_BUF_H_
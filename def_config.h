@@ -123,4 +123,87 @@ static const int LINUX_KERNEL_CMDLINE_SIZE  = 1024;
 
 static const int MIX_FILE_MAX_NUM  = 3;
 
+// Number of log writer threads shared by all subsystems on one media
+static const unsigned INT_STOR_WRITER_NUM = 1;
+static const unsigned EXT_STOR_WRITER_NUM = 1;
+// Number of io_uring submission queue entries of one log writer
+static const unsigned IO_RING_ENTRIES = 32;
+// Interval in ms to poll the io_uring completions if waiting fails
+static const unsigned RING_POLL_INTERVAL = 10;
+
+// Reserve the disk space of the max log file size on log file creation
+static const bool INT_STOR_LOG_PREALLOC = false;
+static const bool EXT_STOR_LOG_PREALLOC = true;
+// Start the writeback of a log file every LOG_WRITEBACK_SIZE bytes
+// written, so that dirty pages are not flushed in large bursts.
+// 0 means writeback is left to the kernel.
+static const unsigned LOG_WRITEBACK_SIZE = 1024 * 1024;
+
+// Buffers of the asynchronous writer of dump, sleep log and event log
+// files. The diag device is not read when all buffers are in use.
+static const unsigned DIAG_WRITER_BUF_SIZE = 1024 * 64;
+static const unsigned DIAG_WRITER_BUF_NUM = 4;
+
+// Throttle of the background convey work on one media. The convey rate
+// is halved when a live log write takes longer than the budget, and is
+// increased by the step each period otherwise.
+static const unsigned CONVEY_LATENCY_BUDGET = 200;  // ms
+static const unsigned CONVEY_THROTTLE_PERIOD = 1000;  // ms
+static const unsigned CONVEY_MAX_RATE = 1024 * 1024 * 64;  // bytes/s
+static const unsigned CONVEY_MIN_RATE = 1024 * 256;  // bytes/s
+static const unsigned CONVEY_RATE_STEP = 1024 * 1024 * 2;  // bytes/s
+
+// Deleted logs are renamed into the trash directory under the log
+// directory of the media and removed by a background thread.
+#define TRASH_DIR_NAME ".trash"
+
+// The free space of the media is sampled by statvfs() every
+// MEDIA_STAT_PERIOD ms or after MEDIA_STAT_BYTES are written. The logs
+// are trimmed when the media is predicted to be full within
+// MEDIA_FULL_LEAD seconds at the current ingest rate.
+static const unsigned MEDIA_STAT_PERIOD = 5000;  // ms
+static const unsigned MEDIA_STAT_BYTES = 1024 * 1024 * 16;
+static const unsigned MEDIA_FULL_LEAD = 10;  // s
+
+// Log devices are read until EAGAIN on one poll wakeup, but no more
+// than LOG_READ_BUDGET bytes or LOG_READ_BUDGET_TIME ms, so that the
+// other devices are not starved.
+static const unsigned LOG_READ_BUDGET = 1024 * 1024;
+static const unsigned LOG_READ_BUDGET_TIME = 5;  // ms
+
+// The log buffers of all subsystems come from one pool. Besides its
+// reserved buffers, a subsystem may borrow from LOG_BUF_POOL_SHARED
+// bytes shared by all subsystems during a burst.
+static const unsigned LOG_BUF_POOL_SHARED = 1024 * 1024 * 2;
+
+// Limits of the log buffer geometry set by the configuration file or
+// the SET_BUF_GEOMETRY request.
+static const unsigned LOG_BUF_MIN_SIZE = 1024;
+static const unsigned LOG_BUF_MAX_SIZE = 1024 * 1024 * 4;
+static const unsigned LOG_BUF_MAX_NUM = 64;
+
+// The commit thresholds of a log stream are tuned every
+// LOG_COMMIT_TUNE_PERIOD ms so that the log is committed about
+// LOG_COMMIT_AGE_TARGET ms after it's read, but the thresholds are not
+// lowered under LOG_COMMIT_MIN_THRESHOLD bytes. When the log rate is
+// too low to reach the thresholds in time, the log older than
+// LOG_DATA_MAX_AGE ms is committed anyway.
+static const unsigned LOG_COMMIT_TUNE_PERIOD = 2000;  // ms
+static const unsigned LOG_COMMIT_AGE_TARGET = 1000;  // ms
+static const unsigned LOG_COMMIT_MIN_THRESHOLD = 1024 * 4;
+static const unsigned LOG_DATA_MAX_AGE = 3000;  // ms
+
+// Compressed log files are written in frames of LOG_FRAME_SIZE bytes
+// of log, which are compressed and decoded independently.
+static const unsigned LOG_FRAME_SIZE = 1024 * 64;
+
+// The time index of a log file has an entry for the data written
+// LOG_INDEX_INTERVAL bytes or LOG_INDEX_PERIOD ms after the last entry.
+// 0 means log files are not indexed.
+static const unsigned LOG_INDEX_INTERVAL = 1024 * 256;
+static const unsigned LOG_INDEX_PERIOD = 1000;  // ms
+// Index entries are written to the index file in LOG_INDEX_BUF_SIZE
+// bytes.
+static const unsigned LOG_INDEX_BUF_SIZE = 1024 * 4;
+
 #endif  // !_DEF_CONFIG_H_
@@ -14,6 +14,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include "def_config.h"
 #include "dev_file_hdl.h"
 #include "multiplexer.h"
 
@@ -63,10 +64,12 @@ void DeviceFileHandler::process(int events) {
     return;
   }
 
-  // Drain data from the file
+  // Drain data from the file, but no more than the budget so that the
+  // other devices are not starved.
   size_t free_size;
   size_t free_start;
-  while (true) {
+  size_t total = 0;
+  while (total < LOG_READ_BUDGET) {
     free_size = m_buffer.buf_size - m_buffer.data_start - m_buffer.data_len;
     free_start = m_buffer.data_start + m_buffer.data_len;
     ssize_t n = ::read(m_fd, m_buffer.buffer + free_start, free_size);
@@ -84,6 +87,7 @@ void DeviceFileHandler::process(int events) {
       break;
     }
     m_buffer.data_len += n;
+    total += n;
     if (process_data(m_buffer)) {
       break;
     }
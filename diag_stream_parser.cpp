@@ -7,6 +7,14 @@
  *  2015-8-15 Cao Xiaoyin
  *  Initial version.
  */
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+#include "cp_log_cmn.h"
 #include "diag_cmd_def.h"
 #include "diag_stream_parser.h"
 
@@ -17,6 +25,60 @@ void DiagStreamParser::reset() {
   m_len = 0;
 }
 
+size_t DiagStreamParser::find_special(const uint8_t* p, size_t len) {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  const __m128i flag = _mm_set1_epi8(static_cast<char>(FLAG_BYTE));
+  const __m128i esc = _mm_set1_epi8(static_cast<char>(ESCAPE_BYTE));
+
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+    int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, flag),
+                                              _mm_cmpeq_epi8(v, esc)));
+    if (mask) {
+      return i + __builtin_ctz(static_cast<unsigned>(mask));
+    }
+  }
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+  const uint8x16_t flag = vdupq_n_u8(FLAG_BYTE);
+  const uint8x16_t esc = vdupq_n_u8(ESCAPE_BYTE);
+
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8(p + i);
+    uint8x16_t m = vorrq_u8(vceqq_u8(v, flag), vceqq_u8(v, esc));
+    // Narrow each byte of the mask to 4 bits
+    uint64_t bits = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+    if (bits) {
+      return i + (__builtin_ctzll(bits) >> 2);
+    }
+  }
+#endif
+
+  return i + find_special_scalar(p + i, len - i);
+}
+
+size_t DiagStreamParser::find_special_scalar(const uint8_t* p, size_t len) {
+  size_t i;
+
+  for (i = 0; i < len; ++i) {
+    if (FLAG_BYTE == p[i] || ESCAPE_BYTE == p[i]) {
+      break;
+    }
+  }
+
+  return i;
+}
+
+void DiagStreamParser::drop_frame() {
+  err_log("diag frame longer than %u bytes dropped",
+          static_cast<unsigned>(sizeof m_pool));
+  // Skip the data until the end flag of the frame
+  m_state = PPP_DOWN;
+  m_len = 0;
+}
+
 bool DiagStreamParser::unescape(uint8_t *src_ptr, size_t src_len,
                                 uint8_t **dst_ptr, size_t *dst_len,
                                 size_t *used_len) {
@@ -35,6 +97,10 @@ bool DiagStreamParser::unescape(uint8_t *src_ptr, size_t src_len,
         src_len--;
         break;
       case PPP_HALT:
+        if (m_len >= sizeof m_pool) {
+          drop_frame();
+          break;
+        }
         m_state = PPP_UP;
         m_pool[m_len++] = *src_ptr ^ COMPLEMENT_BYTE;
         src_ptr++;
@@ -47,7 +113,22 @@ bool DiagStreamParser::unescape(uint8_t *src_ptr, size_t src_len,
           break;
         }
         m_state = PPP_UP;
-      case PPP_UP:
+      case PPP_UP: {
+        // Copy the data before the next special byte in one go
+        size_t n = find_special(src_ptr, src_len);
+
+        if (n) {
+          if (n > sizeof m_pool - m_len) {
+            drop_frame();
+            break;
+          }
+          memcpy(m_pool + m_len, src_ptr, n);
+          m_len += n;
+          src_ptr += n;
+          src_len -= n;
+          break;
+        }
+
         if (*src_ptr == FLAG_BYTE) {
           m_state = PPP_DOWN;
           src_ptr++;
@@ -57,8 +138,12 @@ bool DiagStreamParser::unescape(uint8_t *src_ptr, size_t src_len,
           *used_len = ori_len - src_len;
           m_len = 0;
           return true;
-        } else if (*src_ptr == ESCAPE_BYTE) {
+        } else {  // ESCAPE_BYTE
           if (src_len > 1) {
+            if (m_len >= sizeof m_pool) {
+              drop_frame();
+              break;
+            }
             m_pool[m_len++] = *(src_ptr + 1) ^ COMPLEMENT_BYTE;
             src_ptr += 2;
             src_len -= 2;
@@ -67,11 +152,9 @@ bool DiagStreamParser::unescape(uint8_t *src_ptr, size_t src_len,
             src_ptr++;
             src_len--;
           }
-        } else {
-          m_pool[m_len++] = *src_ptr++;
-          src_len--;
         }
         break;
+      }
       default:
         break;
     }
@@ -81,20 +164,29 @@ bool DiagStreamParser::unescape(uint8_t *src_ptr, size_t src_len,
 }
 
 size_t DiagStreamParser::escape(const uint8_t* src_ptr, size_t src_len,
-                                uint8_t *dst_ptr) {
+                                uint8_t *dst_ptr, size_t dst_len) {
   size_t tmp_len = 0;
 
   while (src_len) {
-    switch (*src_ptr) {
-      case FLAG_BYTE:
-      case ESCAPE_BYTE:
-        dst_ptr[tmp_len++] = ESCAPE_BYTE;
-        dst_ptr[tmp_len++] = *src_ptr ^ COMPLEMENT_BYTE;
-        break;
-      default:
-        dst_ptr[tmp_len++] = *src_ptr;
-        break;
+    // Copy the bytes that need no escape in one go
+    size_t n = find_special(src_ptr, src_len);
+
+    if (n) {
+      if (n > dst_len - tmp_len) {
+        return static_cast<size_t>(-1);
+      }
+      memcpy(dst_ptr + tmp_len, src_ptr, n);
+      tmp_len += n;
+      src_ptr += n;
+      src_len -= n;
+      continue;
     }
+
+    if (dst_len - tmp_len < 2) {
+      return static_cast<size_t>(-1);
+    }
+    dst_ptr[tmp_len++] = ESCAPE_BYTE;
+    dst_ptr[tmp_len++] = *src_ptr ^ COMPLEMENT_BYTE;
     src_len--;
     src_ptr++;
   }
@@ -102,58 +194,51 @@ size_t DiagStreamParser::escape(const uint8_t* src_ptr, size_t src_len,
   return tmp_len;
 }
 
-void DiagStreamParser::frame(uint8_t type, uint8_t subtype, uint8_t *pl,
-                             size_t pl_len, uint8_t **out_buf,
-                             size_t *out_len) {
-  struct diag_cmd_head head_ptr;
-  uint8_t *buf =
-      new uint8_t[((pl_len + sizeof(struct diag_cmd_head)) << 1) + 2];
-  size_t len = 0;
-
-  buf[len++] = FLAG_BYTE;
-  head_ptr.seq_num = 0;  // diag-frame has no sequence number
-  head_ptr.data_len = sizeof(struct diag_cmd_head) + pl_len;
-  head_ptr.type = type;
-  head_ptr.subtype = subtype;
-  len += escape(reinterpret_cast<uint8_t *>(&head_ptr),
-                sizeof(struct diag_cmd_head),
-                &buf[len]);
-  if (pl && pl_len) {
-    len += escape(pl, pl_len, &buf[len]);
-  }
-  buf[len++] = FLAG_BYTE;
-  *out_buf = buf;
-  *out_len = len;
+size_t DiagStreamParser::frame(uint8_t type, uint8_t subtype,
+                               const uint8_t* pl, size_t pl_len,
+                               uint8_t* buf, size_t buf_len) {
+  return frame(0, type, subtype, pl, pl_len, buf, buf_len);
 }
 
-uint8_t* DiagStreamParser::frame(uint32_t sn, int cmd, int sub_cmd,
-                                 const uint8_t* pl, size_t pl_len,
-                                 size_t& frame_len) {
-  size_t n = ((pl_len + 8) << 1) + 2;
-  uint8_t* pf = new uint8_t[n];
-  uint8_t sn_buf[4];
-  size_t len;
-
-  pf[0] = FLAG_BYTE;
-  len = 1;
-
-  sn_buf[0] = static_cast<uint8_t>(sn);
-  sn_buf[1] = static_cast<uint8_t>(sn >> 8);
-  sn_buf[2] = static_cast<uint8_t>(sn >> 16);
-  sn_buf[3] = static_cast<uint8_t>(sn >> 24);
-  len += escape(sn_buf, 4, pf + len);
-
-  unsigned diag_len = static_cast<unsigned>(pl_len) + 8;
-  sn_buf[0] = static_cast<uint8_t>(diag_len);
-  sn_buf[1] = static_cast<uint8_t>(diag_len >> 8);
-  sn_buf[2] = static_cast<uint8_t>(cmd);
-  sn_buf[3] = static_cast<uint8_t>(sub_cmd);
-  len += escape(sn_buf, 4, pf + len);
+size_t DiagStreamParser::frame(uint32_t sn, int cmd, int sub_cmd,
+                               const uint8_t* pl, size_t pl_len,
+                               uint8_t* buf, size_t buf_len) {
+  // Two flags
+  if (buf_len < 2) {
+    return 0;
+  }
 
-  len += escape(pl, pl_len, pf + len);
+  buf[0] = FLAG_BYTE;
+  size_t len = 1;
+  // Leave space for the end flag
+  size_t space = buf_len - 1;
+
+  // Diag header in little endian
+  uint8_t head[sizeof(struct diag_cmd_head)];
+  unsigned diag_len = static_cast<unsigned>(pl_len + sizeof head);
+
+  head[0] = static_cast<uint8_t>(sn);
+  head[1] = static_cast<uint8_t>(sn >> 8);
+  head[2] = static_cast<uint8_t>(sn >> 16);
+  head[3] = static_cast<uint8_t>(sn >> 24);
+  head[4] = static_cast<uint8_t>(diag_len);
+  head[5] = static_cast<uint8_t>(diag_len >> 8);
+  head[6] = static_cast<uint8_t>(cmd);
+  head[7] = static_cast<uint8_t>(sub_cmd);
+  size_t n = escape(head, sizeof head, buf + len, space - len);
+  if (static_cast<size_t>(-1) == n) {
+    return 0;
+  }
+  len += n;
 
-  pf[len] = FLAG_BYTE;
+  if (pl && pl_len) {
+    n = escape(pl, pl_len, buf + len, space - len);
+    if (static_cast<size_t>(-1) == n) {
+      return 0;
+    }
+    len += n;
+  }
 
-  frame_len = len + 1;
-  return pf;
+  buf[len++] = FLAG_BYTE;
+  return len;
 }
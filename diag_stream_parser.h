@@ -30,6 +30,8 @@ class DiagStreamParser {
    *            length in *dst_len
    *  @used_len: return the length of the parsed data in *used_len
    *
+   *  Frames longer than m_pool are dropped.
+   *
    *  Return Value:
    *    If a frame is finished, return true; otherwise return
    *    false.
@@ -37,9 +39,6 @@ class DiagStreamParser {
   bool unescape(uint8_t *src_ptr, size_t src_len, uint8_t **dst_ptr,
                 size_t *dst_len, size_t *used_len);
 
-  void frame(uint8_t type, uint8_t subtype, uint8_t *pl, size_t pl_len,
-             uint8_t **out_buf, size_t *out_len);
-
   uint8_t get_type(uint8_t *frame_head) {
     return ((struct diag_cmd_head *)frame_head)->type;
   }
@@ -54,29 +53,84 @@ class DiagStreamParser {
 
   uint8_t get_head_size() { return sizeof(struct diag_cmd_head); }
 
-  /*  frame - form a diagnosis frame.
+  /*  max_frame_len - the max length of the frame of the payload.
+   *  @pl_len: payload length
+   *
+   *  Return the length of the frame when all bytes are escaped.
+   */
+  static size_t max_frame_len(size_t pl_len) {
+    return ((pl_len + sizeof(struct diag_cmd_head)) << 1) + 2;
+  }
+
+  /*  frame - form a diagnosis frame in the buffer of the caller.
+   *  @type: CMD
+   *  @subtype: SubCMD
+   *  @pl: pointer to the frame payload
+   *  @pl_len: payload length
+   *  @buf: the buffer to put the frame
+   *  @buf_len: size of buf. It shall be max_frame_len(pl_len) to hold
+   *            any payload.
+   *
+   *  The sequence number of the frame is 0.
+   *
+   *  Return Value:
+   *    The length of the frame, 0 if buf is not long enough.
+   */
+  static size_t frame(uint8_t type, uint8_t subtype, const uint8_t* pl,
+                      size_t pl_len, uint8_t* buf, size_t buf_len);
+
+  /*  frame - form a diagnosis frame in the buffer of the caller.
    *  @sn: serial number
    *  @cmd: CMD
    *  @sub_cmd: SubCMD
    *  @pl: pointer to the frame payload
    *  @pl_len: payload length
-   *  @frame_len: the diagnosis frame length
+   *  @buf: the buffer to put the frame
+   *  @buf_len: size of buf. It shall be max_frame_len(pl_len) to hold
+   *            any payload.
    *
    *  Return Value:
-   *    The pointer to the frame. The buffer is allocated using new, and
-   *    the client shall delete it when it's not needed.
+   *    The length of the frame, 0 if buf is not long enough.
    */
-  static uint8_t* frame(uint32_t sn, int cmd, int sub_cmd,
-                        const uint8_t* pl, size_t pl_len,
-                        size_t& frame_len);
+  static size_t frame(uint32_t sn, int cmd, int sub_cmd,
+                      const uint8_t* pl, size_t pl_len,
+                      uint8_t* buf, size_t buf_len);
+
+  /*  find_special - find the first FLAG_BYTE or ESCAPE_BYTE.
+   *  @p: the data to search
+   *  @len: length of the data
+   *
+   *  SSE2 or NEON is used when available.
+   *
+   *  Return the offset of the special byte, len if not found.
+   */
+  static size_t find_special(const uint8_t* p, size_t len);
+  /*  find_special_scalar - find_special() one byte at a time.
+   *
+   *  It scans the tail shorter than a vector, and it's the reference
+   *  of find_special() in tests/diag_stream_parser_test.cpp.
+   */
+  static size_t find_special_scalar(const uint8_t* p, size_t len);
 
  private:
   DiagParseState m_state;
   uint8_t m_pool[64 * 1024];
   size_t m_len;
 
+  /*  escape - escape the data.
+   *  @src_ptr: the data to escape
+   *  @src_len: length of the data
+   *  @dst_ptr: the buffer for the escaped data
+   *  @dst_len: size of dst_ptr
+   *
+   *  Return the length of the escaped data, or (size_t)-1 if dst_ptr
+   *  is not long enough.
+   */
   static size_t escape(const uint8_t *src_ptr, size_t src_len,
-                       uint8_t *dst_ptr);
+                       uint8_t *dst_ptr, size_t dst_len);
+  /*  drop_frame - discard the frame that doesn't fit in m_pool.
+   */
+  void drop_frame();
 };
 
 #endif  //!_DIAG_STREAM_PARSER_H_
@@ -0,0 +1,54 @@
+/*
+ *  evict_index.cpp - log file eviction index of one media.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include "cp_dir.h"
+#include "evict_index.h"
+
+EvictionIndex::Group* EvictionIndex::group(CpClass cp_class, CpType ct) {
+  return &m_groups[GroupKey(cp_class, ct)];
+}
+
+uint64_t EvictionIndex::size(CpClass cp_class, CpType ct) const {
+  auto it = m_groups.find(GroupKey(cp_class, ct));
+
+  return it == m_groups.end() ? 0 : it->second.size;
+}
+
+uint64_t EvictionIndex::trim(CpClass cp_class, CpType ct, uint64_t sz) {
+  auto it = m_groups.find(GroupKey(cp_class, ct));
+  uint64_t total_dec = 0;
+
+  if (it == m_groups.end()) {
+    return 0;
+  }
+
+  Group& g = it->second;
+
+  while (!g.files.empty()) {
+    LogFile* f = g.files.begin()->file;
+    uint64_t old_size = g.size;
+
+    // The file is removed from the index by the directory.
+    if (f->dir()->evict(f)) {
+      break;
+    }
+
+    // The index file of the log file may be removed too.
+    uint64_t dec_size = old_size - g.size;
+
+    total_dec += dec_size;
+    if (dec_size >= sz) {
+      break;
+    }
+    sz -= dec_size;
+  }
+
+  return total_dec;
+}
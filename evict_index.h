@@ -0,0 +1,98 @@
+/*
+ *  evict_index.h - log file eviction index of one media.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _EVICT_INDEX_H_
+#define _EVICT_INDEX_H_
+
+#include <map>
+#include <set>
+
+#include "cp_log_cmn.h"
+#include "log_file.h"
+
+class CpDirectory;
+
+/*  EvictionIndex - the overwritable log files of one media, grouped by
+ *                  storage class and subsystem and ordered by file time.
+ *
+ *  Each group keeps the total log size of its CpDirectory objects, so
+ *  the quota of a subsystem is checked without walking the directories,
+ *  and the oldest overwritable file of the group is found at once.
+ *
+ *  The CpDirectory objects update the index when files are added or
+ *  removed and when their size changes.
+ */
+class EvictionIndex {
+ public:
+  struct FileTimeLess {
+    bool operator()(const LogFile::FileTime& a,
+                    const LogFile::FileTime& b) const {
+      return !(b <= a);
+    }
+  };
+
+  struct Item {
+    LogFile::FileTime time;
+    LogFile* file;
+  };
+
+  struct ItemLess {
+    bool operator()(const Item& a, const Item& b) const {
+      FileTimeLess less;
+
+      if (less(a.time, b.time)) {
+        return true;
+      }
+      if (less(b.time, a.time)) {
+        return false;
+      }
+      return a.file < b.file;
+    }
+  };
+
+  struct Group {
+    // Total log size of the directories in the group
+    uint64_t size;
+    // Overwritable files, the oldest first
+    std::set<Item, ItemLess> files;
+
+    Group() : size{0} {}
+  };
+
+  /*  group - get the group of the storage class and the subsystem.
+   *
+   *  The group is created on first use and lives as long as the index.
+   */
+  Group* group(CpClass cp_class, CpType ct);
+
+  /*  size - get the total log size of the group.
+   */
+  uint64_t size(CpClass cp_class, CpType ct) const;
+
+  /*  trim - remove the oldest overwritable files of the group.
+   *  @sz: the size to trim.
+   *
+   *  Return the number of bytes removed.
+   */
+  uint64_t trim(CpClass cp_class, CpType ct, uint64_t sz);
+
+  static void add_file(Group* g, LogFile* f) {
+    g->files.insert(Item{f->file_time(), f});
+  }
+  static void remove_file(Group* g, LogFile* f) {
+    g->files.erase(Item{f->file_time(), f});
+  }
+
+ private:
+  typedef std::pair<int, int> GroupKey;
+
+  std::map<GroupKey, Group> m_groups;
+};
+
+#endif  // !_EVICT_INDEX_H_
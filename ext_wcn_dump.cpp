@@ -71,27 +71,31 @@ bool TransExtWcnDump::process(DataBuffer& buffer) {
   bool ret = false;
   int trans_res = TRANS_R_SUCCESS;
 
-  LogFile* f = dump_file();
   size_t len = buffer.data_len;
   const uint8_t* p = buffer.buffer + buffer.data_start;
-  ssize_t n = f->write(p, len);
+  bool finished = false;
 
-  if (static_cast<size_t>(n) != len) {
+  if (!dump_file() || write_dump(p, len)) {
     remove_dump_file();
     trans_res = TRANS_R_FAILURE;
-    ret = true;
+    finished = true;
   } else if (find_str(p, len,
                       reinterpret_cast<const uint8_t*>
                           ("marlin_memdump_finish"), 
                       21)) {
-    close_dump_file();
-    ret =  true;
+    if (close_dump_file()) {
+      trans_res = TRANS_R_FAILURE;
+    }
+    finished = true;
   }
 
   buffer.data_start = 0;
   buffer.data_len = 0;
 
-  if (ret) {
+  // Stop reading until the queued data is written.
+  ret = finished || dump_throttled();
+
+  if (finished) {
     TimerManager& tmgr = diag_handler()->multiplexer()->timer_mgr();
     tmgr.del_timer(read_timer_);
     read_timer_ = nullptr;
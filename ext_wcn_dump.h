@@ -49,7 +49,7 @@ class TransExtWcnDump : public TransCpDump {
   static void notify_stor_inactive(void* client, unsigned priority);
 
  private:
-  TimerManager::Timer* read_timer_;
+  TimerManager::TimerHandle read_timer_;
 };
 
 #endif  // !_EXT_WCN_DUMP_H_
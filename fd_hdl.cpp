@@ -34,6 +34,7 @@ int FdHandler::close() {
   int ret = 0;
 
   if (m_fd >= 0) {
+    m_multiplexer->detach_fd(this);
     ret = ::close(m_fd);
     m_fd = -1;
   }
@@ -45,16 +45,15 @@ int FileWatcher::init() {
 }
 
 int FileWatcher::add(void* client, FileWatchCallback_t cb,
-                     const LogString& path, FileWatch*& fw) {
-  int i = get(path);
-  if (i >= 0) {
-    return -1;
-  }
-  int wd = inotify_add_watch(m_fd, ls2cstring(path), IN_DELETE_SELF);
+                     const LogString& path, FileWatch*& fw,
+                     uint32_t mask) {
+  // The kernel returns the same watch descriptor for the same inode,
+  // so keep the events of the other clients.
+  int wd = inotify_add_watch(m_fd, ls2cstring(path), mask | IN_MASK_ADD);
   if (-1 == wd) {
     return -1;
   }
-  FileWatch* w = new FileWatch(path, client, cb, wd);
+  FileWatch* w = new FileWatch(path, client, cb, wd, mask);
   m_watch_set.push_back(w);
   fw = w;
   return 0;
@@ -72,19 +71,21 @@ int FileWatcher::del(FileWatch* fw) {
     }
   }
   if (!ret) {
-    inotify_rm_watch(m_fd, fw->wd);
+    if (get(fw->wd) < 0) {
+      inotify_rm_watch(m_fd, fw->wd);
+    }
     delete fw;
   }
 
   return ret;
 }
 
-int FileWatcher::get(const LogString& path) {
+int FileWatcher::get(int wd) const {
   size_t i;
   int ret = -1;
 
   for (i = 0; i < m_watch_set.size(); ++i) {
-    if (m_watch_set[i]->path == path) {
+    if (m_watch_set[i]->wd == wd) {
       ret = static_cast<int>(i);
       break;
     }
@@ -93,18 +94,45 @@ int FileWatcher::get(const LogString& path) {
   return ret;
 }
 
-int FileWatcher::get(int wd) {
-  size_t i;
-  int ret = -1;
+bool FileWatcher::watched(const FileWatch* fw) const {
+  for (auto w : m_watch_set) {
+    if (w == fw) {
+      return true;
+    }
+  }
 
-  for (i = 0; i < m_watch_set.size(); ++i) {
-    if (m_watch_set[i]->wd == wd) {
-      ret = static_cast<int>(i);
-      break;
+  return false;
+}
+
+void FileWatcher::dispatch(const inotify_event* evt) {
+  LogVector<FileWatch*> targets;
+
+  for (auto w : m_watch_set) {
+    if (w->wd == evt->wd && ((evt->mask & w->mask) ||
+                             (evt->mask & IN_IGNORED))) {
+      targets.push_back(w);
     }
   }
 
-  return ret;
+  const char* name = evt->len ? evt->name : nullptr;
+  for (auto w : targets) {
+    // The callback of the previous client may have deleted the watch.
+    if (watched(w)) {
+      w->cb(w->client, evt->mask, name);
+    }
+  }
+
+  if (evt->mask & IN_IGNORED) {
+    auto it = m_watch_set.begin();
+    while (it != m_watch_set.end()) {
+      if ((*it)->wd == evt->wd) {
+        delete *it;
+        it = m_watch_set.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
 }
 
 void FileWatcher::process(int events) {
@@ -112,21 +140,23 @@ void FileWatcher::process(int events) {
     return;
   }
 
+  alignas(inotify_event) char buf[4096];
+
   while (true) {
-    inotify_event evt;
-    ssize_t n = read(m_fd, &evt, sizeof evt);
+    ssize_t n = read(m_fd, buf, sizeof buf);
     if (-1 == n) {
       if (EAGAIN != errno) {
         err_log("read inotify error");
       }
       break;
     }
-    if (evt.mask & IN_DELETE_SELF) {
-      int i = get(evt.wd);
-      if (i >= 0) {
-        FileWatch* fw = m_watch_set[i];
-        fw->cb(fw->client, evt.mask);
-      }
+
+    ssize_t pos = 0;
+    while (pos + static_cast<ssize_t>(sizeof(inotify_event)) <= n) {
+      const inotify_event* evt =
+          reinterpret_cast<const inotify_event*>(buf + pos);
+      dispatch(evt);
+      pos += sizeof(inotify_event) + evt->len;
     }
   }
 }
@@ -19,17 +19,27 @@ class Multiplexer;
 
 class FileWatcher : public FdHandler {
  public:
-  typedef void (*FileWatchCallback_t)(void* client, uint32_t evt);
+  /*  FileWatchCallback_t - the file event callback.
+   *  @client: the client parameter of add().
+   *  @evt: the file events, represented in IN_xxx macros.
+   *  @name: name of the file in the watched directory, or nullptr.
+   *
+   *  On IN_IGNORED the watch has been removed by the kernel and the
+   *  FileWatch object is deleted after the callback returns.
+   */
+  typedef void (*FileWatchCallback_t)(void* client, uint32_t evt,
+                                      const char* name);
 
   struct FileWatch {
     LogString path;
     void* client;
     FileWatchCallback_t cb;
     int wd;
+    uint32_t mask;
 
     FileWatch(const LogString& p, void* c, FileWatchCallback_t callback,
-              int watch_fd)
-        : path(p), client(c), cb(callback), wd(watch_fd) {}
+              int watch_fd, uint32_t events)
+        : path(p), client(c), cb(callback), wd(watch_fd), mask(events) {}
   };
 
   FileWatcher(LogController* ctrl, Multiplexer* multiplexer);
@@ -37,8 +47,15 @@ class FileWatcher : public FdHandler {
 
   int init();
 
+  /*  add - watch the file or directory.
+   *  @mask: the events to watch, represented in IN_xxx macros.
+   *
+   *  One path may be watched by several clients.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
   int add(void* client, FileWatchCallback_t cb, const LogString& path,
-          FileWatch*& fw);
+          FileWatch*& fw, uint32_t mask = IN_DELETE_SELF);
   int del(FileWatch* fw);
 
   // Override the events handler
@@ -47,8 +64,9 @@ class FileWatcher : public FdHandler {
  private:
   LogVector<FileWatch*> m_watch_set;
 
-  int get(const LogString& path);
-  int get(int wd);
+  int get(int wd) const;
+  bool watched(const FileWatch* fw) const;
+  void dispatch(const inotify_event* evt);
 };
 
 #endif  // !_FILE_WATCHER_H_
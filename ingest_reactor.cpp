@@ -0,0 +1,450 @@
+/*
+ *  ingest_reactor.cpp - read log devices on a dedicated thread.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "cp_stor.h"
+#include "def_config.h"
+#include "ingest_reactor.h"
+#include "multiplexer.h"
+
+IngestChannel::IngestChannel(LogController* ctrl, Multiplexer* multi,
+                             IngestReactor* reactor, void* client,
+                             event_callback_t cb)
+    : FdHandler(-1, ctrl, multi),
+      m_reactor{reactor},
+      m_client{client},
+      m_cb{cb},
+      m_storage{nullptr},
+      m_attached{false},
+      m_free_target{0},
+      m_dev_fd{-1},
+      m_commit_threshold{0},
+      m_pending_stamp{0},
+      m_starved{false},
+      m_error{false},
+      m_cur{nullptr},
+      m_armed{false} {}
+
+IngestChannel::~IngestChannel() {
+  detach();
+}
+
+int IngestChannel::init() {
+  m_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_fd < 0) {
+    err_log("create ingest eventfd error");
+    return -1;
+  }
+
+  multiplexer()->register_fd(this, POLLIN);
+
+  return 0;
+}
+
+int IngestChannel::attach(int dev_fd, CpStorage* stor,
+                          size_t commit_threshold, size_t free_bufs) {
+  if (m_attached) {
+    return 0;
+  }
+
+  m_dev_fd = dev_fd;
+  m_storage = stor;
+  m_commit_threshold.store(commit_threshold, std::memory_order_relaxed);
+  m_pending_stamp.store(0, std::memory_order_relaxed);
+  // All buffers of the channel shall fit in the filled ring.
+  if (free_bufs >= RING_SIZE) {
+    free_bufs = RING_SIZE - 1;
+  } else if (!free_bufs) {
+    free_bufs = 1;
+  }
+  m_free_target = free_bufs;
+  m_starved = false;
+  m_error = false;
+
+  m_attached = true;
+  refill();
+  if (m_reactor->attach(this)) {
+    m_attached = false;
+
+    DataBuffer* buf;
+    while (m_free.pop(buf)) {
+      m_storage->free_buffer(buf);
+    }
+    return -1;
+  }
+
+  return 0;
+}
+
+void IngestChannel::detach() {
+  if (!m_attached) {
+    return;
+  }
+
+  m_reactor->detach(this);
+  m_attached = false;
+
+  deliver();
+
+  DataBuffer* buf;
+  while (m_free.pop(buf)) {
+    m_storage->free_buffer(buf);
+  }
+  m_starved = false;
+  m_error = false;
+}
+
+void IngestChannel::flush() {
+  if (m_attached) {
+    m_reactor->flush(this);
+    deliver();
+  }
+}
+
+void IngestChannel::refill() {
+  if (!m_attached) {
+    return;
+  }
+
+  bool added = false;
+
+  while (m_free.size() < m_free_target) {
+    DataBuffer* buf = m_storage->get_buffer();
+    if (!buf) {
+      break;
+    }
+    m_free.push(buf);
+    added = true;
+  }
+
+  if (added) {
+    // Pairs with the fence in read_device().
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_starved.exchange(false)) {
+      m_reactor->resume(this);
+    }
+  }
+}
+
+void IngestChannel::process(int /*events*/) {
+  uint64_t cnt;
+
+  if (-1 == read(m_fd, &cnt, sizeof cnt) && EAGAIN != errno) {
+    err_log("read ingest eventfd error");
+  }
+
+  deliver();
+}
+
+void IngestChannel::deliver() {
+  DataBuffer* buf;
+
+  while (m_filled.pop(buf)) {
+    size_t len = buf->data_len;
+
+    if (!len) {
+      m_storage->free_buffer(buf);
+      continue;
+    }
+
+    if (m_storage->write(buf) < 0) {
+      err_log("enqueue ingested log error, %u bytes discarded",
+              static_cast<unsigned>(len));
+      m_storage->free_buffer(buf);
+    } else {
+      m_cb(m_client, IE_DATA, len);
+    }
+  }
+
+  if (m_attached) {
+    refill();
+    if (m_error.exchange(false)) {
+      m_cb(m_client, IE_ERROR, 0);
+    }
+  }
+}
+
+bool IngestChannel::read_device() {
+  size_t total = 0;
+
+  while (total < LOG_READ_BUDGET) {
+    if (!m_cur && !m_free.pop(m_cur)) {
+      m_starved = true;
+      // The main thread may have added buffers before m_starved is set.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (!m_free.pop(m_cur)) {
+        return false;
+      }
+      m_starved = false;
+    }
+
+    size_t wr_start = m_cur->data_start + m_cur->data_len;
+    size_t rlen = m_cur->buf_size - wr_start;
+    ssize_t nr = read(m_dev_fd, m_cur->buffer + wr_start, rlen);
+
+    if (nr <= 0) {
+      if (-1 == nr) {
+        if (EAGAIN == errno || EINTR == errno || ENODATA == errno) {
+          return true;
+        }
+        err_log("read log device %d error", m_dev_fd);
+        m_error = true;
+        notify();
+        return false;
+      }
+      err_log("read log device returns 0, fd = %d", m_dev_fd);
+      return true;
+    }
+
+    total += nr;
+    if (!m_cur->data_len) {
+      m_cur->stamp = monotonic_ms();
+      m_pending_stamp.store(m_cur->stamp, std::memory_order_relaxed);
+    }
+    m_cur->data_len += nr;
+
+    size_t threshold = m_commit_threshold.load(std::memory_order_relaxed);
+    if (m_cur->data_len >= threshold || static_cast<size_t>(nr) >= rlen) {
+      commit();
+    }
+  }
+
+  return true;
+}
+
+void IngestChannel::commit() {
+  m_pending_stamp.store(0, std::memory_order_relaxed);
+  if (!m_filled.push(m_cur)) {
+    // Not expected: the channel never has more than RING_SIZE buffers.
+    err_log("ingest ring full, %u bytes discarded",
+            static_cast<unsigned>(m_cur->data_len));
+    m_cur->data_start = m_cur->data_len = 0;
+    m_cur->stamp = 0;
+    return;
+  }
+  m_cur = nullptr;
+  notify();
+}
+
+void IngestChannel::notify() {
+  uint64_t one = 1;
+
+  if (-1 == write(m_fd, &one, sizeof one) && EAGAIN != errno) {
+    err_log("write ingest eventfd error");
+  }
+}
+
+IngestReactor::IngestReactor() : m_epoll_fd{-1}, m_wake_fd{-1} {}
+
+IngestReactor::~IngestReactor() {
+  if (m_thread.joinable()) {
+    execute(CMD_QUIT, nullptr);
+    m_thread.join();
+  }
+  if (m_wake_fd >= 0) {
+    ::close(m_wake_fd);
+  }
+  if (m_epoll_fd >= 0) {
+    ::close(m_epoll_fd);
+  }
+}
+
+int IngestReactor::start() {
+  if (m_thread.joinable()) {
+    return 0;
+  }
+
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (-1 == m_epoll_fd) {
+    err_log("ingest epoll_create1 error");
+    return -1;
+  }
+
+  m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (-1 == m_wake_fd) {
+    err_log("ingest eventfd error");
+    return -1;
+  }
+
+  struct epoll_event ev;
+
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wake_fd, &ev)) {
+    err_log("add ingest eventfd error");
+    return -1;
+  }
+
+  try {
+    m_thread = std::thread(&IngestReactor::run, this);
+  } catch (const std::system_error& e) {
+    err_log("create ingest thread error: %s", e.what());
+    return -1;
+  }
+
+  return 0;
+}
+
+void IngestReactor::resume(IngestChannel* chan) {
+  post(Command{CMD_RESUME, chan, nullptr, nullptr});
+}
+
+int IngestReactor::execute(CommandType type, IngestChannel* chan) {
+  int result = -1;
+  bool done = false;
+
+  post(Command{type, chan, &result, &done});
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cond.wait(lock, [&done] { return done; });
+
+  return result;
+}
+
+void IngestReactor::post(const Command& cmd) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cmds.push_back(cmd);
+  }
+
+  uint64_t one = 1;
+  if (-1 == write(m_wake_fd, &one, sizeof one) && EAGAIN != errno) {
+    err_log("wake up ingest thread error");
+  }
+}
+
+void IngestReactor::run() {
+  struct epoll_event events[16];
+
+  while (true) {
+    int n = epoll_wait(m_epoll_fd, events, 16, -1);
+    if (-1 == n) {
+      if (EINTR != errno) {
+        err_log("ingest epoll_wait error");
+      }
+      continue;
+    }
+
+    // The devices are read before the commands are executed, so that
+    // no event of a detached device is handled.
+    bool wake = false;
+    for (int i = 0; i < n; ++i) {
+      IngestChannel* chan = static_cast<IngestChannel*>(events[i].data.ptr);
+      if (!chan) {
+        wake = true;
+      } else if (!chan->read_device()) {
+        arm(chan, false);
+      }
+    }
+
+    if (wake) {
+      uint64_t cnt;
+      if (-1 == read(m_wake_fd, &cnt, sizeof cnt) && EAGAIN != errno) {
+        err_log("read ingest eventfd error");
+      }
+      if (!run_commands()) {
+        break;
+      }
+    }
+  }
+}
+
+bool IngestReactor::run_commands() {
+  std::deque<Command> cmds;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    cmds.swap(m_cmds);
+  }
+
+  bool run = true;
+
+  for (auto& cmd : cmds) {
+    int ret = run_command(cmd);
+
+    if (CMD_QUIT == cmd.type) {
+      run = false;
+    }
+    if (cmd.done) {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        *cmd.result = ret;
+        *cmd.done = true;
+      }
+      m_cond.notify_all();
+    }
+  }
+
+  return run;
+}
+
+int IngestReactor::run_command(const Command& cmd) {
+  IngestChannel* chan = cmd.chan;
+  int ret = 0;
+
+  switch (cmd.type) {
+    case CMD_ATTACH: {
+      struct epoll_event ev;
+
+      ev.events = EPOLLIN;
+      ev.data.ptr = chan;
+      chan->m_cur = nullptr;
+      if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, chan->m_dev_fd, &ev)) {
+        err_log("add log device %d to ingest epoll error", chan->m_dev_fd);
+        chan->m_armed = false;
+        ret = -1;
+      } else {
+        chan->m_armed = true;
+      }
+      break;
+    }
+    case CMD_DETACH:
+      epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, chan->m_dev_fd, nullptr);
+      chan->m_armed = false;
+      // Empty buffers are freed by the main thread too.
+      if (chan->m_cur) {
+        chan->commit();
+      }
+      break;
+    case CMD_FLUSH:
+      if (chan->m_cur && chan->m_cur->data_len) {
+        chan->commit();
+      }
+      break;
+    case CMD_RESUME:
+      if (!chan->m_armed) {
+        ret = arm(chan, true);
+      }
+      break;
+    default:  // CMD_QUIT
+      break;
+  }
+
+  return ret;
+}
+
+int IngestReactor::arm(IngestChannel* chan, bool on) {
+  struct epoll_event ev;
+
+  ev.events = on ? static_cast<uint32_t>(EPOLLIN) : 0u;
+  ev.data.ptr = chan;
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, chan->m_dev_fd, &ev)) {
+    err_log("%s log device %d error", on ? "arm" : "disarm",
+            chan->m_dev_fd);
+    return -1;
+  }
+  chan->m_armed = on;
+
+  return 0;
+}
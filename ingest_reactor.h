@@ -0,0 +1,218 @@
+/*
+ *  ingest_reactor.h - read log devices on a dedicated thread.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _INGEST_REACTOR_H_
+#define _INGEST_REACTOR_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "cp_log_cmn.h"
+#include "data_buf.h"
+#include "fd_hdl.h"
+#include "spsc_queue.h"
+
+class CpStorage;
+class IngestReactor;
+
+/*  IngestChannel - the main thread end of a log device read by the
+ *                  IngestReactor thread.
+ *
+ *  The main thread keeps the ring of free buffers filled from the
+ *  CpStorage. The reactor reads the device into them and passes the
+ *  filled buffers back through the other ring, then signals the
+ *  eventfd of the channel, which is polled by the main Multiplexer.
+ *
+ *  All methods except read_device() are called by the main thread.
+ */
+class IngestChannel : public FdHandler {
+ public:
+  enum Event {
+    IE_DATA,
+    IE_ERROR
+  };
+
+  /*  event_callback_t - the channel event callback.
+   *  @client: the client parameter of the constructor.
+   *  @evt: IE_DATA when len bytes are passed to the storage, IE_ERROR
+   *        when the device read failed. The channel is still attached
+   *        on IE_ERROR.
+   */
+  typedef void (*event_callback_t)(void* client, Event evt, size_t len);
+
+  IngestChannel(LogController* ctrl, Multiplexer* multi,
+                IngestReactor* reactor, void* client,
+                event_callback_t cb);
+  ~IngestChannel();
+
+  /*  init - create the eventfd and register it in the multiplexer.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int init();
+
+  bool attached() const { return m_attached; }
+
+  /*  attach - start reading the device on the reactor thread.
+   *  @dev_fd: the non-blocking log device. It shall not be read or
+   *           closed by the caller until detach() returns.
+   *  @stor: the storage to get buffers from and write the log to.
+   *  @commit_threshold: a buffer is passed to the storage when it
+   *                     contains at least commit_threshold bytes.
+   *  @free_bufs: the number of free buffers given to the reactor.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int attach(int dev_fd, CpStorage* stor, size_t commit_threshold,
+             size_t free_bufs);
+  /*  detach - stop reading the device and write the buffered log.
+   *
+   *  When detach() returns the reactor doesn't access the device any
+   *  more and all buffers are returned to the storage.
+   */
+  void detach();
+  /*  flush - write the partially filled buffer of the reactor.
+   */
+  void flush();
+  /*  refill - fill the free buffer ring from the storage.
+   */
+  void refill();
+  /*  set_commit_threshold - change the commit threshold of the
+   *                         attached channel.
+   */
+  void set_commit_threshold(size_t size) {
+    m_commit_threshold.store(size, std::memory_order_relaxed);
+  }
+  /*  pending_stamp - CLOCK_MONOTONIC ms when the first byte of the
+   *                  buffer being read into by the reactor is read, 0
+   *                  if the buffer is empty.
+   */
+  uint64_t pending_stamp() const {
+    return m_pending_stamp.load(std::memory_order_relaxed);
+  }
+
+  void process(int events) override;
+
+ private:
+  friend class IngestReactor;
+
+  static const size_t RING_SIZE = 32;
+
+  IngestReactor* m_reactor;
+  void* m_client;
+  event_callback_t m_cb;
+  CpStorage* m_storage;
+  bool m_attached;
+  size_t m_free_target;
+  // Set before the channel is attached
+  int m_dev_fd;
+  std::atomic<size_t> m_commit_threshold;
+  std::atomic<uint64_t> m_pending_stamp;
+  // Buffers to read into, from the main thread to the reactor
+  SpscQueue<DataBuffer*, RING_SIZE> m_free;
+  // Buffers filled, from the reactor to the main thread
+  SpscQueue<DataBuffer*, RING_SIZE> m_filled;
+  // The reactor is waiting for free buffers
+  std::atomic<bool> m_starved;
+  std::atomic<bool> m_error;
+  // Used by the reactor thread only
+  DataBuffer* m_cur;
+  bool m_armed;
+
+  /*  deliver - write the filled buffers to the storage.
+   */
+  void deliver();
+  /*  read_device - read the device until EAGAIN (reactor thread).
+   *
+   *  Return false if the device shall not be polled any more.
+   */
+  bool read_device();
+  /*  commit - pass the current buffer to the main thread (reactor
+   *           thread).
+   */
+  void commit();
+  void notify();
+};
+
+/*  IngestReactor - the thread reading the attached log devices.
+ *
+ *  The thread has its own epoll set so that slow callbacks on the main
+ *  thread don't delay draining the log devices. The commands from the
+ *  main thread are queued and executed between the epoll waits, and the
+ *  main thread waits for the result, so the reactor never accesses a
+ *  device after it's detached.
+ */
+class IngestReactor {
+ public:
+  IngestReactor();
+  IngestReactor(const IngestReactor&) = delete;
+  ~IngestReactor();
+
+  IngestReactor& operator = (const IngestReactor&) = delete;
+
+  /*  start - create the epoll set and start the reactor thread.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int start();
+
+  int attach(IngestChannel* chan) { return execute(CMD_ATTACH, chan); }
+  void detach(IngestChannel* chan) { execute(CMD_DETACH, chan); }
+  void flush(IngestChannel* chan) { execute(CMD_FLUSH, chan); }
+  /*  resume - poll the device again after free buffers are added.
+   *
+   *  The function doesn't wait for the reactor.
+   */
+  void resume(IngestChannel* chan);
+
+ private:
+  enum CommandType {
+    CMD_ATTACH,
+    CMD_DETACH,
+    CMD_FLUSH,
+    CMD_RESUME,
+    CMD_QUIT
+  };
+
+  struct Command {
+    CommandType type;
+    IngestChannel* chan;
+    // Result and completion flag of a synchronous command
+    int* result;
+    bool* done;
+  };
+
+  std::thread m_thread;
+  int m_epoll_fd;
+  // eventfd to wake up the reactor for the commands
+  int m_wake_fd;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::deque<Command> m_cmds;
+
+  /*  execute - execute the command on the reactor thread.
+   *
+   *  Return the command result.
+   */
+  int execute(CommandType type, IngestChannel* chan);
+  void post(const Command& cmd);
+  void run();
+  /*  run_commands - execute the queued commands.
+   *
+   *  Return false if the reactor shall quit.
+   */
+  bool run_commands();
+  int run_command(const Command& cmd);
+  int arm(IngestChannel* chan, bool on);
+};
+
+#endif  // !_INGEST_REACTOR_H_
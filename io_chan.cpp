@@ -8,34 +8,47 @@
  *  Initial version.
  */
 
+#include <algorithm>
 #include <poll.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "cp_log_cmn.h"
+#include "def_config.h"
 #include "io_chan.h"
 #include "log_file.h"
+#include "log_frame.h"
 #include "multiplexer.h"
 
-IoChannel::IoChannel(LogController* ctrl, Multiplexer* multiplexer)
+IoChannel::IoChannel(LogController* ctrl, Multiplexer* multiplexer,
+                     unsigned thread_num)
     :FdHandler{-1, ctrl, multiplexer},
-     m_state{IS_IDLE},
-     m_cur_req{nullptr},
-     m_block_vec{nullptr},
-     m_vec_num{0},
+     m_thread_num{thread_num ? thread_num : 1},
+     m_vec_hint{0},
+     m_quit{false},
      m_inited{false},
-     m_thread_sock{-1} {}
+     m_thread_sock{-1},
+     m_use_ring{false},
+     m_ring_encoder{nullptr},
+     m_max_latency{0} {}
 
 IoChannel::~IoChannel() {
   if (m_inited) {
     stop();
 
-    ::close(m_thread_sock);
+    if (m_thread_sock >= 0) {
+      ::close(m_thread_sock);
+    }
+    pthread_cond_destroy(&m_done_cond);
+    pthread_cond_destroy(&m_req_cond);
     pthread_mutex_destroy(&m_mutex);
   }
 
-  delete [] m_block_vec;
+  clear_ptr_container(m_free_ring_io);
+  delete m_ring_encoder;
 }
 
 int IoChannel::init() {
@@ -43,28 +56,66 @@ int IoChannel::init() {
     return -1;
   }
 
+  int err = pthread_mutex_init(&m_mutex, nullptr);
+  if (err) {
+    err_log("pthread_mutex_init error %d", err);
+    return -1;
+  }
+
+  err = pthread_cond_init(&m_req_cond, nullptr);
+  if (err) {
+    err_log("pthread_cond_init error %d", err);
+    goto destroyMutex;
+  }
+
+  err = pthread_cond_init(&m_done_cond, nullptr);
+  if (err) {
+    err_log("pthread_cond_init error %d", err);
+    goto destroyReqCond;
+  }
+
+  if (!init_ring()) {
+    info_log("io_uring log writer");
+    multiplexer()->register_fd(this, POLLIN);
+    m_inited = true;
+    return 0;
+  }
+
   // Create the sockets for communication with I/O thread
   int sock_fds[2];
-  int err = socketpair(AF_LOCAL, SOCK_STREAM, 0, sock_fds);
 
+  err = socketpair(AF_LOCAL, SOCK_STREAM, 0, sock_fds);
   if (-1 == err) {
     err_log("socketpair error");
-    return -1;
+    goto destroyDoneCond;
   }
 
+  // Several results may be reported before the client thread reads
+  // the socket, so the client side shall not block on read.
+  set_nonblock(sock_fds[0]);
+
   m_fd = sock_fds[0];
   m_thread_sock = sock_fds[1];
 
-  err = pthread_mutex_init(&m_mutex, nullptr);
-  if (err) {
-    err_log("pthread_mutex_init error %d", err);
-    goto clSock;
+  m_quit = false;
+  for (unsigned i = 0; i < m_thread_num; ++i) {
+    IoWorker* worker = new IoWorker;
+
+    worker->chan = this;
+    worker->block_vec = nullptr;
+    worker->vec_num = 0;
+    worker->encoder = nullptr;
+    err = pthread_create(&worker->thread, nullptr, io_thread_func, worker);
+    if (err) {
+      err_log("pthread_create error %d", err);
+      delete worker;
+      break;
+    }
+    m_workers.push_back(worker);
   }
 
-  err = pthread_create(&m_thread, nullptr, io_thread_func, this);
-  if (err) {
-    err_log("pthread_create error %d", err);
-    goto destroyMutex;
+  if (m_workers.empty()) {
+    goto clSock;
   }
 
   multiplexer()->register_fd(this, POLLIN);
@@ -72,47 +123,90 @@ int IoChannel::init() {
 
   return 0;
 
-destroyMutex:
-  pthread_mutex_destroy(&m_mutex);
 clSock:
   ::close(sock_fds[0]);
   ::close(sock_fds[1]);
   m_fd = -1;
   m_thread_sock = -1;
+destroyDoneCond:
+  pthread_cond_destroy(&m_done_cond);
+destroyReqCond:
+  pthread_cond_destroy(&m_req_cond);
+destroyMutex:
+  pthread_mutex_destroy(&m_mutex);
   return -1;
 }
 
+int IoChannel::init_ring() {
+  if (m_ring.init(IO_RING_ENTRIES)) {
+    return -1;
+  }
+
+  int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (-1 == efd) {
+    err_log("eventfd error");
+    m_ring.close();
+    return -1;
+  }
+
+  if (m_ring.register_eventfd(efd)) {
+    ::close(efd);
+    m_ring.close();
+    return -1;
+  }
+
+  m_fd = efd;
+  m_use_ring = true;
+
+  return 0;
+}
+
 void IoChannel::stop() {
-  if (!m_inited) {
+  if (m_use_ring) {
+    // Wait for the submitted writes, the pending requests are
+    // submitted when the previous writes on the files finish.
+    while (!m_busy_files.empty()) {
+      ring_wait();
+    }
     return;
   }
 
-  if (IS_EXECUTING == m_state) {
-    info_log("m_data_written wait io");
-    wait_io();
+  if (!m_inited || m_workers.empty()) {
+    return;
   }
 
-  send_simple_req(ITMT_QUIT);
-  pthread_join(m_thread, nullptr);
-}
+  // The writer threads finish the queued requests before they exit.
+  pthread_mutex_lock(&m_mutex);
+  m_quit = true;
+  pthread_cond_broadcast(&m_req_cond);
+  pthread_mutex_unlock(&m_mutex);
 
-void IoChannel::set_block_num_hint(int num) {
-  if (m_vec_num < num) {
-    delete [] m_block_vec;
-    m_block_vec = new struct iovec[num];
-    m_vec_num = num;
+  for (auto worker : m_workers) {
+    pthread_join(worker->thread, nullptr);
+    delete [] worker->block_vec;
+    delete worker->encoder;
+    delete worker;
   }
+  m_workers.clear();
 }
 
-int IoChannel::send_simple_req(IoThreadMessageType req) {
-  uint8_t msg = static_cast<uint8_t>(req);
-  ssize_t nwr = write(fd(), &msg, sizeof msg);
+void IoChannel::set_block_num_hint(int num) {
+  bool lock = m_inited && !m_use_ring;
 
-  return sizeof msg == static_cast<size_t>(nwr) ? 0 : -1;
+  if (lock) {
+    pthread_mutex_lock(&m_mutex);
+  }
+  if (m_vec_hint < num) {
+    m_vec_hint = num;
+  }
+  if (lock) {
+    pthread_mutex_unlock(&m_mutex);
+  }
 }
 
 int IoChannel::request(IoRequest* req) {
-  if (IS_EXECUTING == m_state) {
+  if (IS_IDLE != req->state) {
     err_log("request when busy");
     return -1;
   }
@@ -124,159 +218,464 @@ int IoChannel::request(IoRequest* req) {
     return -1;
   }
 
-  m_cur_req = req;
-  pthread_mutex_unlock(&m_mutex);
-
-  size_t nwr;
-  uint8_t msg = ITMT_IO;
-
-  nwr = write(fd(), &msg, sizeof msg);
-  if (sizeof msg != static_cast<size_t>(nwr)) {
-    m_cur_req = nullptr;
-    err_log("send request to I/O thread error");
+  if (!m_use_ring && m_workers.empty()) {
+    pthread_mutex_unlock(&m_mutex);
+    err_log("no I/O thread");
     return -1;
   }
-  m_state = IS_EXECUTING;
+
+  req->state = IS_QUEUED;
+  clock_gettime(CLOCK_MONOTONIC, &req->queue_time);
+  m_pending.push_back(req);
+  if (m_use_ring) {
+    ring_submit();
+  } else {
+    pthread_cond_signal(&m_req_cond);
+  }
+  pthread_mutex_unlock(&m_mutex);
+
   return 0;
 }
 
-void IoChannel::process(int events) {
-  uint8_t msg;
+void IoChannel::process(int /*events*/) {
+  if (m_use_ring) {
+    uint64_t cnt;
+
+    if (-1 == read(fd(), &cnt, sizeof cnt) && EAGAIN != errno) {
+      err_log("read io_uring eventfd error");
+    }
+    ring_reap();
+    on_io_done();
+    return;
+  }
+
+  uint8_t msg[32];
   ssize_t nr;
 
-  nr = read(fd(), &msg, sizeof msg);
+  // Drain the notifications: one byte is sent for each finished request.
+  do {
+    nr = read(fd(), msg, sizeof msg);
+  } while (static_cast<ssize_t>(sizeof msg) == nr);
+
   if (!nr) {
     err_log("I/O thread close the message socket");
-  } else if (-1 == nr) {
+  } else if (-1 == nr && EAGAIN != errno && EINTR != errno) {
     err_log("read I/O thread message error");
-  } else {
-    if (ITMT_IO_RESULT == msg) {
-      on_io_done();
-    } else {
-      err_log("unknown response %d", msg);
-    }
   }
+
+  on_io_done();
 }
 
-void* IoChannel::io_thread_func(void* param) {
-  IoChannel* chan = static_cast<IoChannel*>(param);
-  uint8_t msg;
-  ssize_t nr;
-  bool run = true;
+bool IoChannel::file_busy(const LogFile* f) const {
+  return m_busy_files.end() !=
+         std::find(m_busy_files.begin(), m_busy_files.end(), f);
+}
+
+IoChannel::IoRequest* IoChannel::fetch_request() {
+  IoRequest* req = nullptr;
 
-  while (run) {
-    nr = read(chan->m_thread_sock, &msg, sizeof msg);
-    if (!nr) {
-      err_log("socket closed");
+  for (auto it = m_pending.begin(); it != m_pending.end(); ++it) {
+    // Keep the write order of the stream: skip the request if an
+    // earlier request on the same file is being executed.
+    if (!file_busy((*it)->file)) {
+      req = *it;
+      m_pending.erase(it);
       break;
     }
-    if (-1 == nr) {
-      err_log("read error");
+  }
+
+  return req;
+}
+
+void* IoChannel::io_thread_func(void* param) {
+  IoWorker* worker = static_cast<IoWorker*>(param);
+  IoChannel* chan = worker->chan;
+
+  pthread_mutex_lock(&chan->m_mutex);
+  while (true) {
+    IoRequest* req = chan->fetch_request();
+
+    if (!req) {
+      if (chan->m_quit && chan->m_pending.empty()) {
+        break;
+      }
+      pthread_cond_wait(&chan->m_req_cond, &chan->m_mutex);
       continue;
     }
 
-    switch (msg) {
-      case ITMT_IO:  // I/O request
-        chan->do_io();
-        break;
-      case ITMT_QUIT:
-        run = false;
-        break;
-      default:
-        chan->send_response(ITMT_UNKNOWN_REQ);
-        break;
+    req->state = IS_EXECUTING;
+    chan->m_busy_files.push_back(req->file);
+    if (worker->vec_num < chan->m_vec_hint) {
+      delete [] worker->block_vec;
+      worker->block_vec = new struct iovec[chan->m_vec_hint];
+      worker->vec_num = chan->m_vec_hint;
     }
-  }
+    pthread_mutex_unlock(&chan->m_mutex);
 
-  return nullptr;
-}
+    chan->do_io(worker, req);
 
-int IoChannel::send_response(IoThreadMessageType resp) {
-  uint8_t msg = static_cast<uint8_t>(resp);
-  ssize_t nwr = write(m_thread_sock, &msg, sizeof msg);
+    pthread_mutex_lock(&chan->m_mutex);
+    auto it = std::find(chan->m_busy_files.begin(),
+                        chan->m_busy_files.end(), req->file);
+    if (it != chan->m_busy_files.end()) {
+      chan->m_busy_files.erase(it);
+    }
+    req->state = IS_DONE;
+    chan->m_done.push_back(req);
+    pthread_cond_broadcast(&chan->m_done_cond);
+    // Requests on the file may be executed by other threads now.
+    if (!chan->m_pending.empty()) {
+      pthread_cond_broadcast(&chan->m_req_cond);
+    }
+    pthread_mutex_unlock(&chan->m_mutex);
+
+    // Send response to the client thread
+    uint8_t msg = 1;
+    if (1 != write(chan->m_thread_sock, &msg, 1)) {
+      err_log("send I/O response error");
+    }
+
+    pthread_mutex_lock(&chan->m_mutex);
+  }
+  pthread_mutex_unlock(&chan->m_mutex);
 
-  return sizeof msg == static_cast<size_t>(nwr) ? 0 : -1;
+  return nullptr;
 }
 
-void IoChannel::do_io() {
-  pthread_mutex_lock(&m_mutex);
+void IoChannel::do_io(IoWorker* worker, IoRequest* req) {
+  if (req->file->compressed()) {
+    do_framed_io(worker, req);
+    return;
+  }
 
-  std::vector<DataBuffer*>& data_list = *m_cur_req->data_list;
+  std::vector<DataBuffer*>& data_list = *req->data_list;
 
-  // Make sure m_block_vec is long enough
-  set_block_num_hint(data_list.size());
+  // Make sure block_vec is long enough
+  if (worker->vec_num < static_cast<int>(data_list.size())) {
+    delete [] worker->block_vec;
+    worker->vec_num = static_cast<int>(data_list.size());
+    worker->block_vec = new struct iovec[worker->vec_num];
+  }
 
   unsigned i;
 
   for (i = 0; i < data_list.size(); ++i) {
     DataBuffer* buf = data_list[i];
-    m_block_vec[i].iov_base = buf->buffer + buf->data_start;
-    m_block_vec[i].iov_len = buf->data_len;
+    worker->block_vec[i].iov_base = buf->buffer + buf->data_start;
+    worker->block_vec[i].iov_len = buf->data_len;
   }
-  ssize_t nwr = m_cur_req->file->write_raw(m_block_vec, static_cast<int>(i));
 
-  // Make sure m_cur_req is visible to the client thread
-  if (nwr >= 0) {
-    m_cur_req->err_code = 0;
-    m_cur_req->written = nwr;
-  } else {
-    m_cur_req->err_code = static_cast<int>(nwr);
-    m_cur_req->written = 0;
+  // Later requests of the stream may have been queued, so try to
+  // write all data of the request on short writes.
+  struct iovec* vec = worker->block_vec;
+  int vec_num = static_cast<int>(i);
+  size_t total = 0;
+  int err = 0;
+
+  while (vec_num) {
+    ssize_t nwr = req->file->write_raw(vec, vec_num);
+
+    if (nwr <= 0) {
+      err = nwr ? static_cast<int>(nwr) : -1;
+      break;
+    }
+
+    total += nwr;
+    size_t len = static_cast<size_t>(nwr);
+    while (vec_num && len >= vec->iov_len) {
+      len -= vec->iov_len;
+      ++vec;
+      --vec_num;
+    }
+    if (len) {
+      vec->iov_base = static_cast<uint8_t*>(vec->iov_base) + len;
+      vec->iov_len -= len;
+    }
   }
-  pthread_mutex_unlock(&m_mutex);
 
-  // Send response to the client thread
-  if (send_response(ITMT_IO_RESULT)) {
-    err_log("send I/O response error");
+  if (total) {
+    req->file->start_writeback(total);
+  }
+
+  // req is made visible to the client thread by m_mutex
+  req->err_code = err;
+  req->written = total;
+  req->stored = total;
+}
+
+void IoChannel::do_framed_io(IoWorker* worker, IoRequest* req) {
+  if (!worker->encoder) {
+    worker->encoder = new LogFrameEncoder;
+  }
+
+  std::vector<uint8_t>& frames = worker->frames;
+
+  frames.clear();
+  size_t raw = worker->encoder->encode(*req->data_list, frames);
+
+  struct iovec vec;
+  size_t total = 0;
+  int err = 0;
+
+  while (total < frames.size()) {
+    vec.iov_base = frames.data() + total;
+    vec.iov_len = frames.size() - total;
+
+    ssize_t nwr = req->file->write_raw(&vec, 1);
+    if (nwr <= 0) {
+      err = nwr ? static_cast<int>(nwr) : -1;
+      break;
+    }
+    total += nwr;
   }
+
+  if (total) {
+    req->file->start_writeback(total);
+  }
+
+  // A partially written frame is skipped by the decoder, and its data
+  // is written again by the scheduler.
+  req->err_code = err;
+  req->written = total == frames.size()
+                     ? raw : LogFrameEncoder::raw_written(frames, total);
+  req->stored = total;
 }
 
-void IoChannel::wait_io() {
-  struct pollfd pol;
-  int err;
+void IoChannel::wait_io(IoRequest* req) {
+  pthread_mutex_lock(&m_mutex);
+  if (IS_IDLE == req->state) {
+    pthread_mutex_unlock(&m_mutex);
+    err_log("request is idle");
+    return;
+  }
+
+  info_log("wait io");
+  if (m_use_ring) {
+    // All ring operations are done in this thread.
+    pthread_mutex_unlock(&m_mutex);
+    while (IS_DONE != req->state) {
+      ring_wait();
+    }
+    pthread_mutex_lock(&m_mutex);
+  }
+  while (IS_DONE != req->state) {
+    pthread_cond_wait(&m_done_cond, &m_mutex);
+  }
 
-  pol.fd = fd();
-  pol.events = POLLIN;
-  pol.revents = 0;
+  auto it = std::find(m_done.begin(), m_done.end(), req);
+  if (it != m_done.end()) {
+    m_done.erase(it);
+  }
+  req->state = IS_IDLE;
+  pthread_mutex_unlock(&m_mutex);
+}
+
+void IoChannel::on_io_done() {
+  // The callback may wait for other requests by wait_io(), so take
+  // the finished requests one by one.
   while (true) {
-    if(m_state == IS_IDLE) {
-      err_log("m_state == IS_IDLE.");
-      return;
+    IoRequest* req = nullptr;
+
+    // Make sure the request object is visible to this thread
+    pthread_mutex_lock(&m_mutex);
+    if (!m_done.empty()) {
+      req = m_done.front();
+      m_done.pop_front();
+      req->state = IS_IDLE;
     }
-    info_log("wait io wait for poll");
-    err = poll(&pol, 1, -1);
-    if (err > 0) {
-      uint8_t msg;
-      ssize_t nr = read(fd(), &msg, sizeof msg);
-      info_log("wait io read msg is %d", msg);
-      if (1 == nr) {
-        if (ITMT_IO_RESULT == msg) {
-          m_state = IS_IDLE;
-          m_cur_req = nullptr;
-          break;
-        }
-      } else if (!nr) {
-        err_log("message socket closed unexpectedly");
-        break;
-      } else {
-        err_log("read response error");
+    pthread_mutex_unlock(&m_mutex);
+
+    if (!req) {
+      break;
+    }
+
+    struct timespec tnow;
+    clock_gettime(CLOCK_MONOTONIC, &tnow);
+    long lat = (tnow.tv_sec - req->queue_time.tv_sec) * 1000 +
+               (tnow.tv_nsec - req->queue_time.tv_nsec) / 1000000;
+    if (lat > static_cast<long>(m_max_latency)) {
+      m_max_latency = static_cast<unsigned>(lat);
+    }
+
+    if (req->callback) {
+      req->callback(req->client, req);
+    }
+  }
+}
+
+void IoChannel::ring_submit() {
+  auto it = m_pending.begin();
+  bool finished = false;
+
+  while (it != m_pending.end() && m_ring.sq_space()) {
+    IoRequest* req = *it;
+
+    if (file_busy(req->file)) {
+      ++it;
+      continue;
+    }
+
+    RingIo* io;
+
+    if (m_free_ring_io.empty()) {
+      io = new RingIo;
+    } else {
+      io = m_free_ring_io.back();
+      m_free_ring_io.pop_back();
+    }
+
+    std::vector<DataBuffer*>& data_list = *req->data_list;
+
+    io->req = req;
+    io->vec_start = 0;
+    io->written = 0;
+    io->framed = req->file->compressed();
+    if (io->framed) {
+      if (!m_ring_encoder) {
+        m_ring_encoder = new LogFrameEncoder;
+      }
+      io->frames.clear();
+      io->raw = m_ring_encoder->encode(data_list, io->frames);
+      io->vec.clear();
+      if (!io->frames.empty()) {
+        io->vec.push_back(iovec{io->frames.data(), io->frames.size()});
       }
     } else {
-      err_log("wait io get poll error");
+      io->vec.resize(data_list.size());
+      for (size_t i = 0; i < data_list.size(); ++i) {
+        DataBuffer* buf = data_list[i];
+        io->vec[i].iov_base = buf->buffer + buf->data_start;
+        io->vec[i].iov_len = buf->data_len;
+      }
+    }
+
+    it = m_pending.erase(it);
+    req->state = IS_EXECUTING;
+    m_busy_files.push_back(req->file);
+
+    if (io->vec.empty()) {
+      ring_finish(io, 0);
+      finished = true;
+    } else if (m_ring.writev(req->file->fd(), io->vec.data(),
+                             static_cast<unsigned>(io->vec.size()),
+                             reinterpret_cast<uintptr_t>(io))) {
+      ring_write_sync(io);
+      finished = true;
+    }
+  }
+
+  if (finished) {
+    // No CQE will come for the requests finished here, so wake up
+    // process() to report them.
+    uint64_t n = 1;
+
+    if (-1 == ::write(m_fd, &n, sizeof n)) {
+      err_log("signal io_uring eventfd error");
     }
   }
 }
 
-void IoChannel::on_io_done() {
-  // Make sure the m_cur_req object is visible to this thread
-  pthread_mutex_lock(&m_mutex);
+void IoChannel::ring_reap() {
+  uint64_t user_data;
+  int res;
 
-  IoRequest* req = m_cur_req;
+  while (m_ring.reap(user_data, res)) {
+    RingIo* io =
+        reinterpret_cast<RingIo*>(static_cast<uintptr_t>(user_data));
 
-  pthread_mutex_unlock(&m_mutex);
-  m_state = IS_IDLE;
-  m_cur_req = nullptr;
-  if (req->callback) {
-    req->callback(req->client, req);
+    if (res <= 0) {
+      ring_finish(io, res ? LogFile::linux_err_to_fio_err(-res)
+                          : LogFile::FIO_ERROR);
+      continue;
+    }
+
+    if (ring_advance(io, static_cast<size_t>(res))) {
+      ring_finish(io, 0);
+      continue;
+    }
+
+    // Short write: submit the rest
+    if (m_ring.writev(io->req->file->fd(), &io->vec[io->vec_start],
+                      static_cast<unsigned>(io->vec.size() - io->vec_start),
+                      user_data)) {
+      ring_write_sync(io);
+    }
+  }
+
+  ring_submit();
+}
+
+void IoChannel::ring_wait() {
+  if (m_ring.wait()) {
+    // The kernel may still be writing the submitted data, so poll the
+    // completion queue until the writes finish.
+    usleep(RING_POLL_INTERVAL * 1000);
   }
+  ring_reap();
+}
+
+bool IoChannel::ring_advance(RingIo* io, size_t len) {
+  io->written += len;
+  while (io->vec_start < io->vec.size() &&
+         len >= io->vec[io->vec_start].iov_len) {
+    len -= io->vec[io->vec_start].iov_len;
+    ++io->vec_start;
+  }
+  if (io->vec_start == io->vec.size()) {
+    return true;
+  }
+
+  struct iovec& v = io->vec[io->vec_start];
+
+  v.iov_base = static_cast<uint8_t*>(v.iov_base) + len;
+  v.iov_len -= len;
+
+  return false;
+}
+
+void IoChannel::ring_write_sync(RingIo* io) {
+  int err = 0;
+
+  // Write the rest in this thread as the writer threads do.
+  while (io->vec_start < io->vec.size()) {
+    ssize_t nwr = io->req->file->write_raw(
+        &io->vec[io->vec_start],
+        static_cast<int>(io->vec.size() - io->vec_start));
+
+    if (nwr <= 0) {
+      err = nwr ? static_cast<int>(nwr) : -1;
+      break;
+    }
+    ring_advance(io, static_cast<size_t>(nwr));
+  }
+
+  ring_finish(io, err);
+}
+
+void IoChannel::ring_finish(RingIo* io, int err) {
+  IoRequest* req = io->req;
+
+  auto it = std::find(m_busy_files.begin(), m_busy_files.end(), req->file);
+  if (it != m_busy_files.end()) {
+    m_busy_files.erase(it);
+  }
+
+  if (io->written) {
+    req->file->start_writeback(io->written);
+  }
+
+  req->err_code = err;
+  if (!io->framed) {
+    req->written = io->written;
+  } else if (io->written == io->frames.size()) {
+    req->written = io->raw;
+  } else {
+    req->written = LogFrameEncoder::raw_written(io->frames, io->written);
+  }
+  req->stored = io->written;
+  req->state = IS_DONE;
+  m_done.push_back(req);
+
+  io->req = nullptr;
+  m_free_ring_io.push_back(io);
 }
@@ -10,14 +10,35 @@
 #ifndef _IO_CHAN_H_
 #define _IO_CHAN_H_
 
+#include <deque>
 #include <pthread.h>
+#include <time.h>
 #include <vector>
 
 #include "data_buf.h"
 #include "fd_hdl.h"
+#include "io_ring.h"
 
 class LogFile;
+class LogFrameEncoder;
 
+/*  IoChannel - the writer pool of one storage media.
+ *
+ *  All IoSchedulers writing to the same media share one IoChannel,
+ *  so that writes to the media are queued in one place and serialized
+ *  instead of competing with each other. Requests are executed in
+ *  FIFO order, and requests on the same LogFile are never executed
+ *  concurrently, so the write order of each stream is kept.
+ *
+ *  When io_uring is available (see IoRing), the writes are submitted
+ *  to the kernel directly and the completions are reported by an
+ *  eventfd, so no writer thread is used. Otherwise the writes are
+ *  executed by the writer threads.
+ *
+ *  The data of compressed log files (see log_frame.h) is compressed by
+ *  the writer threads, or by the client thread when the request is
+ *  submitted to the io_uring.
+ */
 class IoChannel : public FdHandler {
  public:
   // I/O request
@@ -26,6 +47,14 @@ class IoChannel : public FdHandler {
     IRT_ABORT
   };
 
+  // I/O request state
+  enum IoState {
+    IS_IDLE,
+    IS_QUEUED,
+    IS_EXECUTING,
+    IS_DONE
+  };
+
   struct IoRequest;
 
   typedef void (*io_result_callback_t)(void* client, IoRequest* req);
@@ -36,11 +65,24 @@ class IoChannel : public FdHandler {
     IoRequestType type;
     LogFile* file;
     std::vector<DataBuffer*>* data_list;
+    // Length of the data in data_list written
     size_t written;
+    // Number of bytes written to the file, which is less than written
+    // if the file is compressed
+    size_t stored;
     int err_code;
+    IoState state;
+    // Time when the request is queued
+    struct timespec queue_time;
   };
 
-  IoChannel(LogController* ctrl, Multiplexer* multiplexer);
+  /*  IoChannel - constructor
+   *  @ctrl: the LogController object
+   *  @multiplexer: the Multiplexer object
+   *  @thread_num: number of writer threads of the channel
+   */
+  IoChannel(LogController* ctrl, Multiplexer* multiplexer,
+            unsigned thread_num = 1);
   ~IoChannel();
 
   int init();
@@ -51,50 +93,139 @@ class IoChannel : public FdHandler {
    */
   void set_block_num_hint(int num);
 
+  /*  request - queue the I/O request.
+   *  @req: the I/O request. req shall not be queued already.
+   *
+   *  Return 0 on success, -1 on error.
+   */
   int request(IoRequest* req);
-  /*  wiat_io - wait for the background I/O to finish.
+  /*  wait_io - wait for the background I/O of the request to finish.
+   *  @req: the I/O request to wait for.
    *
-   *  When the I/O is finished, this function will reset the I/O state
-   *  to idle and will not call the result callback.
+   *  When the I/O is finished, this function will reset the state of
+   *  req to idle and will not call the result callback.
    */
-  void wait_io();
+  void wait_io(IoRequest* req);
 
   void process(int events) override;
 
+  /*  take_max_latency - get the max latency of the requests finished
+   *                     since the last call.
+   *
+   *  The latency is the time from request() to the result callback.
+   *
+   *  Return the latency in milliseconds.
+   */
+  unsigned take_max_latency() {
+    unsigned lat = m_max_latency;
+
+    m_max_latency = 0;
+    return lat;
+  }
+
  private:
-  enum IoState {
-    IS_IDLE,
-    IS_EXECUTING
+  // Writer thread
+  struct IoWorker {
+    IoChannel* chan;
+    pthread_t thread;
+    // iovec array for I/O
+    struct iovec* block_vec;
+    int vec_num;
+    // Frame encoder of compressed files, created on the first use
+    LogFrameEncoder* encoder;
+    std::vector<uint8_t> frames;
   };
 
-  // Commands and responses to the I/O thread
-  enum IoThreadMessageType {
-    // Requests
-    ITMT_IO,
-    ITMT_QUIT,
-    // Responses
-    ITMT_IO_RESULT = 100,
-    ITMT_UNKNOWN_REQ
+  // Write submitted to the io_uring
+  struct RingIo {
+    IoRequest* req;
+    std::vector<struct iovec> vec;
+    // First iovec not written
+    size_t vec_start;
+    size_t written;
+    // The frames written to a compressed file
+    bool framed;
+    std::vector<uint8_t> frames;
+    // Data length of the frames
+    size_t raw;
   };
 
-  IoState m_state;
-  IoRequest* m_cur_req;
-  // iovec array for I/O
-  struct iovec* m_block_vec;
-  int m_vec_num;
-  // Whether the thread is created
+  // Number of writer threads
+  unsigned m_thread_num;
+  std::vector<IoWorker*> m_workers;
+  // Requests waiting for a writer thread
+  std::deque<IoRequest*> m_pending;
+  // Requests finished and not reported to the client
+  std::deque<IoRequest*> m_done;
+  // Files being written by writer threads
+  std::vector<LogFile*> m_busy_files;
+  // Minimum length of the iovec array
+  int m_vec_hint;
+  // Whether the writer threads shall exit
+  bool m_quit;
+  // Whether the threads are created
   bool m_inited;
-  // Mutex to guarantee memory visibility to the client thread and the
-  // I/O thread
+  // Mutex to protect the request queues and to guarantee memory
+  // visibility to the client thread and the writer threads
   pthread_mutex_t m_mutex;
-  pthread_t m_thread;
-  // Socket used by the I/O thread
+  // Signaled when a new request is queued or a file becomes idle
+  pthread_cond_t m_req_cond;
+  // Signaled when a request is finished
+  pthread_cond_t m_done_cond;
+  // Socket used by the writer threads to inform the client thread
   int m_thread_sock;
-
-  void do_io();
+  // io_uring backend
+  IoRing m_ring;
+  bool m_use_ring;
+  // Idle RingIo objects
+  std::vector<RingIo*> m_free_ring_io;
+  // Frame encoder of the io_uring backend
+  LogFrameEncoder* m_ring_encoder;
+  // Max latency of the finished requests in ms
+  unsigned m_max_latency;
+
+  /*  fetch_request - get the first pending request that can be executed.
+   *
+   *  This function shall be called with m_mutex locked.
+   */
+  IoRequest* fetch_request();
+  bool file_busy(const LogFile* f) const;
+  void do_io(IoWorker* worker, IoRequest* req);
+  /*  do_framed_io - compress the data and write the frames to the
+   *                 compressed file.
+   */
+  void do_framed_io(IoWorker* worker, IoRequest* req);
   void on_io_done();
-  int send_simple_req(IoThreadMessageType req);
-  int send_response(IoThreadMessageType resp);
+
+  /*  init_ring - set up the io_uring backend.
+   *
+   *  Return 0 on success, -1 if io_uring is not available.
+   */
+  int init_ring();
+  /*  ring_submit - submit pending requests whose file is not busy.
+   *
+   *  The requests finished without the ring are reported through the
+   *  eventfd as well.
+   */
+  void ring_submit();
+  /*  ring_reap - process io_uring completions.
+   */
+  void ring_reap();
+  /*  ring_wait - wait for io_uring completions and process them.
+   */
+  void ring_wait();
+  /*  ring_advance - skip the data written.
+   *  @len: number of bytes written.
+   *
+   *  Return true if all data of io is written.
+   */
+  bool ring_advance(RingIo* io, size_t len);
+  /*  ring_write_sync - write the rest of io synchronously.
+   *
+   *  Used when the write can not be submitted to the io_uring.
+   */
+  void ring_write_sync(RingIo* io);
+  void ring_finish(RingIo* io, int err);
 
   static void* io_thread_func(void* param);
 };
@@ -0,0 +1,285 @@
+/*
+ *  io_ring.cpp - io_uring submission/completion ring.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "cp_log_cmn.h"
+#include "io_ring.h"
+
+#if defined(SUPPORT_IO_URING) && defined(__NR_io_uring_setup)
+#include <linux/io_uring.h>
+#define IO_RING_AVAILABLE
+#endif
+
+IoRing::IoRing()
+    :m_ring_fd{-1},
+     m_sq_ptr{MAP_FAILED},
+     m_sq_map_size{0},
+     m_sq_head{nullptr},
+     m_sq_tail{nullptr},
+     m_sq_mask{nullptr},
+     m_sq_array{nullptr},
+     m_sq_entries{0},
+     m_sqes{MAP_FAILED},
+     m_sqes_size{0},
+     m_cq_ptr{MAP_FAILED},
+     m_cq_map_size{0},
+     m_cq_head{nullptr},
+     m_cq_tail{nullptr},
+     m_cq_mask{nullptr},
+     m_cqes{nullptr} {}
+
+IoRing::~IoRing() {
+  close();
+}
+
+#ifdef IO_RING_AVAILABLE
+
+int IoRing::init(unsigned entries) {
+  if (m_ring_fd >= 0) {
+    return -1;
+  }
+
+  struct io_uring_params p;
+
+  memset(&p, 0, sizeof p);
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &p));
+  if (-1 == fd) {
+    info_log("io_uring_setup error %d", errno);
+    return -1;
+  }
+
+  // Writes at the current file position need IORING_FEAT_RW_CUR_POS.
+  if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+    info_log("io_uring does not support current position writes");
+    ::close(fd);
+    return -1;
+  }
+
+  m_ring_fd = fd;
+  m_sq_map_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  m_cq_map_size = p.cq_off.cqes +
+                  p.cq_entries * sizeof(struct io_uring_cqe);
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    if (m_cq_map_size > m_sq_map_size) {
+      m_sq_map_size = m_cq_map_size;
+    }
+    m_cq_map_size = m_sq_map_size;
+  }
+
+  m_sq_ptr = mmap(nullptr, m_sq_map_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (MAP_FAILED == m_sq_ptr) {
+    err_log("mmap SQ ring error");
+    close();
+    return -1;
+  }
+
+  if (p.features & IORING_FEAT_SINGLE_MMAP) {
+    m_cq_ptr = m_sq_ptr;
+  } else {
+    m_cq_ptr = mmap(nullptr, m_cq_map_size, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (MAP_FAILED == m_cq_ptr) {
+      err_log("mmap CQ ring error");
+      close();
+      return -1;
+    }
+  }
+
+  m_sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+  m_sqes = mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (MAP_FAILED == m_sqes) {
+    err_log("mmap SQEs error");
+    close();
+    return -1;
+  }
+
+  uint8_t* sq = static_cast<uint8_t*>(m_sq_ptr);
+  m_sq_head = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+  m_sq_tail = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+  m_sq_mask = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+  m_sq_array = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+  m_sq_entries = p.sq_entries;
+
+  uint8_t* cq = static_cast<uint8_t*>(m_cq_ptr);
+  m_cq_head = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+  m_cq_tail = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+  m_cq_mask = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+  m_cqes = cq + p.cq_off.cqes;
+
+  return 0;
+}
+
+unsigned IoRing::sq_space() const {
+  if (m_ring_fd < 0) {
+    return 0;
+  }
+
+  unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+
+  return m_sq_entries - (*m_sq_tail - head);
+}
+
+int IoRing::register_eventfd(int efd) {
+  if (m_ring_fd < 0) {
+    return -1;
+  }
+
+  int err = static_cast<int>(syscall(__NR_io_uring_register, m_ring_fd,
+                                     IORING_REGISTER_EVENTFD, &efd, 1));
+  if (-1 == err) {
+    err_log("IORING_REGISTER_EVENTFD error %d", errno);
+  }
+
+  return err ? -1 : 0;
+}
+
+int IoRing::writev(int fd, const struct iovec* iov, unsigned cnt,
+                   uint64_t user_data) {
+  if (!sq_space()) {
+    return -1;
+  }
+
+  unsigned tail = *m_sq_tail;
+  unsigned index = tail & *m_sq_mask;
+  struct io_uring_sqe* sqe =
+      static_cast<struct io_uring_sqe*>(m_sqes) + index;
+
+  memset(sqe, 0, sizeof *sqe);
+  sqe->opcode = IORING_OP_WRITEV;
+  sqe->fd = fd;
+  // -1 means the current file position
+  sqe->off = static_cast<uint64_t>(-1);
+  sqe->addr = reinterpret_cast<uintptr_t>(iov);
+  sqe->len = cnt;
+  sqe->user_data = user_data;
+
+  m_sq_array[index] = index;
+  __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+  // SQEs not consumed by the kernel in previous calls are submitted
+  // together with this one.
+  unsigned to_submit =
+      tail + 1 - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+  int ret;
+
+  do {
+    ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ring_fd,
+                                   to_submit, 0, 0, nullptr, 0));
+  } while (-1 == ret && EINTR == errno);
+
+  if (-1 == ret) {
+    err_log("io_uring_enter submit error %d", errno);
+  }
+
+  // Take the SQE back if the kernel has not consumed it, so that the
+  // caller keeps the ownership of the data.
+  unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+  if (static_cast<int>(head - (tail + 1)) < 0) {
+    __atomic_store_n(m_sq_tail, tail, __ATOMIC_RELEASE);
+    return -1;
+  }
+
+  return 0;
+}
+
+int IoRing::wait() {
+  if (m_ring_fd < 0) {
+    return -1;
+  }
+
+  int ret;
+
+  do {
+    ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ring_fd, 0, 1,
+                                   IORING_ENTER_GETEVENTS, nullptr, 0));
+  } while (-1 == ret && EINTR == errno);
+
+  if (-1 == ret) {
+    err_log("io_uring_enter wait error %d", errno);
+  }
+
+  return -1 == ret ? -1 : 0;
+}
+
+bool IoRing::reap(uint64_t& user_data, int& res) {
+  if (m_ring_fd < 0) {
+    return false;
+  }
+
+  unsigned head = *m_cq_head;
+
+  if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+
+  const struct io_uring_cqe* cqe =
+      static_cast<const struct io_uring_cqe*>(m_cqes) + (head & *m_cq_mask);
+
+  user_data = cqe->user_data;
+  res = cqe->res;
+  __atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+
+  return true;
+}
+
+#else  // !IO_RING_AVAILABLE
+
+int IoRing::init(unsigned /*entries*/) {
+  return -1;
+}
+
+unsigned IoRing::sq_space() const {
+  return 0;
+}
+
+int IoRing::register_eventfd(int /*efd*/) {
+  return -1;
+}
+
+int IoRing::writev(int /*fd*/, const struct iovec* /*iov*/,
+                   unsigned /*cnt*/, uint64_t /*user_data*/) {
+  return -1;
+}
+
+int IoRing::wait() {
+  return -1;
+}
+
+bool IoRing::reap(uint64_t& /*user_data*/, int& /*res*/) {
+  return false;
+}
+
+#endif  // IO_RING_AVAILABLE
+
+void IoRing::close() {
+  if (MAP_FAILED != m_sqes) {
+    munmap(m_sqes, m_sqes_size);
+    m_sqes = MAP_FAILED;
+  }
+  if (MAP_FAILED != m_cq_ptr && m_cq_ptr != m_sq_ptr) {
+    munmap(m_cq_ptr, m_cq_map_size);
+  }
+  m_cq_ptr = MAP_FAILED;
+  if (MAP_FAILED != m_sq_ptr) {
+    munmap(m_sq_ptr, m_sq_map_size);
+    m_sq_ptr = MAP_FAILED;
+  }
+  if (m_ring_fd >= 0) {
+    ::close(m_ring_fd);
+    m_ring_fd = -1;
+  }
+}
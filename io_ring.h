@@ -0,0 +1,102 @@
+/*
+ *  io_ring.h - io_uring submission/completion ring.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _IO_RING_H_
+#define _IO_RING_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/*  IoRing - thin wrapper of the io_uring system calls.
+ *
+ *  The ring is used by IoChannel to submit writes to the kernel
+ *  without a writer thread. It is only available when the daemon is
+ *  built with SUPPORT_IO_URING and the kernel supports io_uring
+ *  writes at the current file position (Linux 5.6 or later). On other
+ *  systems init() fails and IoChannel keeps using the writer threads.
+ */
+class IoRing {
+ public:
+  IoRing();
+  ~IoRing();
+
+  IoRing(const IoRing&) = delete;
+  IoRing& operator = (const IoRing&) = delete;
+
+  /*  init - create the ring.
+   *  @entries: number of submission queue entries.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int init(unsigned entries);
+  void close();
+
+  bool inited() const { return m_ring_fd >= 0; }
+  /*  sq_space - number of free submission queue entries.
+   */
+  unsigned sq_space() const;
+
+  /*  register_eventfd - signal the eventfd on each completion.
+   *  @efd: the eventfd.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int register_eventfd(int efd);
+
+  /*  writev - submit a writev at the current file position.
+   *  @fd: the file descriptor.
+   *  @iov: the data blocks, which shall be valid until the completion
+   *        is reaped.
+   *  @cnt: number of blocks.
+   *  @user_data: the value returned by reap() on completion.
+   *
+   *  Return 0 if the request is submitted, -1 if it is not, in which
+   *  case the kernel does not use iov.
+   */
+  int writev(int fd, const struct iovec* iov, unsigned cnt,
+             uint64_t user_data);
+
+  /*  wait - wait for at least one completion.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int wait();
+
+  /*  reap - get one completion.
+   *  @user_data: the user_data of the finished request.
+   *  @res: the result of the request (negative errno on error).
+   *
+   *  Return true if a completion is got, false if the completion
+   *  queue is empty.
+   */
+  bool reap(uint64_t& user_data, int& res);
+
+ private:
+  int m_ring_fd;
+  // Submission queue
+  void* m_sq_ptr;
+  size_t m_sq_map_size;
+  unsigned* m_sq_head;
+  unsigned* m_sq_tail;
+  unsigned* m_sq_mask;
+  unsigned* m_sq_array;
+  unsigned m_sq_entries;
+  void* m_sqes;
+  size_t m_sqes_size;
+  // Completion queue
+  void* m_cq_ptr;
+  size_t m_cq_map_size;
+  unsigned* m_cq_head;
+  unsigned* m_cq_tail;
+  unsigned* m_cq_mask;
+  void* m_cqes;
+};
+
+#endif  // !_IO_RING_H_
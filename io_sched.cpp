@@ -11,6 +11,8 @@
 #include "cp_log_cmn.h"
 #include "io_sched.h"
 #include "log_file.h"
+#include "log_frame.h"
+#include "log_index.h"
 
 IoScheduler::IoScheduler()
     :m_channel{nullptr},
@@ -20,24 +22,29 @@ IoScheduler::IoScheduler()
      m_block_size{65536},
      m_max_blocks{8},
      m_commit_threshold{65536},
-     m_writing_len{0},
-     m_cur_req{io_result_callback, this,
-               IoChannel::IRT_WRITE, nullptr,
-               nullptr, 0, 0},
+     m_pool{nullptr},
+     m_pool_client{nullptr},
+     m_max_requests{0},
      m_buf_avail_cb{nullptr},
      m_buf_client{nullptr},
-     m_report_buf_avail{false} {}
+     m_report_buf_avail{false},
+     m_frames_started{false} {
+  set_max_requests(1);
+}
 
 IoScheduler::~IoScheduler() {
-  if (m_data_written.size()) {
-    info_log("m_data_written wait io");
-    m_channel->wait_io();
-    process_io_result();
+  if (m_in_flight.size()) {
+    info_log("m_in_flight wait io");
+    wait_all();
   }
 
+  if (m_pool_client) {
+    discard_queue();
+    m_pool->remove_client(m_pool_client);
+  }
   free_buffers(m_buffers);
   clear_ptr_container(m_data);
-  clear_ptr_container(m_data_written);
+  clear_ptr_container(m_requests);
 }
 
 void IoScheduler::free_buffers(std::stack<DataBuffer*>& buffers) {
@@ -63,46 +70,156 @@ void IoScheduler::set_commit_threshold(size_t size) {
   m_commit_threshold = size;
 }
 
+void IoScheduler::set_max_requests(unsigned num) {
+  if (!num) {
+    num = 1;
+  }
+
+  if (m_in_flight.size()) {
+    err_log("can not change max requests when busy");
+    return;
+  }
+
+  m_max_requests = num;
+  while (m_requests.size() < num) {
+    WriteRequest* wr = new WriteRequest;
+
+    wr->req = IoChannel::IoRequest{io_result_callback, this,
+                                   IoChannel::IRT_WRITE, nullptr,
+                                   &wr->data, 0, 0, 0, IoChannel::IS_IDLE,
+                                   {0, 0}};
+    wr->len = 0;
+    m_requests.push_back(wr);
+  }
+}
+
 int IoScheduler::init_buffer() {
+  if (m_pool) {
+    m_pool_client = m_pool->add_client(m_block_size, m_max_blocks, this,
+                                       pool_avail_callback);
+    return 0;
+  }
+
   DataBuffer* buf;
 
   for (size_t i = 0; i < m_max_blocks; ++i) {
     buf = alloc_data_buf(m_block_size);
+    if (!buf) {
+      err_log("allocate %u bytes buffer error",
+              static_cast<unsigned>(m_block_size));
+      break;
+    }
     m_buffers.push(buf);
   }
 
   return 0;
 }
 
+int IoScheduler::resize_buffers(size_t max_buf, size_t max_num) {
+  if (m_pool_client) {
+    if (m_pool->resize_client(m_pool_client, max_buf, max_num)) {
+      return -1;
+    }
+  } else {
+    // Allocate the new buffers first, so that the old geometry is kept
+    // if the memory is not enough.
+    std::stack<DataBuffer*> buffers;
+
+    for (size_t i = 0; i < max_num; ++i) {
+      DataBuffer* buf = alloc_data_buf(max_buf);
+      if (!buf) {
+        err_log("allocate %u buffers of %u bytes error",
+                static_cast<unsigned>(max_num),
+                static_cast<unsigned>(max_buf));
+        free_buffers(buffers);
+        return -1;
+      }
+      buffers.push(buf);
+    }
+    free_buffers(m_buffers);
+    m_buffers.swap(buffers);
+  }
+
+  m_block_size = max_buf;
+  m_max_blocks = max_num;
+  if (m_channel) {
+    m_channel->set_block_num_hint(max_num);
+  }
+
+  return 0;
+}
+
 void IoScheduler::set_buf_avail_callback(void* client, buffer_avail_callback_t cb) {
   m_buf_avail_cb = cb;
   m_buf_client = client;
 }
 
+void IoScheduler::pool_avail_callback(void* client) {
+  IoScheduler* sched = static_cast<IoScheduler*>(client);
+
+  if (sched->m_buf_avail_cb) {
+    sched->m_buf_avail_cb(sched->m_buf_client);
+  }
+}
+
 void IoScheduler::bind(IoChannel* chan) {
+  if (chan == m_channel) {
+    return;
+  }
+
+  if (m_in_flight.size()) {
+    // The results of the outstanding requests come from the old
+    // channel, so finish them before switching.
+    info_log("I/O request in progress, wait before changing channel");
+    wait_all();
+  }
+
   m_channel = chan;
   chan->set_block_num_hint(m_max_blocks);
 }
 
 int IoScheduler::open(LogFile* file) {
   m_file = file;
+  m_frames_started = false;
   return 0;
 }
 
 int IoScheduler::close() {
-  if (m_data_written.size()) {
-    info_log("m_data_written wait io");
-    m_channel->wait_io();
-    process_io_result();
+  if (m_in_flight.size()) {
+    info_log("m_in_flight wait io");
+    wait_all();
     process_write_offset();
   }
   m_file = nullptr;
   return 0;
 }
 
+bool IoScheduler::detach_file() {
+  for (auto buf : m_data) {
+    if (buf->dst_offset >= 0) {
+      // The offset based data belongs to the old file.
+      close();
+      return false;
+    }
+  }
+
+  m_file = nullptr;
+  return !m_in_flight.empty();
+}
+
+bool IoScheduler::writing(const LogFile* file) const {
+  for (auto wr : m_in_flight) {
+    if (wr->req.file == file) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
 int IoScheduler::enqueue(DataBuffer* buf) {
   m_data.push_back(buf);
-  if (!m_data_written.size()) {
+  if (m_in_flight.size() < m_max_requests) {
     commit_data();
   }
 
@@ -110,65 +227,116 @@ int IoScheduler::enqueue(DataBuffer* buf) {
 }
 
 void IoScheduler::process_write_offset() {
-  // Process writing at offset first
-  auto it = m_data.begin();
+  // Data queued before the offset based data must be written first.
+  if (m_in_flight.size()) {
+    return;
+  }
 
-  while (it != m_data.end()) {
-    DataBuffer* buf = *it;
+  while (m_data.size() && m_data.front()->dst_offset >= 0) {
+    DataBuffer* buf = m_data.front();
 
-    if (buf->dst_offset >= 0) {
-      it = m_data.erase(it);
-      m_file->write_data_to_offset(buf->buffer + buf->data_start,
-                                   buf->data_len,
-                                   buf->dst_offset);
-      free_buffer(buf);
-    } else {
-      ++it;
-    }
+    m_data.pop_front();
+    m_file->write_data_to_offset(buf->buffer + buf->data_start,
+                                 buf->data_len,
+                                 buf->dst_offset + m_file->header_len());
+    free_buffer(buf);
   }
 }
 
-void IoScheduler::commit_data() {
-  process_write_offset();
+IoScheduler::WriteRequest* IoScheduler::get_idle_request() {
+  if (m_in_flight.size() >= m_max_requests) {
+    return nullptr;
+  }
 
-  // Process queued data
+  for (auto wr : m_requests) {
+    if (IoChannel::IS_IDLE == wr->req.state && wr->data.empty()) {
+      return wr;
+    }
+  }
+
+  return nullptr;
+}
+
+bool IoScheduler::commit_request(bool force) {
+  // Append data up to the first offset based data
   size_t data_size = 0;
-  unsigned i;
+  size_t n = 0;
+
+  while (n < m_data.size() && m_data[n]->dst_offset < 0) {
+    data_size += m_data[n]->data_len;
+    ++n;
+  }
 
-  for (i = 0; i < m_data.size(); ++i) {
-    data_size += m_data[i]->data_len;
+  if (!n) {
+    return false;
   }
-  if (data_size < m_commit_threshold &&
+
+  // Don't wait for more data if offset based data is pending.
+  if (!force && n == m_data.size() &&
+      data_size < m_commit_threshold &&
       m_data.size() < m_max_blocks / 2) {
     // Data not enough
-    return;
+    return false;
   }
 
-  for (i = 0; i < m_data.size(); ++i) {
-    m_data_written.push_back(m_data[i]);
+  WriteRequest* wr = get_idle_request();
+  if (!wr) {
+    return false;
   }
-  m_data.clear();
-  m_writing_len = data_size;
 
-  m_cur_req.type = IoChannel::IRT_WRITE;
-  m_cur_req.file = m_file;
-  m_cur_req.data_list = &m_data_written;
-  m_channel->request(&m_cur_req);
+  wr->data.assign(m_data.begin(), m_data.begin() + n);
+  m_data.erase(m_data.begin(), m_data.begin() + n);
+  wr->len = data_size;
+
+  wr->req.type = IoChannel::IRT_WRITE;
+  wr->req.file = m_file;
+  wr->req.written = 0;
+  wr->req.stored = 0;
+  wr->req.err_code = 0;
+  if (m_file->compressed() && !m_frames_started) {
+    // The prologue of the file ends here.
+    seal_log_file_header(m_file);
+    m_frames_started = true;
+  }
+  if (m_channel->request(&wr->req)) {
+    // Put the data back
+    m_data.insert(m_data.begin(), wr->data.begin(), wr->data.end());
+    wr->data.clear();
+    wr->len = 0;
+    return false;
+  }
+  m_in_flight.push_back(wr);
+
+  return true;
+}
+
+void IoScheduler::commit_data() {
+  while (m_in_flight.size() < m_max_requests) {
+    process_write_offset();
+    if (!commit_request(false)) {
+      break;
+    }
+  }
 }
 
 void IoScheduler::commit_all_data() {
   process_write_offset();
+  commit_request(true);
+}
 
-  m_writing_len = 0;
-  for (auto it = m_data.begin(); it != m_data.end(); ++it) {
-    m_data_written.push_back(*it);
-    m_writing_len += (*it)->data_len;
+void IoScheduler::commit_aged(uint64_t now, unsigned max_age) {
+  if (!m_file || m_data.empty()) {
+    return;
   }
-  m_data.clear();
-  m_cur_req.type = IoChannel::IRT_WRITE;
-  m_cur_req.file = m_file;
-  m_cur_req.data_list = &m_data_written;
-  m_channel->request(&m_cur_req);
+
+  DataBuffer* head = m_data.front();
+  if (head->dst_offset >= 0 || !head->stamp ||
+      now - head->stamp < max_age) {
+    return;
+  }
+
+  process_write_offset();
+  commit_request(true);
 }
 
 void IoScheduler::discard_queue() {
@@ -178,22 +346,34 @@ void IoScheduler::discard_queue() {
   m_data.clear();
 }
 
+void IoScheduler::wait_all() {
+  while (m_in_flight.size()) {
+    WriteRequest* wr = m_in_flight.front();
+
+    m_channel->wait_io(&wr->req);
+    process_io_result(wr);
+  }
+}
+
 int IoScheduler::flush() {
   int ret = 0;
 
   info_log("enter IoScheduler::flush()");
   if (m_file) {
-    if (m_data_written.size()) {
-      info_log("m_data_written wait io");
-      m_channel->wait_io();
-      process_io_result();
+    if (m_in_flight.size()) {
+      info_log("m_in_flight wait io");
+      wait_all();
     }
 
-    if (m_data.size()) {
+    while (m_data.size()) {
+      size_t n = m_data.size();
+
       commit_all_data();
       info_log("m_data wait io");
-      m_channel->wait_io();
-      process_io_result();
+      wait_all();
+      if (n == m_data.size()) {  // No progress
+        break;
+      }
     }
   }
 
@@ -205,6 +385,10 @@ int IoScheduler::flush() {
 }
 
 DataBuffer* IoScheduler::get_free_buffer() {
+  if (m_pool_client) {
+    return m_pool->get(m_pool_client);
+  }
+
   DataBuffer* buf{nullptr};
 
   if (m_buffers.size()) {
@@ -222,24 +406,64 @@ DataBuffer* IoScheduler::get_free_buffer() {
 void IoScheduler::free_buffer(DataBuffer* buf) {
   buf->data_start = buf->data_len = 0;
   buf->dst_offset = -1;
-  m_buffers.push(buf);
+  buf->stamp = 0;
+  if (m_pool_client) {
+    m_pool->put(m_pool_client, buf);
+  } else if (buf->buf_size != m_block_size) {
+    // Allocated before resize_buffers()
+    delete buf;
+  } else {
+    m_buffers.push(buf);
+  }
+}
+
+IoScheduler::WriteRequest* IoScheduler::find_in_flight(
+    const IoChannel::IoRequest* req) {
+  for (auto wr : m_in_flight) {
+    if (&wr->req == req) {
+      return wr;
+    }
+  }
+
+  return nullptr;
 }
 
-void IoScheduler::process_io_result() {
-  if (m_cur_req.written) {
-    size_t len = m_cur_req.written;
+void IoScheduler::process_io_result(WriteRequest* wr) {
+  for (auto it = m_in_flight.begin(); it != m_in_flight.end(); ++it) {
+    if (*it == wr) {
+      m_in_flight.erase(it);
+      break;
+    }
+  }
+
+  LogFile* f = wr->req.file;
+
+  // Index the data at the file size before the write.
+  if (wr->req.written && f->index()) {
+    f->index()->add(f, wr->data, wr->req.written);
+  }
+  if (wr->req.stored) {
+    f->add_size(wr->req.stored);
+  }
 
-    m_file->add_size(len);
+  if (wr->req.written) {
+    size_t len = wr->req.written;
 
-    auto it = m_data_written.begin();
-    unsigned i;
+    auto it = wr->data.begin();
+    uint64_t now = 0;
 
-    for (i = 0; i < m_data_written.size(); ++i, ++it) {
-      DataBuffer* buf = m_data_written[i];
+    for (; it != wr->data.end(); ++it) {
+      DataBuffer* buf = *it;
 
       if (len >= buf->data_len) {
         len -= buf->data_len;
 
+        if (buf->stamp) {
+          if (!now) {
+            now = monotonic_ms();
+          }
+          m_data_age.add(now - buf->stamp);
+        }
         free_buffer(buf);
       } else {  // The block not finished
         info_log("the block not finished");
@@ -249,33 +473,54 @@ void IoScheduler::process_io_result() {
         break;
       }
     }
-    if (it != m_data_written.end()) {  // Unfinished data
-      m_data.insert(m_data.begin(), it, m_data_written.end());
-      info_log("m_data.size = %d",m_data.size());
+    if (it != wr->data.end()) {  // Unfinished data
+      if (m_in_flight.empty()) {
+        m_data.insert(m_data.begin(), it, wr->data.end());
+        info_log("m_data.size = %d", static_cast<int>(m_data.size()));
+      } else {
+        // Later data has been committed, writing the rest now would
+        // break the data order.
+        size_t lost = 0;
+
+        for (; it != wr->data.end(); ++it) {
+          lost += (*it)->data_len;
+          free_buffer(*it);
+        }
+        err_log("write data error %d, %u bytes lost",
+                wr->req.err_code, static_cast<unsigned>(lost));
+      }
     }
   } else {  // No data written
     err_log("write data error %d, %u bytes lost",
-            m_cur_req.err_code,
-            static_cast<unsigned>(m_writing_len));
+            wr->req.err_code,
+            static_cast<unsigned>(wr->len));
 
     // Return the buffers to the idle list
-    for (unsigned i = 0; i < m_data_written.size(); ++i) {
-      free_buffer(m_data_written[i]);
+    for (unsigned i = 0; i < wr->data.size(); ++i) {
+      free_buffer(wr->data[i]);
     }
   }
-  m_data_written.clear();
-  m_writing_len = 0;
+  wr->data.clear();
+  wr->len = 0;
 }
 
 void IoScheduler::io_result_callback(void* client,
                                      IoChannel::IoRequest* req) {
   IoScheduler* sched = static_cast<IoScheduler*>(client);
+  WriteRequest* wr = sched->find_in_flight(req);
+
+  if (!wr) {  // Result already processed
+    return;
+  }
+
+  LogFile* f = req->file;
+  int err = req->err_code;
 
-  sched->process_io_result();
+  sched->process_io_result(wr);
 
   // Notify the client of the file written
   if (sched->m_file_wr_cb) {
-    sched->m_file_wr_cb(sched->m_file_wr_client, req->file, req->err_code);
+    sched->m_file_wr_cb(sched->m_file_wr_client, f, err);
   }
 
   // More data to write?
@@ -10,9 +10,12 @@
 #ifndef _IO_SCHED_H_
 #define _IO_SCHED_H_
 
+#include <deque>
 #include <stack>
 #include <vector>
 
+#include "buf_pool.h"
+#include "commit_tuner.h"
 #include "data_buf.h"
 #include "io_chan.h"
 
@@ -28,10 +31,36 @@ class IoScheduler {
 
   void set_buffer_size(size_t max_buf, size_t max_num);
   void set_commit_threshold(size_t size);
+  /*  set_max_requests - set the max number of outstanding write requests.
+   *  @num: number of requests that can be in the IoChannel at the
+   *        same time.
+   *
+   *  When num is greater than 1, data read during a slow write can be
+   *  committed before the previous write finishes. This function shall
+   *  be called when there is no outstanding request.
+   */
+  void set_max_requests(unsigned num);
+  /*  set_buffer_pool - get the buffers from the shared pool.
+   *
+   *  This function shall be called before init_buffer().
+   */
+  void set_buffer_pool(BufferPool* pool) { m_pool = pool; }
   int init_buffer();
+  /*  resize_buffers - change the buffer size and number after
+   *                   init_buffer().
+   *
+   *  The queued data is kept. The buffers in use are freed when they
+   *  are returned if their size is changed.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int resize_buffers(size_t max_buf, size_t max_num);
 
   /*  bind - bind the scheduler to an IoChannel.
    *
+   *  The scheduler may be bound again, e.g. after the media is
+   *  switched. The requests in flight on the old channel are finished
+   *  first.
    */
   void bind(IoChannel* chan);
 
@@ -43,6 +72,19 @@ class IoScheduler {
    */
   int open(LogFile* file);
   int close();
+  /*  detach_file - stop writing the current file without waiting for
+   *                the requests in flight.
+   *
+   *  The results of the requests in flight are still reported to the
+   *  file written callback with the old file. If offset based data is
+   *  queued, the requests are waited for as in close().
+   *
+   *  Return true if there are requests in flight on the old file.
+   */
+  bool detach_file();
+  /*  writing - check whether there are requests in flight on the file.
+   */
+  bool writing(const LogFile* file) const;
 
   /*  enqueue - put the data block in the queue.
    *
@@ -60,11 +102,31 @@ class IoScheduler {
   /*  flush - flush data.
    */
   int flush();
+  /*  commit_aged - commit the queued data regardless of the commit
+   *                threshold if its head was read max_age ms ago.
+   *  @now: the current CLOCK_MONOTONIC time in ms.
+   */
+  void commit_aged(uint64_t now, unsigned max_age);
+  /*  data_age - ages of the stamped buffers when they are written.
+   */
+  AgeHistogram& data_age() { return m_data_age; }
 
   DataBuffer* get_free_buffer();
   void free_buffer(DataBuffer* buf);
+  size_t free_buffer_num() const {
+    return m_pool_client ? m_pool_client->idle.size() : m_buffers.size();
+  }
 
  private:
+  // One write request and the data blocks it carries
+  struct WriteRequest {
+    IoChannel::IoRequest req;
+    // Data blocks that are being written
+    std::vector<DataBuffer*> data;
+    // Data length that is being written
+    size_t len;
+  };
+
   IoChannel* m_channel;
   // Current file
   LogFile* m_file;
@@ -80,31 +142,55 @@ class IoScheduler {
   size_t m_commit_threshold;
   // Idle buffers
   std::stack<DataBuffer*> m_buffers;
+  // The shared buffer pool, or nullptr for the private m_buffers
+  BufferPool* m_pool;
+  BufferPool::Client* m_pool_client;
   // Data buffers to be commit to I/O thread
   std::deque<DataBuffer*> m_data;
-  // Data blocks that are being written
-  std::vector<DataBuffer*> m_data_written;
-  // Data length that is being written
-  size_t m_writing_len;
-  IoChannel::IoRequest m_cur_req;
+  // Max number of outstanding write requests
+  unsigned m_max_requests;
+  // All write requests
+  std::vector<WriteRequest*> m_requests;
+  // Requests in the IoChannel, in the order they are committed
+  std::deque<WriteRequest*> m_in_flight;
   // Buffer available callback
   buffer_avail_callback_t m_buf_avail_cb;
   void* m_buf_client;
   bool m_report_buf_avail;
+  AgeHistogram m_data_age;
+  // Frames have been committed to the compressed m_file
+  bool m_frames_started;
 
   void commit_data();
   /*  commit_all_data - commit all data to IoChannel
    *
-   *  This function assumes m_data is not empty.
+   *  This function assumes m_data is not empty and there is no
+   *  outstanding request.
    */
   void commit_all_data();
-  /*  process_write_offset - write all offset based data into file.
+  /*  commit_request - commit the append data at the head of m_data.
+   *  @force: commit even if the data is less than the commit threshold.
+   *
+   *  Return true if a request is committed.
+   */
+  bool commit_request(bool force);
+  WriteRequest* get_idle_request();
+  /*  process_write_offset - write offset based data at the head of m_data.
+   *
+   *  Offset based data is written only after all data queued before it
+   *  has been written, so it won't be overwritten by earlier data.
    */
   void process_write_offset();
-  void process_io_result();
+  /*  wait_all - wait for all outstanding requests and process the
+   *             results.
+   */
+  void wait_all();
+  void process_io_result(WriteRequest* wr);
+  WriteRequest* find_in_flight(const IoChannel::IoRequest* req);
 
   static void free_buffers(std::stack<DataBuffer*>& buffers);
   static void io_result_callback(void* client, IoChannel::IoRequest* req);
+  static void pool_avail_callback(void* client);
 };
 
 #endif  //!_IO_SCHED_H_
@@ -449,6 +449,31 @@ int LogConfig::parse_stream_line(const uint8_t* buf) {
     ow = true;
   }
 
+  // Optional buffer geometry: buffer size, buffer number, log commit
+  // threshold and buffer commit threshold
+  BufGeometry geo{0, 0, 0, 0};
+  size_t* const geo_fields[] = {&geo.max_buf, &geo.max_buf_num,
+                                &geo.log_commit_threshold,
+                                &geo.buf_commit_threshold};
+
+  buf = t + tlen;
+  for (auto field : geo_fields) {
+    t = get_token(buf, tlen);
+    if (!t) {
+      break;
+    }
+
+    unsigned long n = strtoul(reinterpret_cast<const char*>(t), &endp, 0);
+    if ((ULONG_MAX == n && ERANGE == errno) ||
+        (' ' != *endp && '\t' != *endp && '\r' != *endp && '\n' != *endp &&
+         '\0' != *endp)) {
+      err_log("invalid buffer geometry");
+      return -1;
+    }
+    *field = n;
+    buf = t + tlen;
+  }
+
   ConfigList::iterator it = find(m_config, cp_type);
   if (it != m_config.end()) {
     ConfigEntry* pe = *it;
@@ -464,6 +489,7 @@ int LogConfig::parse_stream_line(const uint8_t* buf) {
     pe->file_size_limit = file_sz;
     pe->level = static_cast<int>(level);
     pe->overwrite = ow;
+    pe->buf_geometry = geo;
   } else {
     ConfigEntry* pe = new ConfigEntry{reinterpret_cast<const char*>(pn),
                                       nlen,
@@ -474,12 +500,72 @@ int LogConfig::parse_stream_line(const uint8_t* buf) {
                                       file_sz,
                                       static_cast<int>(level),
                                       ow};
+    pe->buf_geometry = geo;
     m_config.push_back(pe);
   }
 
   return 0;
 }
 
+int LogConfig::parse_stream_switch(const uint8_t* buf, const char* opt,
+                                   ConfigEntry*& pe, bool& on) {
+  const uint8_t* pn;
+  size_t nlen;
+
+  pe = nullptr;
+
+  // Get the modem name
+  pn = get_token(buf, nlen);
+  if (!pn) {
+    return -1;
+  }
+
+  CpType cp_type = get_modem_type(pn, nlen);
+  if (CT_UNKNOWN == cp_type) {
+    // Ignore unknown CP
+    return 0;
+  }
+
+  if (parse_on_off(pn + nlen, on)) {
+    return -1;
+  }
+
+  // The stream line of the CP shall come first.
+  ConfigList::iterator it = find(m_config, cp_type);
+  if (it == m_config.end()) {
+    err_log("no stream line before %s %s", opt,
+            cp_type_to_name(cp_type));
+    return 0;
+  }
+  pe = *it;
+
+  return 0;
+}
+
+int LogConfig::parse_ingest_line(const uint8_t* buf) {
+  ConfigEntry* pe;
+  bool on;
+  int ret = parse_stream_switch(buf, "ingest", pe, on);
+
+  if (!ret && pe) {
+    pe->ingest_thread = on;
+  }
+
+  return ret;
+}
+
+int LogConfig::parse_compress_line(const uint8_t* buf) {
+  ConfigEntry* pe;
+  bool on;
+  int ret = parse_stream_switch(buf, "compress", pe, on);
+
+  if (!ret && pe) {
+    pe->compress_log = on;
+  }
+
+  return ret;
+}
+
 int LogConfig::parse_storage_line(const uint8_t* buf) {
   int ret = -1;
   size_t tlen;
@@ -591,6 +677,8 @@ int LogConfig::parse_line(const uint8_t* buf) {
     case 6:
       if (!memcmp(t, "stream", 6)) {
         err = parse_stream_line(buf);
+      } else if (!memcmp(t, "ingest", 6)) {
+        err = parse_ingest_line(buf);
       }
       break;
     case 7:
@@ -603,6 +691,8 @@ int LogConfig::parse_line(const uint8_t* buf) {
     case 8:
       if (!memcmp(t, "minidump", 8)) {
         err = parse_minidump_line(buf, m_enable_md, m_md_save_to_int);
+      } else if (!memcmp(t, "compress", 8)) {
+        err = parse_compress_line(buf);
       }
       break;
 #ifdef SUPPORT_AGDSP
@@ -743,11 +833,12 @@ int LogConfig::save() {
   }
 
   fprintf(pf, "\n");
-  fprintf(pf, "#Type\tName\t\tState\tInternal Size\tExternal Size\tFile Size\tLevel\tOverwrite\n");
+  fprintf(pf, "#Type\tName\t\tState\tInternal Size\tExternal Size\tFile Size\tLevel\tOverwrite"
+              "\t[Buf Size\tBuf Num\tLog Commit\tBuf Commit]\n");
 
   for (ConfigIter it = m_config.begin(); it != m_config.end(); ++it) {
     ConfigEntry* pe = *it;
-    fprintf(pf, "stream\t%s\t%s\t%u\t%u\t%u\t%u\t%s\n",
+    fprintf(pf, "stream\t%s\t%s\t%u\t%u\t%u\t%u\t%s",
             ls2cstring(pe->modem_name),
             log_mode_to_string(pe->mode),
             static_cast<unsigned>(pe->internal_limit),
@@ -755,6 +846,27 @@ int LogConfig::save() {
             static_cast<unsigned>(pe->file_size_limit),
             pe->level,
             pe->overwrite ? "on" : "off");
+
+    const BufGeometry& geo = pe->buf_geometry;
+    if (geo.max_buf || geo.max_buf_num || geo.log_commit_threshold ||
+        geo.buf_commit_threshold) {
+      fprintf(pf, "\t%u\t%u\t%u\t%u",
+              static_cast<unsigned>(geo.max_buf),
+              static_cast<unsigned>(geo.max_buf_num),
+              static_cast<unsigned>(geo.log_commit_threshold),
+              static_cast<unsigned>(geo.buf_commit_threshold));
+    }
+    fprintf(pf, "\n");
+  }
+
+  for (ConfigIter it = m_config.begin(); it != m_config.end(); ++it) {
+    ConfigEntry* pe = *it;
+    if (pe->ingest_thread) {
+      fprintf(pf, "ingest\t%s\ton\n", ls2cstring(pe->modem_name));
+    }
+    if (pe->compress_log) {
+      fprintf(pf, "compress\t%s\ton\n", ls2cstring(pe->modem_name));
+    }
   }
 
   fprintf(pf, "\n");
@@ -837,6 +949,18 @@ void LogConfig::set_cp_log_file_size(CpType ct, size_t sz) {
   }
 }
 
+void LogConfig::set_cp_buf_geometry(CpType ct, const BufGeometry& geo) {
+  for (ConfigList::iterator it = m_config.begin();
+       it != m_config.end(); ++it) {
+    ConfigEntry* p = *it;
+    if (p->type == ct) {
+      p->buf_geometry = geo;
+      m_dirty = true;
+      break;
+    }
+  }
+}
+
 void LogConfig::get_cp_log_file_size(CpType ct, size_t& sz) const {
   for (auto it = m_config.begin();
        it != m_config.end(); ++it) {
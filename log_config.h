@@ -45,6 +45,15 @@ class LogConfig {
 
   typedef LogList<MipiLogEntry*> MipiLogList;
 
+  // Log buffer geometry of a subsystem in bytes. Zero fields mean the
+  // built-in values of the subsystem.
+  struct BufGeometry {
+    size_t max_buf;
+    size_t max_buf_num;
+    size_t log_commit_threshold;
+    size_t buf_commit_threshold;
+  };
+
   struct ConfigEntry {
     LogString modem_name;
     CpType type;
@@ -54,6 +63,11 @@ class LogConfig {
     size_t file_size_limit;
     int level;
     bool overwrite;
+    // Read the log device on the ingest reactor thread
+    bool ingest_thread;
+    // Write the log files compressed
+    bool compress_log;
+    BufGeometry buf_geometry;
 
     ConfigEntry(const char* modem, size_t len, CpType t, LogMode lm,
                 size_t internal, size_t external,
@@ -61,7 +75,9 @@ class LogConfig {
         : modem_name(modem, len), type{t}, mode{lm},
           internal_limit{internal},
           external_limit{external},
-          file_size_limit{file_size}, level{lvl}, overwrite{ovwt} {}
+          file_size_limit{file_size}, level{lvl}, overwrite{ovwt},
+          ingest_thread{false}, compress_log{false},
+          buf_geometry{0, 0, 0, 0} {}
   };
 
   typedef LogList<ConfigEntry*> ConfigList;
@@ -131,6 +147,7 @@ class LogConfig {
 
   void set_cp_log_file_size(CpType ct, size_t sz);
   void get_cp_log_file_size(CpType ct, size_t& sz) const;
+  void set_cp_buf_geometry(CpType ct, const BufGeometry& geo);
   void set_cp_log_overwrite(CpType ct, bool enabled);
   void get_cp_log_overwrite(CpType ct, bool& enabled) const;
 
@@ -220,6 +237,17 @@ class LogConfig {
 
   int parse_line(const uint8_t* buf);
   int parse_stream_line(const uint8_t* buf);
+  /*  parse_stream_switch - parse "<modem> on|off" of a stream option.
+   *  @opt: the option name.
+   *  @pe: the config entry of the modem, nullptr if the line is ignored.
+   *  @on: the switch.
+   *
+   *  Return 0 on success, -1 on syntax error.
+   */
+  int parse_stream_switch(const uint8_t* buf, const char* opt,
+                          ConfigEntry*& pe, bool& on);
+  int parse_ingest_line(const uint8_t* buf);
+  int parse_compress_line(const uint8_t* buf);
   int parse_iq_line(const uint8_t* buf);
   int parse_minidump_line(const uint8_t* buf, bool& en,
                           bool& save_to_int);
@@ -14,6 +14,7 @@
 
 #include <fcntl.h>
 #include <stdlib.h>
+#include <time.h>
 #include <unistd.h>
 #ifdef HOST_TEST_
 #include "prop_test.h"
@@ -53,11 +54,14 @@ LogController::LogController()
       m_modem_state{nullptr},
       m_wcn_state{nullptr},
       f_rate_statistic_{-1},
-      convey_workshop_{nullptr} {}
+      convey_workshop_{nullptr},
+      m_ingest_reactor{nullptr} {}
 LogController::~LogController() {
   delete m_wcn_state;
   delete m_modem_state;
   clear_ptr_container(m_log_pipes);
+  // The log pipes are detached from the reactor now.
+  delete m_ingest_reactor;
   delete m_cli_mgr;
 #ifdef SUPPORT_RATE_STATISTIC
   close();
@@ -167,6 +171,22 @@ LogPipeHandler* LogController::create_handler(const LogConfig::ConfigEntry* e) {
 #endif
   }
 
+  if (log_pipe && e->ingest_thread) {
+    if (CT_AGDSP == cp_type) {
+      // AG-DSP log has its own reading process.
+      err_log("ingest thread is not supported by %s",
+              ls2cstring(e->modem_name));
+    } else {
+      IngestReactor* reactor = ingest_reactor();
+      if (!reactor || log_pipe->use_ingest_reactor(reactor)) {
+        err_log("%s can not use ingest thread", ls2cstring(e->modem_name));
+      } else {
+        info_log("%s log is read on ingest thread",
+                 ls2cstring(e->modem_name));
+      }
+    }
+  }
+
   if (log_pipe) {
     char version[PROPERTY_VALUE_MAX];
     property_get("ro.build.type", version, "");
@@ -205,6 +225,20 @@ LogPipeHandler* LogController::create_handler(const LogConfig::ConfigEntry* e) {
   return log_pipe;
 }
 
+IngestReactor* LogController::ingest_reactor() {
+  if (!m_ingest_reactor) {
+    IngestReactor* reactor = new IngestReactor;
+    if (reactor->start()) {
+      err_log("start ingest reactor error");
+      delete reactor;
+    } else {
+      m_ingest_reactor = reactor;
+    }
+  }
+
+  return m_ingest_reactor;
+}
+
 int LogController::init(LogConfig* config) {
   m_config = config;
 
@@ -688,6 +722,45 @@ int LogController::set_log_file_size(CpType ct, size_t len) {
   return ret;
 }
 
+int LogController::set_buf_geometry(CpType ct,
+                                    const LogConfig::BufGeometry& geo) {
+  auto it = find_log_handler(m_log_pipes, ct);
+
+  if (it == m_log_pipes.end()) {
+    err_log("Not supported cp type");
+    return LCR_CP_NONEXISTENT;
+  }
+
+  int ret = (*it)->set_buf_geometry(geo);
+
+  if (LCR_SUCCESS == ret) {
+    LogConfig::BufGeometry cur;
+
+    (*it)->get_buf_geometry(cur);
+    m_config->set_cp_buf_geometry(ct, cur);
+    if (m_config->save()) {
+      err_log("save config file failed");
+    }
+  }
+
+  return ret;
+}
+
+int LogController::get_buf_geometry(CpType ct,
+                                    LogConfig::BufGeometry& geo) const {
+  int ret = LCR_SUCCESS;
+
+  auto it = find_log_handler(m_log_pipes, ct);
+
+  if (it != m_log_pipes.end()) {
+    (*it)->get_buf_geometry(geo);
+  } else {
+    ret = LCR_CP_NONEXISTENT;
+  }
+
+  return ret;
+}
+
 int LogController::set_log_overwrite(CpType ct, bool en) {
   int ret = LCR_SUCCESS;
 
@@ -807,6 +880,9 @@ int LogController::clear_log() {
     }
   }
 
+  struct timespec pause_time;
+  clock_gettime(CLOCK_MONOTONIC, &pause_time);
+
   // Now we can pause log
   for (it = m_log_pipes.begin(); it != m_log_pipes.end(); ++it) {
     LogPipeHandler* cp = *it;
@@ -832,6 +908,12 @@ int LogController::clear_log() {
     }
   }
 
+  struct timespec resume_time;
+  clock_gettime(CLOCK_MONOTONIC, &resume_time);
+  long ms = (resume_time.tv_sec - pause_time.tv_sec) * 1000 +
+            (resume_time.tv_nsec - pause_time.tv_nsec) / 1000000;
+  info_log("clear_log(): log paused for %ld ms", ms);
+
   return LCR_SUCCESS;
 }
 
@@ -22,6 +22,7 @@
 #include "trans.h"
 #include "trans_mgr.h"
 #include "convey_workshop.h"
+#include "ingest_reactor.h"
 
 
 class TransDisableLog;
@@ -103,6 +104,12 @@ class LogController : public TransactionManager {
   int mini_dump();
   size_t get_log_file_size(CpType ct, size_t& sz) const;
   int set_log_file_size(CpType ct, size_t len);
+  /*  set_buf_geometry - change and save the log buffer geometry.
+   *
+   *  Return LCR_SUCCESS on success, LCR_xxx on error.
+   */
+  int set_buf_geometry(CpType ct, const LogConfig::BufGeometry& geo);
+  int get_buf_geometry(CpType ct, LogConfig::BufGeometry& geo) const;
   int get_log_overwrite(CpType ct, bool& en) const;
   int set_log_overwrite(CpType ct, bool en = true);
   bool get_md_int_stor() const;
@@ -239,6 +246,13 @@ private:
    *                  open the device if it's enabled in the config.
    */
   LogPipeHandler* create_handler(const LogConfig::ConfigEntry* e);
+  /*
+   * ingest_reactor - get the ingest reactor, which is started on the
+   *                  first call.
+   *
+   * Return the IngestReactor pointer, or nullptr on failure.
+   */
+  IngestReactor* ingest_reactor();
 
   /*
    * init_state_handler - Create the ModemStateHandler object for
@@ -281,6 +295,8 @@ private:
   WcndStateHandler* m_wcn_state;
   int f_rate_statistic_;
   ConveyWorkshop* convey_workshop_;
+  // Thread reading the log devices configured with the ingest option
+  IngestReactor* m_ingest_reactor;
   // Storage manager
   StorageManager m_stor_mgr;
 };
@@ -11,6 +11,8 @@
 #include <cstring>
 #include <cctype>
 #include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/uio.h>
@@ -18,6 +20,8 @@
 
 #include "log_file.h"
 #include "cp_dir.h"
+#include "def_config.h"
+#include "log_index.h"
 #include "parse_utils.h"
 
 LogFile::LogFile(const LogString& base_name, CpDirectory* dir,
@@ -32,7 +36,13 @@ LogFile::LogFile(const LogString& base_name, CpDirectory* dir,
       m_buffer{},
       m_buf_len{kIoBufSize},
       m_data_len{0},
-      overwritable_{owable} {}
+      overwritable_{owable},
+      m_prealloc_size{0},
+      m_unsynced{0},
+      m_exist_watched{false},
+      m_vanished{false},
+      m_header_len{0},
+      m_index{nullptr} {}
 
 LogFile::LogFile(const LogString& base_name, CpDirectory* dir,
                  const struct tm& file_time, bool owable)
@@ -46,7 +56,13 @@ LogFile::LogFile(const LogString& base_name, CpDirectory* dir,
       m_buffer{},
       m_buf_len{kIoBufSize},
       m_data_len{0},
-      overwritable_{owable} {}
+      overwritable_{owable},
+      m_prealloc_size{0},
+      m_unsynced{0},
+      m_exist_watched{false},
+      m_vanished{false},
+      m_header_len{0},
+      m_index{nullptr} {}
 
 LogFile::~LogFile() { close(); }
 
@@ -101,7 +117,63 @@ int LogFile::create(int flags/* = 0*/) {
   return ret;
 }
 
+int LogFile::adopt(int fd, size_t prealloc_size) {
+  if (m_fd >= 0) {
+    return -1;
+  }
+
+  try {
+    m_buffer = new uint8_t[m_buf_len];
+  } catch (std::bad_alloc) {
+    m_buffer = nullptr;
+    err_log("m_buffer malloc fail");
+    return -1;
+  }
+
+  m_fd = fd;
+  m_prealloc_size = prealloc_size;
+  return 0;
+}
+
+int LogFile::preallocate(size_t size) {
+  if (m_fd < 0) {
+    return -1;
+  }
+  if (m_prealloc_size >= size) {
+    return 0;
+  }
+
+  // FALLOC_FL_KEEP_SIZE keeps the file size, so the size of the
+  // file is correct even if the file is not closed normally.
+  if (fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(size))) {
+    info_log("preallocate %s error %d", ls2cstring(m_base_name), errno);
+    return -1;
+  }
+
+  m_prealloc_size = size;
+  return 0;
+}
+
+void LogFile::start_writeback(size_t len) {
+  if (!LOG_WRITEBACK_SIZE || m_fd < 0) {
+    return;
+  }
+
+  m_unsynced += len;
+  if (m_unsynced >= LOG_WRITEBACK_SIZE) {
+    m_unsynced = 0;
+    // Only initiate the writeback of the dirty pages
+    sync_file_range(m_fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+  }
+}
+
 int LogFile::close() {
+  if (m_index) {
+    // Flush and close the index file
+    delete m_index;
+    m_index = nullptr;
+  }
+
   if (m_fd >= 0) {
     if (!m_buffer) {
       err_log("m_buffer is null");
@@ -113,6 +185,16 @@ int LogFile::close() {
     if (m_data_len) {
       write_data(m_buffer, m_data_len);
     }
+    if (m_prealloc_size) {
+      // Release the reserved space beyond the end of the file
+      struct stat file_stat;
+
+      if (!fstat(m_fd, &file_stat) &&
+          ftruncate(m_fd, file_stat.st_size)) {
+        err_log("truncate %s error", ls2cstring(m_base_name));
+      }
+      m_prealloc_size = 0;
+    }
     ::close(m_fd);
     m_fd = -1;
 
@@ -239,7 +321,9 @@ LogFile::LogType LogFile::get_type() {
   const char* s = ls2cstring(m_base_name);
 
   if (!include_valid_time(s, m_base_name.length(), m_time)) {
-    if (str_ends_with(m_base_name, ".dmp", 4) ||
+    if (LogIndex::is_index_name(m_base_name)) {
+      t = LT_LOG_INDEX;
+    } else if (str_ends_with(m_base_name, ".dmp", 4) ||
       str_ends_with(m_base_name, ".mem", 4)) {
       t = LT_DUMP;
     } else if (str_starts_with(m_base_name, "md_", 3) ||
@@ -494,11 +578,13 @@ int LogFile::copy(const char* src, bool simple_copy) {
     return -1;
   }
 
-  int ret = -1;
   size_t total_save = 0;
-  while (true) {
+  int ret = copy_in_kernel(src_fd, total_save);
+
+  while (ret > 0) {
     ssize_t n = read(src_fd, m_buffer, m_buf_len);
     if (n < 0) {
+      ret = -1;
       break;
     }
     if (!n) {  // End of file
@@ -510,6 +596,7 @@ int LogFile::copy(const char* src, bool simple_copy) {
       if (nwr > 0) {
         total_save += nwr;
       }
+      ret = -1;
       break;
     }
     total_save += n;
@@ -525,6 +612,70 @@ int LogFile::copy(const char* src, bool simple_copy) {
   return ret;
 }
 
+ssize_t LogFile::copy_range(int src_fd, size_t len) {
+#ifdef __NR_copy_file_range
+  return syscall(__NR_copy_file_range, src_fd, nullptr, m_fd, nullptr,
+                 len, 0);
+#else
+  errno = ENOSYS;
+  return -1;
+#endif
+}
+
+int LogFile::copy_in_kernel(int src_fd, size_t& total) {
+  struct stat st;
+
+  // copy_file_range() and sendfile() only work on regular files.
+  // Device files may also require a fixed read size.
+  if (fstat(src_fd, &st) || !S_ISREG(st.st_mode)) {
+    return 1;
+  }
+
+  bool use_cfr = true;
+
+  while (true) {
+    ssize_t n = -1;
+    int err = ENOSYS;
+
+    if (use_cfr) {
+      n = copy_range(src_fd, kCopyChunkSize);
+      err = errno;
+      // Before Linux 5.19, copy_file_range() between file systems
+      // returns 0 for files like procfs files whose size is 0.
+      if (!n && !total) {
+        n = -1;
+        err = EXDEV;
+      }
+      if (n < 0) {
+        use_cfr = false;
+      }
+    }
+    if (n < 0) {
+      n = sendfile(m_fd, src_fd, nullptr, kCopyChunkSize);
+      err = errno;
+      if (!n && !total) {
+        // Let read() confirm the end of file.
+        return 1;
+      }
+    }
+
+    if (!n) {  // End of file
+      return 0;
+    }
+    if (n < 0) {
+      if (EINVAL == err || ENOSYS == err || EXDEV == err ||
+          EOPNOTSUPP == err) {
+        // Data copied so far is kept since the file offsets of both
+        // files have been updated.
+        return 1;
+      }
+      err_log("copy data error %d", err);
+      return -1;
+    }
+    total += n;
+  }
+}
+
 const char* LogFile::get_4digits(const char* s, size_t len) {
   const char* endp = s + len;
 
@@ -569,6 +720,10 @@ int LogFile::extract_file_time(const char* s, size_t len, FileTime& file_time) {
 }
 
 bool LogFile::exists() const {
+  if (m_exist_watched) {
+    return !m_vanished;
+  }
+
   std::string file_path;
   try {
     if (m_dir) {
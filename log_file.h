@@ -13,6 +13,7 @@
 #include "cp_log_cmn.h"
 
 class CpDirectory;
+class LogIndex;
 
 class LogFile {
  public:
@@ -25,6 +26,8 @@ class LogFile {
     LT_MODEM_PARSE_LIB,
     LT_SLEEPLOG,
     LT_WCDMA_IQ,
+    // Time index of a LT_LOG file, see log_index.h
+    LT_LOG_INDEX,
   };
 
   static const int FIO_ERROR = -1;
@@ -83,8 +86,32 @@ class LogFile {
 
   LogType type() const { return m_type; }
 
+  /*  set_compressed - the log is written in compressed frames.
+   *  @header_len: size of the file header before the prologue.
+   *
+   *  See log_frame.h for the file format.
+   */
+  void set_compressed(size_t header_len) { m_header_len = header_len; }
+  bool compressed() const { return m_header_len; }
+  /*  header_len - size of the compressed file header, 0 if the file
+   *               is not compressed.
+   *
+   *  The offsets of the data amended in the prologue are relative to
+   *  the end of the header.
+   */
+  size_t header_len() const { return m_header_len; }
+
+  /*  set_index - the time index is written while the log is written.
+   *  @index: the LogIndex, which is owned by the LogFile and deleted
+   *          when the file is closed.
+   */
+  void set_index(LogIndex* index) { m_index = index; }
+  LogIndex* index() { return m_index; }
+
   bool overwritable() const { return overwritable_; }
+  const FileTime& file_time() const { return m_time; }
   size_t size() const { return m_size; }
+  int fd() const { return m_fd; }
 
   /*  create - create the file.
    *  @flags: the file open flags. The argument will be ored with
@@ -93,6 +120,13 @@ class LogFile {
    *  Return 0 on success, -1 on failure.
    */
   int create(int flags = 0);
+  /*  adopt - use the file opened by others.
+   *  @fd: the opened file.
+   *  @prealloc_size: the disk space already reserved for the file.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int adopt(int fd, size_t prealloc_size);
 
   /*  close - close the file.
    *
@@ -128,6 +162,30 @@ class LogFile {
    */
   ssize_t write_raw(const struct iovec* iov, int cnt);
 
+  /*  preallocate - reserve disk space for the file.
+   *  @size: the expected size of the file in byte.
+   *
+   *  The file size is not changed, and the space that is not used is
+   *  released when the file is closed.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int preallocate(size_t size);
+  /*  start_writeback - start the writeback of the data written.
+   *  @len: number of bytes written to the file.
+   *
+   *  The writeback is started every LOG_WRITEBACK_SIZE bytes written
+   *  and is not waited for.
+   */
+  void start_writeback(size_t len);
+
+  /*  linux_err_to_fio_err - convert errno to FIO_* error code.
+   *  @err: the errno value.
+   *
+   *  Return the FIO_* error code.
+   */
+  static int linux_err_to_fio_err(int err);
+
   /*  count_size - set file size.
    *  @size: size of the file.
    *
@@ -150,7 +208,24 @@ class LogFile {
 
   int flush();
 
+  /*  exists - check whether the file exists.
+   *
+   *  While the existence is watched, the cached result is returned
+   *  without any system call.
+   */
   bool exists() const;
+  /*  watch_existence - the existence of the file is watched by the
+   *                    CpDirectory from now on.
+   *  @watched: true - the file is watched and exists now,
+   *            false - exists() shall check the file system.
+   */
+  void watch_existence(bool watched) {
+    m_exist_watched = watched;
+    m_vanished = false;
+  }
+  /*  vanished - the file is deleted or moved out of its directory.
+   */
+  void vanished() { m_vanished = true; }
   /*  remove - remove the file from the disk. Don't decrease any size.
    *  @par_dir: the parent directory.
    *
@@ -168,15 +243,33 @@ class LogFile {
   /* copy - copy src_file to this file
    * @src_file - source file path
    * @simple_copy - no size is added to storage, for thread safe usage
+   *
+   * Regular files are copied by copy_file_range() or sendfile() in the
+   * kernel when possible, other files are copied through m_buffer.
    */
   int copy(const char* src_file, bool simple_copy = false);
 
+  /*  copy_range - copy data from src_fd to this file by
+   *                copy_file_range().
+   *  @src_fd: the source file, read from its file offset.
+   *  @len: max number of bytes to copy.
+   *
+   *  The size of the file is not updated.
+   *
+   *  Return the number of bytes copied, 0 at the end of src_fd, -1 on
+   *  error with errno set (EXDEV, EINVAL or ENOSYS if copy_file_range()
+   *  can not be used for the files).
+   */
+  ssize_t copy_range(int src_fd, size_t len);
+
   static int parse_log_file_num(const char* name, size_t len, unsigned& num,
                                 size_t& nlen);
   void reset_buffer(size_t size);
 
  private:
   static const int kIoBufSize = 1024 * 64;
+  // Max bytes copied by one copy_file_range()/sendfile() call
+  static const size_t kCopyChunkSize = 1024 * 1024 * 4;
 
   // The directory where the file locates
   CpDirectory* m_dir;
@@ -196,12 +289,31 @@ class LogFile {
   size_t m_data_len;
   // if log file can be overwrite
   bool overwritable_;
+  // Disk space reserved by preallocate()
+  size_t m_prealloc_size;
+  // Size written since the last writeback
+  size_t m_unsynced;
+  // The existence is tracked by the file watch of the CpDirectory
+  bool m_exist_watched;
+  bool m_vanished;
+  // Size of the compressed file header, 0 if not compressed
+  size_t m_header_len;
+  // Time index being written
+  LogIndex* m_index;
 
   /*  write_data - write data into the file.
    *
    *  Return the number of bytes written into the file. -1 on failure.
    */
   ssize_t write_data(const void* data, size_t len);
+  /*  copy_in_kernel - copy src_fd to the file in the kernel.
+   *  @src_fd: the source file.
+   *  @total: incremented by the number of bytes copied.
+   *
+   *  Return 0 if the whole file is copied, 1 if the rest of the file
+   *  shall be copied by read()/write(), -1 on error.
+   */
+  int copy_in_kernel(int src_fd, size_t& total);
 
   /*  parse_file_time - parse the time in the file name.
    *  @name: the time string starting at year part.
@@ -223,7 +335,6 @@ class LogFile {
 
   static const char* get_4digits(const char* s, size_t len);
   static int extract_file_time(const char* name, size_t len, FileTime& ft);
-  static int linux_err_to_fio_err(int err);
 };
 
 #endif  // !_LOG_FILE_H_
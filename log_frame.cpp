@@ -0,0 +1,151 @@
+/*
+ *  log_frame.cpp - compressed log file format.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cstddef>
+#include <cstring>
+
+#include "cp_log_cmn.h"
+#include "def_config.h"
+#include "log_file.h"
+#include "log_frame.h"
+
+LogFrameEncoder::LogFrameEncoder()
+    : m_stage{new uint8_t[LOG_FRAME_SIZE]},
+      m_stage_len{0} {}
+
+LogFrameEncoder::~LogFrameEncoder() { delete [] m_stage; }
+
+size_t LogFrameEncoder::encode(const std::vector<DataBuffer*>& data,
+                               std::vector<uint8_t>& frames) {
+  size_t total = 0;
+
+  for (auto buf : data) {
+    total += buf->data_len;
+  }
+  // Stored frames are the worst case.
+  frames.reserve(frames.size() + total +
+                 (total / LOG_FRAME_SIZE + data.size() + 1) *
+                     sizeof(LogFrameHeader));
+
+  m_stage_len = 0;
+  for (auto buf : data) {
+    const uint8_t* p = buf->buffer + buf->data_start;
+    size_t len = buf->data_len;
+
+    while (len) {
+      if (!m_stage_len && len >= LOG_FRAME_SIZE) {
+        // Compress a whole frame in the data block.
+        add_frame(p, LOG_FRAME_SIZE, frames);
+        p += LOG_FRAME_SIZE;
+        len -= LOG_FRAME_SIZE;
+        continue;
+      }
+
+      size_t n = LOG_FRAME_SIZE - m_stage_len;
+      if (n > len) {
+        n = len;
+      }
+      memcpy(m_stage + m_stage_len, p, n);
+      m_stage_len += n;
+      p += n;
+      len -= n;
+      if (LOG_FRAME_SIZE == m_stage_len) {
+        add_frame(m_stage, m_stage_len, frames);
+        m_stage_len = 0;
+      }
+    }
+  }
+
+  if (m_stage_len) {
+    add_frame(m_stage, m_stage_len, frames);
+    m_stage_len = 0;
+  }
+
+  return total;
+}
+
+void LogFrameEncoder::add_frame(const uint8_t* data, size_t len,
+                                std::vector<uint8_t>& frames) {
+  size_t pos = frames.size();
+
+  frames.resize(pos + sizeof(LogFrameHeader) + len);
+
+  uint8_t* payload = frames.data() + pos + sizeof(LogFrameHeader);
+  // Only keep the LZ4 block if it's smaller than the data.
+  size_t data_len = m_lz4.compress(data, len, payload, len - 1);
+
+  if (!data_len) {
+    memcpy(payload, data, len);
+    data_len = len;
+  }
+  frames.resize(pos + sizeof(LogFrameHeader) + data_len);
+
+  LogFrameHeader hdr;
+
+  hdr.magic = LOG_FRAME_MAGIC;
+  hdr.raw_len = static_cast<uint32_t>(len);
+  hdr.data_len = static_cast<uint32_t>(data_len);
+  hdr.check = frame_check(hdr.raw_len, hdr.data_len);
+  memcpy(frames.data() + pos, &hdr, sizeof hdr);
+}
+
+size_t LogFrameEncoder::raw_written(const std::vector<uint8_t>& frames,
+                                    size_t written) {
+  size_t pos = 0;
+  size_t raw = 0;
+
+  while (pos + sizeof(LogFrameHeader) <= written) {
+    LogFrameHeader hdr;
+
+    memcpy(&hdr, frames.data() + pos, sizeof hdr);
+    pos += sizeof hdr + hdr.data_len;
+    if (pos > written) {
+      break;
+    }
+    raw += hdr.raw_len;
+  }
+
+  return raw;
+}
+
+int write_log_file_header(LogFile* f) {
+  LogFileHeader hdr;
+
+  hdr.magic = LOG_FILE_MAGIC;
+  hdr.version = LOG_FILE_VERSION;
+  hdr.header_len = sizeof hdr;
+  hdr.data_start = 0;
+  hdr.reserved = 0;
+
+  ssize_t n = f->write_raw(&hdr, sizeof hdr);
+  if (n > 0) {
+    f->add_size(n);
+  }
+  if (static_cast<size_t>(n) != sizeof hdr) {
+    err_log("write header of %s error", ls2cstring(f->base_name()));
+    return -1;
+  }
+
+  f->set_compressed(sizeof hdr);
+
+  return 0;
+}
+
+int seal_log_file_header(LogFile* f) {
+  uint32_t data_start = static_cast<uint32_t>(f->size());
+
+  if (!f->write_data_to_offset(&data_start, sizeof data_start,
+                               offsetof(LogFileHeader, data_start))) {
+    err_log("seal header of %s error", ls2cstring(f->base_name()));
+    return -1;
+  }
+
+  return 0;
+}
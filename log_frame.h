@@ -0,0 +1,141 @@
+/*
+ *  log_frame.h - compressed log file format.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _LOG_FRAME_H_
+#define _LOG_FRAME_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "data_buf.h"
+#include "lz4_block.h"
+
+/*  A compressed log file consists of
+ *
+ *    1. LogFileHeader;
+ *    2. the prologue: the data written by the log handler when the file
+ *       is created (e.g. the time stamp and the MODEM version), which is
+ *       not compressed so that it can be amended in place;
+ *    3. the frames, each of which is a LogFrameHeader and the LZ4 block
+ *       or the raw data of up to LOG_FRAME_MAX_RAW bytes.
+ *
+ *  Each frame can be decoded independently, so a corrupted or truncated
+ *  frame only loses its own data and the decoder can resynchronize on
+ *  the next frame header. All fields are little endian.
+ */
+
+// "SLZ4"
+static const uint32_t LOG_FILE_MAGIC = 0x345a4c53;
+static const uint16_t LOG_FILE_VERSION = 1;
+// "SLZF"
+static const uint32_t LOG_FRAME_MAGIC = 0x465a4c53;
+static const uint32_t LOG_FRAME_MAX_RAW = 1024 * 1024 * 4;
+
+struct LogFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  // Size of LogFileHeader
+  uint16_t header_len;
+  // File offset of the first frame, 0 if no frame is written
+  uint32_t data_start;
+  uint32_t reserved;
+};
+
+struct LogFrameHeader {
+  uint32_t magic;
+  // Length of the data before compression
+  uint32_t raw_len;
+  // Length of the payload after the header. The payload is the raw
+  // data if data_len equals raw_len, an LZ4 block otherwise.
+  uint32_t data_len;
+  // Check word of the header, see frame_check().
+  uint32_t check;
+};
+
+/*  frame_check - the check word of a frame header.
+ */
+inline uint32_t frame_check(uint32_t raw_len, uint32_t data_len) {
+  return (raw_len * 2654435761u) ^ (data_len * 2246822519u) ^
+         LOG_FRAME_MAGIC;
+}
+
+/*  valid_frame_header - check the magic and the lengths of the header.
+ */
+inline bool valid_frame_header(const LogFrameHeader& hdr) {
+  return LOG_FRAME_MAGIC == hdr.magic && hdr.raw_len &&
+         hdr.raw_len <= LOG_FRAME_MAX_RAW && hdr.data_len &&
+         hdr.data_len <= hdr.raw_len &&
+         frame_check(hdr.raw_len, hdr.data_len) == hdr.check;
+}
+
+class LogFile;
+
+/*  LogFrameEncoder - compress the log data into frames.
+ *
+ *  The data blocks of one write request are cut into frames of
+ *  LOG_FRAME_SIZE bytes. A frame that crosses data blocks is copied to
+ *  the staging buffer first. Frames that can't be compressed are
+ *  stored raw.
+ *
+ *  An encoder is used by one thread at a time.
+ */
+class LogFrameEncoder {
+ public:
+  LogFrameEncoder();
+  LogFrameEncoder(const LogFrameEncoder&) = delete;
+  ~LogFrameEncoder();
+
+  LogFrameEncoder& operator = (const LogFrameEncoder&) = delete;
+
+  /*  encode - compress the data blocks.
+   *  @data: the data blocks.
+   *  @frames: the frames are appended to it.
+   *
+   *  Return the number of data bytes encoded.
+   */
+  size_t encode(const std::vector<DataBuffer*>& data,
+                std::vector<uint8_t>& frames);
+
+  /*  raw_written - get the data length of the frames written.
+   *  @frames: the frames returned by encode().
+   *  @written: number of bytes of frames written to the file.
+   *
+   *  Return the total data length of the complete frames in the first
+   *  written bytes.
+   */
+  static size_t raw_written(const std::vector<uint8_t>& frames,
+                            size_t written);
+
+ private:
+  Lz4Block m_lz4;
+  uint8_t* m_stage;
+  size_t m_stage_len;
+
+  void add_frame(const uint8_t* data, size_t len,
+                 std::vector<uint8_t>& frames);
+};
+
+/*  write_log_file_header - start a compressed log file.
+ *
+ *  The header is written at the file offset, which shall be 0.
+ *
+ *  Return 0 on success, -1 on failure.
+ */
+int write_log_file_header(LogFile* f);
+/*  seal_log_file_header - record the start of the frames in the header.
+ *
+ *  The function is called before the first frame is written, when all
+ *  the prologue has been written.
+ *
+ *  Return 0 on success, -1 on failure.
+ */
+int seal_log_file_header(LogFile* f);
+
+#endif  // !_LOG_FRAME_H_
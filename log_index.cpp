@@ -0,0 +1,154 @@
+/*
+ *  log_index.cpp - time index of the log files.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <sys/time.h>
+#include <time.h>
+
+#include "def_config.h"
+#include "log_file.h"
+#include "log_index.h"
+
+LogIndex::LogIndex(std::weak_ptr<LogFile> file, void* client,
+                   time_sync_callback_t cb)
+    : m_file(file),
+      m_client{client},
+      m_time_sync_cb{cb},
+      m_offset{0},
+      m_last_offset{0},
+      m_last_time{0},
+      m_entries{0} {}
+
+LogIndex::~LogIndex() { close(); }
+
+int LogIndex::start() {
+  auto f = m_file.lock();
+  if (!f) {
+    return -1;
+  }
+
+  // Entries are small, so don't keep too many of them in memory.
+  f->reset_buffer(LOG_INDEX_BUF_SIZE);
+
+  LogIndexHeader hdr;
+
+  hdr.magic = LOG_INDEX_MAGIC;
+  hdr.version = LOG_INDEX_VERSION;
+  hdr.entry_len = sizeof(LogIndexEntry);
+  hdr.interval = LOG_INDEX_INTERVAL;
+  hdr.period = LOG_INDEX_PERIOD;
+
+  if (f->write(&hdr, sizeof hdr, true) != sizeof hdr) {
+    err_log("write header of %s error", ls2cstring(f->base_name()));
+    return -1;
+  }
+
+  return 0;
+}
+
+void LogIndex::add(const LogFile* log, const std::vector<DataBuffer*>& data,
+                   size_t written) {
+  uint64_t file_offset = log->size();
+  bool compressed = log->compressed();
+
+  if (!compressed) {
+    m_offset = file_offset;
+  } else if (!m_entries) {
+    // The frames start after the prologue.
+    m_offset = file_offset - log->header_len();
+  }
+
+  uint64_t now = monotonic_ms();
+  uint64_t offset = m_offset;
+  size_t len = written;
+
+  for (auto buf : data) {
+    if (!len) {
+      break;
+    }
+
+    // Frames are only cut at the start of the request.
+    if (!compressed || offset == m_offset) {
+      uint64_t t = buf->stamp ? buf->stamp : now;
+
+      if (!m_entries || offset - m_last_offset >= LOG_INDEX_INTERVAL ||
+          t >= m_last_time + LOG_INDEX_PERIOD) {
+        add_entry(offset, compressed ? file_offset : offset, t, now);
+      }
+    }
+
+    size_t n = buf->data_len < len ? buf->data_len : len;
+    offset += n;
+    len -= n;
+  }
+
+  m_offset += written;
+}
+
+void LogIndex::add_entry(uint64_t offset, uint64_t file_offset,
+                         uint64_t stamp, uint64_t now) {
+  auto f = m_file.lock();
+  if (!f) {
+    return;
+  }
+
+  LogIndexEntry e;
+  // How long ago the data was read
+  uint64_t age = now > stamp ? now - stamp : 0;
+  struct timeval tv;
+
+  gettimeofday(&tv, nullptr);
+
+  uint64_t us = static_cast<uint64_t>(tv.tv_sec) * 1000000 + tv.tv_usec -
+                age * 1000;
+  time_t sec = static_cast<time_t>(us / 1000000);
+
+  e.offset = offset;
+  e.file_offset = file_offset;
+  e.tv_sec = static_cast<uint32_t>(sec + get_timezone_diff(sec));
+  e.tv_usec = static_cast<uint32_t>(us % 1000000);
+  e.sys_cnt = 0;
+  e.flags = 0;
+
+  time_sync ts;
+
+  if (m_time_sync_cb && m_time_sync_cb(m_client, ts)) {
+    // time_sync.uptime is in seconds of CLOCK_BOOTTIME.
+    struct timespec bt;
+
+    clock_gettime(CLOCK_BOOTTIME, &bt);
+
+    uint64_t up = static_cast<uint64_t>(bt.tv_sec) * 1000 +
+                  bt.tv_nsec / 1000000 - age;
+    e.sys_cnt = static_cast<uint32_t>(
+        ts.sys_cnt + (up - static_cast<uint64_t>(ts.uptime) * 1000));
+    e.flags |= LOG_INDEX_SYS_CNT;
+  }
+
+  if (f->write(&e, sizeof e, true) != sizeof e) {
+    err_log("write %s error", ls2cstring(f->base_name()));
+  }
+
+  m_last_offset = offset;
+  m_last_time = stamp;
+  ++m_entries;
+}
+
+void LogIndex::flush() {
+  if (auto f = m_file.lock()) {
+    f->flush();
+  }
+}
+
+void LogIndex::close() {
+  if (auto f = m_file.lock()) {
+    f->close();
+  }
+  m_file.reset();
+}
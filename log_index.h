@@ -0,0 +1,137 @@
+/*
+ *  log_index.h - time index of the log files.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _LOG_INDEX_H_
+#define _LOG_INDEX_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "cp_log_cmn.h"
+#include "data_buf.h"
+
+class LogFile;
+
+/*  Each log file may have a sidecar index file named <log file>.idx
+ *  in the same directory, which consists of
+ *
+ *    1. LogIndexHeader;
+ *    2. LogIndexEntry records in ascending offset order.
+ *
+ *  An entry is added for the data written at least LOG_INDEX_INTERVAL
+ *  bytes or LOG_INDEX_PERIOD ms after the previous entry. The offsets
+ *  are those of the log file without compression. For compressed log
+ *  files (see log_frame.h), the offset is the one in the output of
+ *  cplogunpack, and file_offset is the frame to start decoding at.
+ *  All fields are little endian.
+ */
+
+// "SIDX"
+static const uint32_t LOG_INDEX_MAGIC = 0x58444953;
+static const uint16_t LOG_INDEX_VERSION = 1;
+
+struct LogIndexHeader {
+  uint32_t magic;
+  uint16_t version;
+  // Size of LogIndexEntry
+  uint16_t entry_len;
+  // Min distance of the entries in bytes and in ms
+  uint32_t interval;
+  uint32_t period;
+};
+
+// LogIndexEntry.flags: sys_cnt is valid
+static const uint32_t LOG_INDEX_SYS_CNT = 1;
+
+struct LogIndexEntry {
+  // Offset of the data in the log file without compression
+  uint64_t offset;
+  // Offset in the log file where the data can be read or decoded from
+  uint64_t file_offset;
+  // AP local time when the data was read, like modem_timestamp
+  uint32_t tv_sec;
+  uint32_t tv_usec;
+  // MODEM time when the data was read
+  uint32_t sys_cnt;
+  uint32_t flags;
+};
+
+/*  LogIndex - write the index of the current log file.
+ *
+ *  The entries are added by the IoScheduler on the main thread when
+ *  the data is written, and written to the index file through the
+ *  small buffer of its LogFile.
+ */
+class LogIndex {
+ public:
+  using time_sync_callback_t = bool (*)(void* client, time_sync& ts);
+
+  /*  LogIndex - constructor.
+   *  @file: the index file, which is empty.
+   *  @client: the client of the time sync callback.
+   *  @cb: the callback to get the MODEM time sync info, or nullptr.
+   */
+  LogIndex(std::weak_ptr<LogFile> file, void* client,
+           time_sync_callback_t cb);
+  LogIndex(const LogIndex&) = delete;
+  ~LogIndex();
+
+  LogIndex& operator = (const LogIndex&) = delete;
+
+  /*  index_name - get the name of the index file of the log file.
+   */
+  static LogString index_name(const LogString& log_name) {
+    return log_name + ".idx";
+  }
+  /*  is_index_name - check whether the file is an index file.
+   */
+  static bool is_index_name(const LogString& name) {
+    return str_ends_with(name, ".idx", 4);
+  }
+
+  /*  start - write the header of the index file.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int start();
+  /*  add - add the entries of the data written to the log file.
+   *  @log: the log file, whose size does not count the data yet.
+   *  @data: the data blocks of the write request.
+   *  @written: the number of bytes of data written.
+   */
+  void add(const LogFile* log, const std::vector<DataBuffer*>& data,
+           size_t written);
+  /*  flush - write the buffered entries to the index file.
+   */
+  void flush();
+  /*  close - flush and close the index file.
+   */
+  void close();
+
+ private:
+  std::weak_ptr<LogFile> m_file;
+  void* m_client;
+  time_sync_callback_t m_time_sync_cb;
+  // Offset of the next data in the log file without compression
+  uint64_t m_offset;
+  // Offset and CLOCK_MONOTONIC ms of the last entry
+  uint64_t m_last_offset;
+  uint64_t m_last_time;
+  unsigned m_entries;
+
+  /*  add_entry - add the entry of the data at the offsets.
+   *  @stamp: CLOCK_MONOTONIC ms when the data was read.
+   *  @now: the current CLOCK_MONOTONIC ms.
+   */
+  void add_entry(uint64_t offset, uint64_t file_offset, uint64_t stamp,
+                 uint64_t now);
+};
+
+#endif  // !_LOG_INDEX_H_
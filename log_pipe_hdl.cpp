@@ -10,6 +10,7 @@
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 #ifdef HOST_TEST_
 #include "sock_test.h"
 #else
@@ -21,9 +22,8 @@
 #include <sys/stat.h>
 #include <sys/time.h>
 #include <sys/types.h>
-#ifdef SUPPORT_RATE_STATISTIC
+#include <sys/uio.h>
 #include <time.h>
-#endif
 #include <unistd.h>
 #include "cp_dir.h"
 #include "cp_set_dir.h"
@@ -46,9 +46,12 @@ LogPipeHandler::LogPipeHandler(LogController* ctrl, Multiplexer* multi,
       m_max_buf{0},
       m_max_buf_num{0},
       m_log_commit_threshold{},
+      m_log_max_requests{1},
       m_buf_commit_threshold{},
+      m_commit_tuning{true},
       m_rate_statistic_{false},
       m_buffer{nullptr},
+      m_next_buffer{nullptr},
       convey_mgr_{new CpConveyManager()},
       log_mode_{LogConfig::LM_OFF},
       m_modem_name(conf->modem_name),
@@ -66,13 +69,17 @@ LogPipeHandler::LogPipeHandler(LogController* ctrl, Multiplexer* multi,
       cur_diag_trans_{nullptr},
       m_stor_mgr{stor_mgr},
       m_storage{nullptr},
+      m_compress_log{conf->compress_log},
+      m_ingest{nullptr},
       m_cp_class{cp_class},
       mean_start_{0, 0},
       mean_data_size_{},
       mean_timer_{},
       period_start_{0, 0},
       step_data_size_{},
-      step_timer_{} {
+      step_timer_{},
+      m_commit_timer{nullptr},
+      m_tune_start{0} {
   // Reset property
   switch (conf->type) {
     case CT_WCDMA:
@@ -83,6 +90,7 @@ LogPipeHandler::LogPipeHandler(LogController* ctrl, Multiplexer* multi,
       m_max_buf = 1024 * 256;
       m_max_buf_num = 12;
       m_log_commit_threshold = 1024 * 128;
+      m_log_max_requests = 3;
       m_buf_commit_threshold = 1024 * 224;
 #ifdef SUPPORT_RATE_STATISTIC
       m_rate_statistic_ = true;
@@ -141,13 +149,29 @@ LogPipeHandler::LogPipeHandler(LogController* ctrl, Multiplexer* multi,
     default:
       break;
   }
+
+  // The geometry in the configuration overrides the defaults above.
+  LogConfig::BufGeometry geo;
+
+  get_buf_geometry(geo);
+  if (merge_buf_geometry(geo, conf->buf_geometry)) {
+    err_log("invalid %s buffer geometry, use the default",
+            ls2cstring(m_modem_name));
+  }
+  apply_buf_geometry(geo);
 }
 
 LogPipeHandler::~LogPipeHandler() {
+  // Detach from the reactor before the storage is deleted.
+  delete m_ingest;
+
   if (m_storage) {
     if (m_buffer) {
       m_storage->free_buffer(m_buffer);
     }
+    if (m_next_buffer) {
+      m_storage->free_buffer(m_next_buffer);
+    }
     m_stor_mgr.delete_storage(m_storage);
   }
 
@@ -160,20 +184,12 @@ LogPipeHandler::~LogPipeHandler() {
     multiplexer()->timer_mgr().del_timer(step_timer_);
     step_timer_ = nullptr;
   }
+  stop_commit_tuning();
 }
 
 int LogPipeHandler::start_logging() {
   log_mode_ = LogConfig::LM_NORMAL;
 
-  if (CWS_WORKING == m_cp_state) {
-    if (-1 == open()) {
-      err_log("open %s error", ls2cstring(m_modem_name));
-      multiplexer()->timer_mgr().add_timer(300, reopen_log_dev, this);
-    } else {
-      multiplexer()->register_fd(this, POLLIN);
-    }
-  }
-
   if (!m_storage) {
     if (create_storage()) {
       err_log("create_storage error");
@@ -187,11 +203,22 @@ int LogPipeHandler::start_logging() {
     m_storage->set_buf_avail_callback(this, buf_avail_callback);
   }
 
+  // The storage is needed by the ingest reactor.
+  if (CWS_WORKING == m_cp_state) {
+    if (-1 == open()) {
+      err_log("open %s error", ls2cstring(m_modem_name));
+      multiplexer()->timer_mgr().add_timer(300, reopen_log_dev, this);
+    } else {
+      watch_log_dev();
+    }
+  }
+
   if (m_rate_statistic_) {
     gettimeofday(&period_start_, 0);
     step_timer_ =
         multiplexer()->timer_mgr().create_timer(60000, data_rate_stat, this);
   }
+  start_commit_tuning();
 
   //User version and log configuration has not changed.
   if (tmp_external_max_size_) {
@@ -228,7 +255,11 @@ void LogPipeHandler::buf_avail_callback(void* client) {
     }
     if (addevt) {
       info_log("buf available, %s enable poll", ls2cstring(log_pipe->name()));
-      log_pipe->add_events(POLLIN);
+      if (log_pipe->m_ingest) {
+        log_pipe->m_ingest->refill();
+      } else {
+        log_pipe->add_events(POLLIN);
+      }
     }
   }
 }
@@ -243,7 +274,7 @@ int LogPipeHandler::stop_logging() {
   delete m_diag_handler;
   m_diag_handler = nullptr;
   if (m_fd >= 0) {
-    multiplexer()->unregister_fd(this);
+    unwatch_log_dev();
     ::close(m_fd);
     m_fd = -1;
   }
@@ -252,6 +283,7 @@ int LogPipeHandler::stop_logging() {
     multiplexer()->timer_mgr().del_timer(step_timer_);
     step_timer_ = nullptr;
   }
+  stop_commit_tuning();
   return 0;
 }
 
@@ -261,58 +293,183 @@ void LogPipeHandler::close_devices() {
 }
 
 void LogPipeHandler::process(int /*events*/) {
-  if (!m_buffer) {
-    m_buffer = m_storage->get_buffer();
-    if (!m_buffer) {  // No free buffers
-      err_log("no buffer for %s", ls2cstring(m_modem_name));
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  size_t total = 0;
+  // Time stamp of the log read in this call
+  uint64_t stamp = static_cast<uint64_t>(start.tv_sec) * 1000 +
+                   start.tv_nsec / 1000000;
+
+  // Read until EAGAIN or the budget is used up.
+  while (total < LOG_READ_BUDGET) {
+    if (!m_buffer) {
+      m_buffer = m_storage->get_buffer();
+      if (!m_buffer) {  // No free buffers
+        err_log("no buffer for %s", ls2cstring(m_modem_name));
 
-      del_events(POLLIN);
+        del_events(POLLIN);
+        return;
+      }
+    }
+
+    struct iovec iov[2];
+    int iov_num = 1;
+    size_t wr_start = m_buffer->data_start + m_buffer->data_len;
+    size_t rlen = m_buffer->buf_size - wr_start;
+
+    iov[0].iov_base = m_buffer->buffer + wr_start;
+    iov[0].iov_len = rlen;
+    // Read into the next buffer too when the current one is nearly
+    // full, so that the read is not cut short.
+    if (rlen < m_buffer->buf_size / 2) {
+      if (!m_next_buffer) {
+        m_next_buffer = m_storage->get_buffer();
+      }
+      if (m_next_buffer) {
+        iov[1].iov_base = m_next_buffer->buffer + m_next_buffer->data_start +
+                          m_next_buffer->data_len;
+        iov[1].iov_len = m_next_buffer->buf_size -
+                         m_next_buffer->data_start - m_next_buffer->data_len;
+        iov_num = 2;
+      }
+    }
+
+    ssize_t nr = readv(fd(), iov, iov_num);
+
+    if (nr <= 0) {
+      if (-1 == nr) {
+        if (EAGAIN == errno || EINTR == errno || ENODATA == errno) {
+          return;
+        }
+        err_log("read %s error", ls2cstring(m_modem_name));
+        // Other errors: try to reopen the device
+        reopen_on_error();
+      } else {
+        err_log("read %s returns 0, fd = %d", ls2cstring(m_modem_name),
+                fd());
+      }
       return;
     }
-  }
-  size_t wr_start = m_buffer->data_start + m_buffer->data_len;
-  uint8_t* wr_ptr = m_buffer->buffer + wr_start;
-  size_t rlen = m_buffer->buf_size - wr_start;
-  ssize_t nr = read(fd(), wr_ptr, rlen);
 
-  if (nr > 0) {
     if (m_rate_statistic_) {
       step_data_size_ += nr;
     }
+    m_tuner.account(nr);
+    total += nr;
 
-    m_buffer->data_len += nr;
+    size_t len = static_cast<size_t>(nr);
+    if (!m_buffer->data_len) {
+      m_buffer->stamp = stamp;
+    }
+    if (len > rlen) {
+      m_buffer->data_len += rlen;
+      if (!m_next_buffer->data_len) {
+        m_next_buffer->stamp = stamp;
+      }
+      m_next_buffer->data_len += len - rlen;
+    } else {
+      m_buffer->data_len += len;
+    }
 
-    if (m_buffer->data_len >= m_buf_commit_threshold) {
-      int err = m_storage->write(m_buffer);
+    if (m_buffer->data_len >= m_tuner.buf_threshold() || len >= rlen) {
+      commit_buffer();
+    }
 
-      if (err < 0) {
-        err_log("enqueue CP %s log error, %u bytes discarded",
-                ls2cstring(m_modem_name),
-                static_cast<unsigned>(m_buffer->data_len));
-        m_buffer->data_start = m_buffer->data_len = 0;
-      } else {
-        m_buffer = nullptr;
-      }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((now.tv_sec - start.tv_sec) * 1000 +
+            (now.tv_nsec - start.tv_nsec) / 1000000 >=
+        static_cast<long>(LOG_READ_BUDGET_TIME)) {
+      break;
+    }
+  }
+}
+
+void LogPipeHandler::commit_buffer() {
+  int err = m_storage->write(m_buffer);
+
+  if (err < 0) {
+    err_log("enqueue CP %s log error, %u bytes discarded",
+            ls2cstring(m_modem_name),
+            static_cast<unsigned>(m_buffer->data_len));
+    m_buffer->data_start = m_buffer->data_len = 0;
+    m_buffer->stamp = 0;
+    if (m_next_buffer && m_next_buffer->data_len) {
+      std::swap(m_buffer, m_next_buffer);
     }
   } else {
-    if (-1 == nr) {
-      err_log("read %s error", ls2cstring(m_modem_name));
-      if (EAGAIN == errno || EINTR == errno || ENODATA == errno) {
-        err_log("read data error, errno:%d", errno);
+    m_buffer = m_next_buffer;
+    m_next_buffer = nullptr;
+  }
+}
+
+int LogPipeHandler::use_ingest_reactor(IngestReactor* reactor) {
+  if (m_ingest) {
+    return 0;
+  }
+
+  m_ingest = new IngestChannel(controller(), multiplexer(), reactor,
+                               this, ingest_callback);
+  if (m_ingest->init()) {
+    delete m_ingest;
+    m_ingest = nullptr;
+    return -1;
+  }
+
+  return 0;
+}
+
+void LogPipeHandler::watch_log_dev() {
+  if (m_ingest) {
+    if (m_storage) {
+      // The reactor reads into its own buffers.
+      release_buffers();
+      // Keep one buffer for the writes of the main thread.
+      size_t free_bufs = m_max_buf_num > 1 ? m_max_buf_num - 1 : 1;
+      if (!m_ingest->attach(m_fd, m_storage, m_tuner.buf_threshold(),
+                            free_bufs)) {
         return;
       }
-      // Other errors: try to reopen the device
-      multiplexer()->unregister_fd(this);
-      close_devices();
-      if (open() >= 0) {  // Success
-        multiplexer()->register_fd(this, POLLIN);
-        info_log("%s reopened", ls2cstring(m_modem_name));
-      } else {  // Failure: arrange a check callback
-        multiplexer()->timer_mgr().add_timer(300, reopen_log_dev, this);
-      }
-    } else {
-      err_log("read %s returns 0, fd = %d", ls2cstring(m_modem_name), fd());
     }
+    err_log("%s falls back to the main thread", ls2cstring(m_modem_name));
+    delete m_ingest;
+    m_ingest = nullptr;
+  }
+
+  multiplexer()->register_fd(this, POLLIN);
+}
+
+void LogPipeHandler::unwatch_log_dev() {
+  if (m_ingest) {
+    m_ingest->detach();
+  } else {
+    multiplexer()->unregister_fd(this);
+  }
+}
+
+void LogPipeHandler::reopen_on_error() {
+  unwatch_log_dev();
+  close_devices();
+  if (open() >= 0) {  // Success
+    watch_log_dev();
+    info_log("%s reopened", ls2cstring(m_modem_name));
+  } else {  // Failure: arrange a check callback
+    multiplexer()->timer_mgr().add_timer(300, reopen_log_dev, this);
+  }
+}
+
+void LogPipeHandler::ingest_callback(void* client, IngestChannel::Event evt,
+                                     size_t len) {
+  LogPipeHandler* log_pipe = static_cast<LogPipeHandler*>(client);
+
+  if (IngestChannel::IE_DATA == evt) {
+    if (log_pipe->m_rate_statistic_) {
+      log_pipe->step_data_size_ += len;
+    }
+    log_pipe->m_tuner.account(len);
+  } else {
+    err_log("read %s error", ls2cstring(log_pipe->m_modem_name));
+    log_pipe->reopen_on_error();
   }
 }
 
@@ -322,7 +479,7 @@ void LogPipeHandler::reopen_log_dev(void* param) {
   if (LogConfig::LM_NORMAL == log_pipe->log_mode_ &&
       CWS_WORKING == log_pipe->m_cp_state) {
     if (log_pipe->open() >= 0) {
-      log_pipe->multiplexer()->register_fd(log_pipe, POLLIN);
+      log_pipe->watch_log_dev();
       info_log("%s opened, fd = %d", ls2cstring(log_pipe->m_modem_name), log_pipe->fd());
     } else {
       TimerManager& tmgr = log_pipe->multiplexer()->timer_mgr();
@@ -342,7 +499,7 @@ void LogPipeHandler::process_alive() {
   if (LogConfig::LM_NORMAL == log_mode_ && -1 == m_fd) {
     multiplexer()->timer_mgr().del_timer(reopen_log_dev);
     if (open() >= 0) {
-      multiplexer()->register_fd(this, POLLIN);
+      watch_log_dev();
     } else {
       multiplexer()->timer_mgr().add_timer(300, reopen_log_dev, this);
     }
@@ -352,7 +509,7 @@ void LogPipeHandler::process_alive() {
 
 void LogPipeHandler::close_on_assert() {
   if (m_fd >= 0) {
-    multiplexer()->unregister_fd(this);
+    unwatch_log_dev();
   }
   close_devices();
 
@@ -443,6 +600,8 @@ int LogPipeHandler::create_storage() {
                                         m_max_buf_num,
                                         m_log_commit_threshold);
   if (m_storage) {
+    m_storage->set_log_max_requests(m_log_max_requests);
+    m_storage->set_log_compression(m_compress_log);
     ret = 0;
   } else {
     err_log("create %s CpStorage failed", ls2cstring(m_modem_name));
@@ -543,24 +702,212 @@ int LogPipeHandler::copy_files(LogFile::LogType file_type,
   return err_code;
 }
 
+void LogPipeHandler::release_buffers() {
+  if (m_buffer) {
+    if (m_buffer->data_len) {
+      if (m_storage->write(m_buffer)) {  // write failed
+        m_storage->free_buffer(m_buffer);
+      }
+    } else {  // Buffer empty
+      m_storage->free_buffer(m_buffer);
+    }
+    m_buffer = nullptr;
+  }
+  if (m_next_buffer) {
+    if (m_next_buffer->data_len) {
+      if (m_storage->write(m_next_buffer)) {  // write failed
+        m_storage->free_buffer(m_next_buffer);
+      }
+    } else {  // Buffer empty
+      m_storage->free_buffer(m_next_buffer);
+    }
+    m_next_buffer = nullptr;
+  }
+}
+
 void LogPipeHandler::flush() {
   info_log("LogPipeHandler::flush() enter m_storage= %lu,m_buffer =%lu",
            m_storage,m_buffer);
   if (m_storage) {
-    if (m_buffer) {
-      if (m_buffer->data_len) {
-        if (m_storage->write(m_buffer)) {  // write failed
-          m_storage->free_buffer(m_buffer);
-        }
-      } else {  // Buffer empty
-        m_storage->free_buffer(m_buffer);
-      }
-      m_buffer = nullptr;
+    if (m_ingest) {
+      m_ingest->flush();
     }
+    release_buffers();
     m_storage->flush();
   }
 }
 
+int LogPipeHandler::merge_buf_geometry(LogConfig::BufGeometry& cur,
+                                       const LogConfig::BufGeometry& geo) {
+  LogConfig::BufGeometry res = cur;
+
+  if (geo.max_buf) {
+    res.max_buf = geo.max_buf;
+  }
+  if (geo.max_buf_num) {
+    res.max_buf_num = geo.max_buf_num;
+  }
+  if (geo.log_commit_threshold) {
+    res.log_commit_threshold = geo.log_commit_threshold;
+  }
+  if (geo.buf_commit_threshold) {
+    res.buf_commit_threshold = geo.buf_commit_threshold;
+  }
+
+  if (res.max_buf < LOG_BUF_MIN_SIZE || res.max_buf > LOG_BUF_MAX_SIZE ||
+      res.max_buf_num < 2 || res.max_buf_num > LOG_BUF_MAX_NUM ||
+      !res.log_commit_threshold || !res.buf_commit_threshold ||
+      res.buf_commit_threshold > res.max_buf) {
+    err_log("invalid buffer geometry %u %u %u %u",
+            static_cast<unsigned>(res.max_buf),
+            static_cast<unsigned>(res.max_buf_num),
+            static_cast<unsigned>(res.log_commit_threshold),
+            static_cast<unsigned>(res.buf_commit_threshold));
+    return -1;
+  }
+
+  cur = res;
+  return 0;
+}
+
+void LogPipeHandler::apply_buf_geometry(const LogConfig::BufGeometry& geo) {
+  m_max_buf = geo.max_buf;
+  m_max_buf_num = geo.max_buf_num;
+  m_log_commit_threshold = geo.log_commit_threshold;
+  m_buf_commit_threshold = geo.buf_commit_threshold;
+  m_tuner.set_bounds(m_buf_commit_threshold, m_log_commit_threshold);
+}
+
+void LogPipeHandler::get_buf_geometry(LogConfig::BufGeometry& geo) const {
+  geo.max_buf = m_max_buf;
+  geo.max_buf_num = m_max_buf_num;
+  geo.log_commit_threshold = m_log_commit_threshold;
+  geo.buf_commit_threshold = m_buf_commit_threshold;
+}
+
+int LogPipeHandler::set_buf_geometry(const LogConfig::BufGeometry& geo) {
+  LogConfig::BufGeometry cur;
+
+  get_buf_geometry(cur);
+  if (merge_buf_geometry(cur, geo)) {
+    return LCR_PARAM_INVALID;
+  }
+
+  if (!m_storage) {  // Used when the storage is created
+    apply_buf_geometry(cur);
+    return LCR_SUCCESS;
+  }
+
+  // Stop reading and queue the buffered log, then wait for the queue
+  // to be written so that the old buffers are idle.
+  bool attached = m_ingest && m_ingest->attached();
+
+  if (attached) {
+    m_ingest->detach();
+  }
+  release_buffers();
+  m_storage->flush();
+
+  int ret = LCR_SUCCESS;
+
+  if (m_storage->resize_log_buffers(cur.max_buf, cur.max_buf_num)) {
+    err_log("resize %s buffers error", ls2cstring(m_modem_name));
+    ret = LCR_ERROR;
+  } else {
+    m_storage->set_log_commit_threshold(cur.log_commit_threshold);
+    apply_buf_geometry(cur);
+    info_log("%s buffer geometry %u %u %u %u", ls2cstring(m_modem_name),
+             static_cast<unsigned>(m_max_buf),
+             static_cast<unsigned>(m_max_buf_num),
+             static_cast<unsigned>(m_log_commit_threshold),
+             static_cast<unsigned>(m_buf_commit_threshold));
+  }
+
+  if (attached) {
+    watch_log_dev();
+  }
+
+  return ret;
+}
+
+void LogPipeHandler::apply_commit_thresholds() {
+  if (m_storage) {
+    m_storage->set_log_commit_threshold(m_tuner.log_threshold());
+  }
+  if (m_ingest) {
+    m_ingest->set_commit_threshold(m_tuner.buf_threshold());
+  }
+}
+
+void LogPipeHandler::commit_aged_log(uint64_t now) {
+  unsigned max_age = m_tuner.max_age();
+
+  if (!max_age || !m_storage) {
+    return;
+  }
+
+  if (m_ingest) {
+    uint64_t stamp = m_ingest->pending_stamp();
+
+    if (m_ingest->attached() && stamp && now - stamp >= max_age) {
+      m_ingest->flush();
+    }
+  } else if (m_buffer && m_buffer->data_len &&
+             now - m_buffer->stamp >= max_age) {
+    commit_buffer();
+  }
+
+  m_storage->commit_aged_log(now, max_age);
+}
+
+void LogPipeHandler::start_commit_tuning() {
+  if (!m_commit_tuning || !m_storage || m_commit_timer) {
+    return;
+  }
+
+  m_tune_start = monotonic_ms();
+  m_commit_timer = multiplexer()->timer_mgr().create_timer(m_tuner.tick(),
+                                                           commit_tick,
+                                                           this);
+}
+
+void LogPipeHandler::stop_commit_tuning() {
+  if (m_commit_timer) {
+    multiplexer()->timer_mgr().del_timer(m_commit_timer);
+    m_commit_timer = nullptr;
+  }
+}
+
+void LogPipeHandler::commit_tick(void* param) {
+  LogPipeHandler* log_pipe = static_cast<LogPipeHandler*>(param);
+  CommitTuner& tuner = log_pipe->m_tuner;
+  uint64_t now = monotonic_ms();
+
+  log_pipe->m_commit_timer = nullptr;
+
+  if (now - log_pipe->m_tune_start >= LOG_COMMIT_TUNE_PERIOD) {
+    AgeHistogram& hist = log_pipe->m_storage->log_data_age();
+
+    tuner.set_data_age(hist);
+    hist.clear();
+    if (tuner.adjust(static_cast<unsigned>(now - log_pipe->m_tune_start))) {
+      log_pipe->apply_commit_thresholds();
+      info_log("%s rate %u, commit thresholds %u/%u, max age %u ms",
+               ls2cstring(log_pipe->m_modem_name), tuner.rate(),
+               static_cast<unsigned>(tuner.buf_threshold()),
+               static_cast<unsigned>(tuner.log_threshold()),
+               tuner.max_age());
+    }
+    log_pipe->m_tune_start = now;
+  }
+
+  log_pipe->commit_aged_log(now);
+
+  TimerManager& tmgr = log_pipe->multiplexer()->timer_mgr();
+  log_pipe->m_commit_timer = tmgr.create_timer(tuner.tick(), commit_tick,
+                                               param);
+}
+
 void LogPipeHandler::set_wcn_dump_prop() {
   property_set(MODEM_WCN_DUMP_LOG_COMPLETE, "1");
 }
@@ -616,7 +963,12 @@ int LogPipeHandler::start_diag_trans(TransDiagDevice& trans,
   if (m_log_diag_same) {
     m_diag_handler =
         new DiagDeviceHandler(fd(), &trans, controller(), multiplexer());
-    del_events(POLLIN);
+    // The diag handler reads the device on the main thread.
+    if (m_ingest) {
+      m_ingest->detach();
+    } else {
+      del_events(POLLIN);
+    }
   } else {
     m_diag_handler = new DiagDeviceHandler(m_diag_dev_path, &trans,
                                            controller(), multiplexer());
@@ -645,7 +997,11 @@ void LogPipeHandler::stop_diag_trans() {
     delete m_diag_handler;
     m_diag_handler = nullptr;
     if (m_log_diag_same && fd() >= 0) {
-      add_events(POLLIN);
+      if (m_ingest) {
+        watch_log_dev();
+      } else {
+        add_events(POLLIN);
+      }
     }
 
     TransModem::Type t = cur_diag_trans_->type();
@@ -730,8 +1086,10 @@ int LogPipeHandler::start_log_convey(void* client,
                              cpset->cp_class(), dir, cpset->priority())});
   }
 
+  // Log collection is requested by the user.
   trans = new TransLogConvey(convey_mgr_, TransModem::CONVEY_LOG,
-                             controller()->convey_workshop());
+                             controller()->convey_workshop(),
+                             ConveyUnitBase::Interactive);
   trans->set_client(client, cb);
 
   trans->add_units(units);
@@ -19,9 +19,11 @@
 
 #include "cp_convey_mgr.h"
 #include "cp_log_cmn.h"
+#include "commit_tuner.h"
 #include "cp_stat_hdl.h"
 #include "evt_notifier.h"
 #include "fd_hdl.h"
+#include "ingest_reactor.h"
 #include "log_config.h"
 #include "log_file.h"
 #include "req_err.h"
@@ -90,6 +92,19 @@ class LogPipeHandler : public FdHandler, public TransactionManager {
 
   void set_overwrite(bool ow) { overwrite_ = ow; }
   bool get_overwrite() const { return overwrite_; }
+
+  /*  set_buf_geometry - change the log buffer geometry.
+   *  @geo: the new geometry. Zero fields keep the current values.
+   *
+   *  The buffered log is queued for writing before the buffers are
+   *  reallocated, so no log is lost.
+   *
+   *  Return LCR_SUCCESS on success, LCR_PARAM_INVALID if the geometry
+   *  is invalid, LCR_ERROR if the buffers can not be changed.
+   */
+  int set_buf_geometry(const LogConfig::BufGeometry& geo);
+  void get_buf_geometry(LogConfig::BufGeometry& geo) const;
+  const CommitTuner& commit_tuner() const { return m_tuner; }
   bool log_diag_dev_same() const { return m_log_diag_same; }
 
   const LogString& log_dev_path() const { return m_log_dev_path; }
@@ -131,6 +146,15 @@ class LogPipeHandler : public FdHandler, public TransactionManager {
 
   bool in_transaction() const { return m_cp_state > CWS_WORKING; }
 
+  /*  use_ingest_reactor - read the log device on the reactor thread.
+   *  @reactor: the started IngestReactor.
+   *
+   *  The function shall be called before the handler is started.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int use_ingest_reactor(IngestReactor* reactor);
+
   /*  start - Initialize the log device and start logging.
    *  @mode: the log mode to start.
    *
@@ -308,6 +332,26 @@ protected:
 
   void close_on_assert();
 
+  /*  watch_log_dev - start reading the opened log device, either on the
+   *                  ingest reactor or on the multiplexer.
+   */
+  void watch_log_dev();
+  /*  unwatch_log_dev - stop reading the log device.
+   *
+   *  The log device may be closed after the function returns.
+   */
+  void unwatch_log_dev();
+  /*  reopen_on_error - reopen the log device after a read error.
+   */
+  void reopen_on_error();
+  /*  release_buffers - write or free m_buffer and m_next_buffer.
+   */
+  void release_buffers();
+  /*  commit_buffer - pass m_buffer to the storage and continue with
+   *                  m_next_buffer.
+   */
+  void commit_buffer();
+
   void notify_dump_start();
   void notify_dump_ongoing();
   void notify_dump_end();
@@ -320,6 +364,15 @@ protected:
   static void new_log_callback(LogPipeHandler* cp, LogFile* f) {
     cp->on_new_log_file(f);
   }
+  /*  get_time_sync - get the time sync info of the CP for the time
+   *                  index of the log files.
+   *
+   *  Return true if the time sync info is available.
+   */
+  virtual bool get_time_sync(time_sync& /*ts*/) { return false; }
+  static bool time_sync_callback(LogPipeHandler* cp, time_sync& ts) {
+    return cp->get_time_sync(ts);
+  }
   /*
    *    reopen_log_dev - Try to open the log device and the mini
    *                     dump device.
@@ -330,15 +383,43 @@ protected:
 
   static void set_wcn_dump_prop();
 
+  /*  merge_buf_geometry - override the geometry by the non-zero fields
+   *                       of geo.
+   *
+   *  Return 0 on success, -1 if the result is invalid, in which case
+   *  cur is not changed.
+   */
+  static int merge_buf_geometry(LogConfig::BufGeometry& cur,
+                                const LogConfig::BufGeometry& geo);
+  void apply_buf_geometry(const LogConfig::BufGeometry& geo);
+
+  /*  apply_commit_thresholds - use the thresholds of the tuner.
+   */
+  void apply_commit_thresholds();
+  /*  commit_aged_log - commit the log read max age ms ago.
+   */
+  void commit_aged_log(uint64_t now);
+  void start_commit_tuning();
+  void stop_commit_tuning();
+  /*  commit_tick - tune the commit thresholds and check the data age.
+   */
+  static void commit_tick(void* param);
+
  protected:
   size_t m_max_buf;
   size_t m_max_buf_num;
   size_t m_log_commit_threshold;
+  // Maximum number of write requests in flight
+  unsigned m_log_max_requests;
   // Commit threshold for a single buffer
   size_t m_buf_commit_threshold;
+  // Adapt the commit thresholds to the log rate
+  bool m_commit_tuning;
   bool m_rate_statistic_;
   // Log data buffer
   DataBuffer* m_buffer;
+  // The buffer read into after m_buffer by readv()
+  DataBuffer* m_next_buffer;
   // Convey Manager
   CpConveyManager* convey_mgr_;
   // assert info,save assert info if minidump fail
@@ -347,6 +428,8 @@ protected:
 
  private:
   static void buf_avail_callback(void* client);
+  static void ingest_callback(void* client, IngestChannel::Event evt,
+                              size_t len);
 
   static void data_rate_stat(void* param);
   static void mean_rate_stat(void* param);
@@ -380,6 +463,10 @@ protected:
   TransDiagDevice* cur_diag_trans_;
   StorageManager& m_stor_mgr;
   CpStorage* m_storage;
+  // Write the log files compressed
+  bool m_compress_log;
+  // Reactor end of the log device when it's read on the ingest reactor
+  IngestChannel* m_ingest;
   CpClass m_cp_class;
 
   // Event subscription
@@ -390,10 +477,16 @@ protected:
   // Data rate statistics
   struct timeval mean_start_;
   unsigned long long mean_data_size_;
-  TimerManager::Timer* mean_timer_;
+  TimerManager::TimerHandle mean_timer_;
   struct timeval period_start_;
   size_t step_data_size_;
-  TimerManager::Timer* step_timer_;
+  TimerManager::TimerHandle step_timer_;
+
+  // Commit thresholds under the bounds of the buffer geometry
+  CommitTuner m_tuner;
+  TimerManager::TimerHandle m_commit_timer;
+  // Start of the current tuning period in ms
+  uint64_t m_tune_start;
 };
 
 #endif  // !LOG_PIPE_HDL_H_
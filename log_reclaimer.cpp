@@ -0,0 +1,124 @@
+/*
+ *  log_reclaimer.cpp - background removal of deleted logs.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "log_reclaimer.h"
+
+LogReclaimer::LogReclaimer() : m_quit{false} {}
+
+LogReclaimer::~LogReclaimer() {
+  if (m_thread.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_quit = true;
+    }
+    m_cond.notify_one();
+    m_thread.join();
+  }
+}
+
+int LogReclaimer::start() {
+  if (m_thread.joinable()) {
+    return 0;
+  }
+
+  try {
+    m_thread = std::thread(&LogReclaimer::run, this);
+  } catch (const std::system_error& e) {
+    err_log("create reclaimer thread error: %s", e.what());
+    return -1;
+  }
+
+  return 0;
+}
+
+void LogReclaimer::reclaim(
+    const LogString& path, uint64_t size,
+    const std::shared_ptr<std::atomic<uint64_t>>& pending) {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_items.push_back(Item{path, size, pending});
+  }
+  m_cond.notify_one();
+}
+
+void LogReclaimer::run() {
+  std::deque<Item> batch;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_cond.wait(lock, [this] { return m_quit || !m_items.empty(); });
+      // The remaining items are reclaimed on the next start.
+      if (m_quit) {
+        break;
+      }
+      batch.swap(m_items);
+    }
+
+    for (auto& item : batch) {
+      if (remove_path(item.path)) {
+        err_log("reclaim %s error", ls2cstring(item.path));
+      }
+      // The space is not expected back once the removal failed.
+      if (item.pending && item.size) {
+        item.pending->fetch_sub(item.size);
+      }
+    }
+    info_log("%u trash items reclaimed", static_cast<unsigned>(batch.size()));
+    batch.clear();
+  }
+}
+
+int LogReclaimer::remove_path(const LogString& path) {
+  struct stat file_stat;
+
+  if (lstat(ls2cstring(path), &file_stat)) {
+    return ENOENT == errno ? 0 : -1;
+  }
+
+  if (!S_ISDIR(file_stat.st_mode)) {
+    if (unlink(ls2cstring(path)) && ENOENT != errno) {
+      return -1;
+    }
+    return 0;
+  }
+
+  DIR* pd = opendir(ls2cstring(path));
+  if (!pd) {
+    return -1;
+  }
+
+  int ret = 0;
+  while (true) {
+    struct dirent* dent = readdir(pd);
+    if (!dent) {
+      break;
+    }
+    if (!strcmp(dent->d_name, ".") || !strcmp(dent->d_name, "..")) {
+      continue;
+    }
+    if (remove_path(path + "/" + dent->d_name)) {
+      ret = -1;
+    }
+  }
+  closedir(pd);
+
+  if (!ret && rmdir(ls2cstring(path)) && ENOENT != errno) {
+    ret = -1;
+  }
+
+  return ret;
+}
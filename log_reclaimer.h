@@ -0,0 +1,74 @@
+/*
+ *  log_reclaimer.h - background removal of deleted logs.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _LOG_RECLAIMER_H_
+#define _LOG_RECLAIMER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "cp_log_cmn.h"
+
+/*  LogReclaimer - remove the files and directories moved to the trash
+ *                 directories of the media.
+ *
+ *  Deleting a large file may take hundreds of milliseconds on some file
+ *  systems, so the main thread only renames the log into the trash
+ *  directory of the media and the reclaimer thread removes it later.
+ */
+class LogReclaimer {
+ public:
+  LogReclaimer();
+  LogReclaimer(const LogReclaimer&) = delete;
+  ~LogReclaimer();
+
+  LogReclaimer& operator = (const LogReclaimer&) = delete;
+
+  /*  start - start the reclaimer thread.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int start();
+
+  /*  reclaim - queue the file or directory for removal.
+   *  @path: path of the file or directory in a trash directory.
+   *  @size: bytes to be freed.
+   *  @pending: the counter of bytes to be freed on the media. size is
+   *            subtracted from it when path is removed.
+   */
+  void reclaim(const LogString& path, uint64_t size,
+               const std::shared_ptr<std::atomic<uint64_t>>& pending);
+
+ private:
+  struct Item {
+    LogString path;
+    uint64_t size;
+    std::shared_ptr<std::atomic<uint64_t>> pending;
+  };
+
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cond;
+  std::deque<Item> m_items;
+  bool m_quit;
+
+  void run();
+
+  /*  remove_path - remove the file or the directory tree.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  static int remove_path(const LogString& path);
+};
+
+#endif  // !_LOG_RECLAIMER_H_
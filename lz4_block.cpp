@@ -0,0 +1,253 @@
+/*
+ *  lz4_block.cpp - LZ4 block compression.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cstring>
+
+#include "lz4_block.h"
+
+namespace {
+
+// Limits of the LZ4 block format
+const size_t MIN_MATCH = 4;
+// The last LAST_LITERALS bytes are always literals.
+const size_t LAST_LITERALS = 5;
+// A match shall start at least MF_LIMIT bytes before the end.
+const size_t MF_LIMIT = 12;
+const size_t MAX_OFFSET = 65535;
+// The search step grows every 2^SKIP_TRIGGER bytes without a match.
+const unsigned SKIP_TRIGGER = 6;
+
+inline uint32_t read32(const uint8_t* p) {
+  uint32_t v;
+
+  memcpy(&v, p, sizeof v);
+  return v;
+}
+
+inline uint64_t read64(const uint8_t* p) {
+  uint64_t v;
+
+  memcpy(&v, p, sizeof v);
+  return v;
+}
+
+/*  count_match - count the equal bytes of p and r before limit.
+ */
+inline const uint8_t* count_match(const uint8_t* p, const uint8_t* r,
+                                  const uint8_t* limit) {
+  while (p + 8 <= limit && read64(p) == read64(r)) {
+    p += 8;
+    r += 8;
+  }
+  while (p < limit && *p == *r) {
+    ++p;
+    ++r;
+  }
+
+  return p;
+}
+
+/*  put_length - write the extra bytes of a literal or match length.
+ */
+inline uint8_t* put_length(uint8_t* op, size_t len) {
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = static_cast<uint8_t>(len);
+
+  return op;
+}
+
+/*  get_length - read the extra bytes of a literal or match length.
+ *
+ *  Return false if the input ends.
+ */
+inline bool get_length(const uint8_t*& ip, const uint8_t* iend,
+                       size_t& len) {
+  uint8_t b;
+
+  do {
+    if (ip >= iend) {
+      return false;
+    }
+    b = *ip++;
+    len += b;
+  } while (255 == b);
+
+  return true;
+}
+
+}  // namespace
+
+Lz4Block::Lz4Block() : m_table{new uint32_t[1 << HASH_LOG]} {}
+
+Lz4Block::~Lz4Block() { delete [] m_table; }
+
+size_t Lz4Block::compress(const uint8_t* src, size_t len, uint8_t* dst,
+                          size_t cap) {
+  if (len > MAX_BLOCK_LEN) {
+    return 0;
+  }
+
+  const uint8_t* ip = src;
+  const uint8_t* anchor = src;
+  const uint8_t* const iend = src + len;
+  uint8_t* op = dst;
+  uint8_t* const oend = dst + cap;
+
+  if (len > MF_LIMIT) {
+    const uint8_t* const mflimit = iend - MF_LIMIT;
+    const uint8_t* const match_limit = iend - LAST_LITERALS;
+
+    // Unset entries point to the start of the block, which is checked
+    // like any other candidate.
+    memset(m_table, 0, sizeof(uint32_t) << HASH_LOG);
+    ++ip;
+
+    while (ip < mflimit) {
+      uint32_t seq = read32(ip);
+      uint32_t h = (seq * 2654435761u) >> (32 - HASH_LOG);
+      const uint8_t* ref = src + m_table[h];
+
+      m_table[h] = static_cast<uint32_t>(ip - src);
+      if (static_cast<size_t>(ip - ref) > MAX_OFFSET || read32(ref) != seq) {
+        ip += 1 + ((ip - anchor) >> SKIP_TRIGGER);
+        continue;
+      }
+
+      // Extend the match backwards into the pending literals.
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        --ip;
+        --ref;
+      }
+
+      const uint8_t* mend = count_match(ip + MIN_MATCH, ref + MIN_MATCH,
+                                        match_limit);
+      size_t lit = ip - anchor;
+      size_t mlen = mend - ip - MIN_MATCH;
+
+      // Token, literals, offset and the length bytes
+      if (static_cast<size_t>(oend - op) <
+          1 + lit / 255 + 1 + lit + 2 + mlen / 255 + 1) {
+        return 0;
+      }
+
+      uint8_t* token = op++;
+
+      if (lit >= 15) {
+        *token = 15 << 4;
+        op = put_length(op, lit - 15);
+      } else {
+        *token = static_cast<uint8_t>(lit << 4);
+      }
+      memcpy(op, anchor, lit);
+      op += lit;
+
+      size_t offset = ip - ref;
+      *op++ = static_cast<uint8_t>(offset);
+      *op++ = static_cast<uint8_t>(offset >> 8);
+
+      if (mlen >= 15) {
+        *token |= 15;
+        op = put_length(op, mlen - 15);
+      } else {
+        *token |= static_cast<uint8_t>(mlen);
+      }
+
+      ip = mend;
+      anchor = ip;
+      if (ip < mflimit) {
+        // Index a position inside the match for the next search.
+        const uint8_t* p = ip - 2;
+        m_table[(read32(p) * 2654435761u) >> (32 - HASH_LOG)] =
+            static_cast<uint32_t>(p - src);
+      }
+    }
+  }
+
+  // The last literals
+  size_t lit = iend - anchor;
+
+  if (static_cast<size_t>(oend - op) < 1 + lit / 255 + 1 + lit) {
+    return 0;
+  }
+  if (lit >= 15) {
+    *op++ = 15 << 4;
+    op = put_length(op, lit - 15);
+  } else {
+    *op++ = static_cast<uint8_t>(lit << 4);
+  }
+  memcpy(op, anchor, lit);
+  op += lit;
+
+  return op - dst;
+}
+
+ssize_t Lz4Block::decompress(const uint8_t* src, size_t len, uint8_t* dst,
+                             size_t cap) {
+  const uint8_t* ip = src;
+  const uint8_t* const iend = src + len;
+  uint8_t* op = dst;
+  uint8_t* const oend = dst + cap;
+
+  while (ip < iend) {
+    uint8_t token = *ip++;
+    size_t lit = token >> 4;
+
+    if (15 == lit && !get_length(ip, iend, lit)) {
+      return -1;
+    }
+    if (lit > static_cast<size_t>(iend - ip) ||
+        lit > static_cast<size_t>(oend - op)) {
+      return -1;
+    }
+    memcpy(op, ip, lit);
+    ip += lit;
+    op += lit;
+
+    // The last sequence has no match.
+    if (ip == iend) {
+      break;
+    }
+
+    if (iend - ip < 2) {
+      return -1;
+    }
+
+    size_t offset = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+    ip += 2;
+    if (!offset || offset > static_cast<size_t>(op - dst)) {
+      return -1;
+    }
+
+    size_t mlen = token & 15;
+    if (15 == mlen && !get_length(ip, iend, mlen)) {
+      return -1;
+    }
+    mlen += MIN_MATCH;
+    if (mlen > static_cast<size_t>(oend - op)) {
+      return -1;
+    }
+
+    const uint8_t* ref = op - offset;
+    if (offset >= mlen) {
+      memcpy(op, ref, mlen);
+      op += mlen;
+    } else {
+      // Overlapped match: repeat the last offset bytes.
+      for (size_t i = 0; i < mlen; ++i) {
+        *op++ = *ref++;
+      }
+    }
+  }
+
+  return op - dst;
+}
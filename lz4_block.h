@@ -0,0 +1,70 @@
+/*
+ *  lz4_block.h - LZ4 block compression.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _LZ4_BLOCK_H_
+#define _LZ4_BLOCK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <sys/types.h>
+
+/*  Lz4Block - compressor and decompressor of the LZ4 block format.
+ *
+ *  The output is compatible with the LZ4 block format, so the blocks
+ *  can be decoded by any LZ4 implementation. Each block is compressed
+ *  independently. The compressor is the single pass greedy one of LZ4,
+ *  which trades some compression ratio for speed.
+ *
+ *  The class doesn't depend on the rest of slogmodem so that it can be
+ *  built into the host tools.
+ */
+class Lz4Block {
+ public:
+  // Max input length of compress()
+  static const size_t MAX_BLOCK_LEN = 1024 * 1024 * 16;
+
+  Lz4Block();
+  Lz4Block(const Lz4Block&) = delete;
+  ~Lz4Block();
+
+  Lz4Block& operator = (const Lz4Block&) = delete;
+
+  /*  compress - compress one block.
+   *  @src: the data to compress.
+   *  @len: length of the data, no more than MAX_BLOCK_LEN.
+   *  @dst: the output buffer.
+   *  @cap: size of the output buffer.
+   *
+   *  Return the compressed length, 0 if the output doesn't fit in cap.
+   */
+  size_t compress(const uint8_t* src, size_t len, uint8_t* dst, size_t cap);
+
+  /*  decompress - decompress one block.
+   *  @src: the compressed block.
+   *  @len: length of the compressed block.
+   *  @dst: the output buffer.
+   *  @cap: size of the output buffer.
+   *
+   *  The input is validated, so corrupted blocks never make the
+   *  function read or write out of the buffers.
+   *
+   *  Return the decompressed length, -1 if the block is invalid or the
+   *  output doesn't fit in cap.
+   */
+  static ssize_t decompress(const uint8_t* src, size_t len, uint8_t* dst,
+                            size_t cap);
+
+ private:
+  static const unsigned HASH_LOG = 14;
+
+  // Positions of the hashed 4-byte sequences in the current block
+  uint32_t* m_table;
+};
+
+#endif  // !_LZ4_BLOCK_H_
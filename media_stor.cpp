@@ -9,7 +9,10 @@
  */
 
 #include <climits>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <ctime>
 #include <dirent.h>
 #include <sys/stat.h>
 #include <sys/statvfs.h>
@@ -27,7 +30,15 @@ MediaStorage::MediaStorage(StorageManager* stor_mgr)
     : m_stor_mgr{stor_mgr},
       m_size{0},
       m_file_watcher{0},
-      m_priority{UINT_MAX} {}
+      m_priority{UINT_MAX},
+      m_trash_size{std::make_shared<std::atomic<uint64_t>>(0)},
+      m_trash_seq{0},
+      m_space_valid{false},
+      m_total_space{0},
+      m_free_space{0},
+      m_written{0},
+      m_sample_time{0, 0},
+      m_ingest_rate{0} {}
 
 MediaStorage::~MediaStorage() { clear_ptr_container(m_log_dirs); }
 
@@ -35,6 +46,12 @@ void MediaStorage::media_init(const LogString& log_path,
                               unsigned priority) {
   m_log_dir = log_path;
   m_priority = priority;
+
+  // The free space model is for the old path.
+  m_space_valid = false;
+  m_written = 0;
+  m_sample_time = {0, 0};
+  m_ingest_rate = 0;
 }
 
 int MediaStorage::sync_media(LogString& log_path, unsigned priority,
@@ -94,6 +111,67 @@ int MediaStorage::sync_media(LogString& log_path, unsigned priority,
 
   closedir(pd);
 
+  reclaim_trash(log_path);
+
+  return 0;
+}
+
+void MediaStorage::reclaim_trash(const LogString& log_path) {
+  LogReclaimer* reclaimer = m_stor_mgr ? m_stor_mgr->reclaimer() : nullptr;
+  if (!reclaimer) {
+    return;
+  }
+
+  LogString trash_dir = log_path + "/" + TRASH_DIR_NAME;
+  DIR* pd = opendir(ls2cstring(trash_dir));
+  if (!pd) {
+    return;
+  }
+
+  while (true) {
+    struct dirent* dent = readdir(pd);
+    if (!dent) {
+      break;
+    }
+    if (!strcmp(dent->d_name, ".") || !strcmp(dent->d_name, "..")) {
+      continue;
+    }
+    // The size of the leftovers is not accounted in m_trash_size.
+    reclaimer->reclaim(trash_dir + "/" + dent->d_name, 0, m_trash_size);
+  }
+
+  closedir(pd);
+}
+
+int MediaStorage::trash(const LogString& path, uint64_t size) {
+  LogReclaimer* reclaimer = m_stor_mgr ? m_stor_mgr->reclaimer() : nullptr;
+  if (!reclaimer || str_empty(m_log_dir)) {
+    return -1;
+  }
+
+  LogString trash_dir = m_log_dir + "/" + TRASH_DIR_NAME;
+  if (mkdir(ls2cstring(trash_dir), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH) &&
+      EEXIST != errno) {
+    err_log("create trash dir %s error", ls2cstring(trash_dir));
+    return -1;
+  }
+
+  char name[32];
+  snprintf(name, sizeof name, "/%lx-%u",
+           static_cast<unsigned long>(time(nullptr)), ++m_trash_seq);
+  LogString trash_path = trash_dir + name;
+
+  if (rename(ls2cstring(path), ls2cstring(trash_path))) {
+    if (ENOENT == errno) {
+      return 0;
+    }
+    err_log("move %s to trash error", ls2cstring(path));
+    return -1;
+  }
+
+  m_trash_size->fetch_add(size);
+  reclaimer->reclaim(trash_path, size, m_trash_size);
+
   return 0;
 }
 
@@ -159,7 +237,10 @@ CpSetDirectory* MediaStorage::create_cp_set(CpClass cp_class) {
   return cp_set;
 }
 
-void MediaStorage::add_size(size_t len) { m_size += len; }
+void MediaStorage::add_size(size_t len) {
+  m_size += len;
+  m_written += len;
+}
 
 void MediaStorage::dec_size(size_t len) { m_size -= len; }
 
@@ -177,20 +258,72 @@ void MediaStorage::stop(CpClass cp_class, CpType ct) {
   }
 }
 
-bool MediaStorage::is_media_full() {
+static long elapsed_ms(const struct timespec& t0,
+                       const struct timespec& t1) {
+  return (t1.tv_sec - t0.tv_sec) * 1000 +
+         (t1.tv_nsec - t0.tv_nsec) / 1000000;
+}
+
+void MediaStorage::sample_space(const struct timespec& now) {
   struct statvfs vstat;
-  bool is_full{};
 
-  if (!statvfs(ls2cstring(m_log_dir), &vstat)) {
-    if (vstat.f_bsize / vstat.f_frsize * vstat.f_bfree
-            <= vstat.f_blocks / 10) {
-      is_full = true;
+  if (statvfs(ls2cstring(m_log_dir), &vstat)) {
+    m_space_valid = false;
+    return;
+  }
+
+  // Ingest rate since the last sample, smoothed over the samples.
+  if (m_sample_time.tv_sec || m_sample_time.tv_nsec) {
+    long ms = elapsed_ms(m_sample_time, now);
+    if (ms > 0) {
+      uint64_t rate = m_written * 1000 / static_cast<uint64_t>(ms);
+      m_ingest_rate = (m_ingest_rate + rate) / 2;
+    }
+  }
+
+  m_total_space = static_cast<uint64_t>(vstat.f_blocks) * vstat.f_frsize;
+  m_free_space = static_cast<uint64_t>(vstat.f_bsize / vstat.f_frsize *
+                                       vstat.f_bfree) * vstat.f_frsize;
+  m_written = 0;
+  m_sample_time = now;
+  m_space_valid = true;
+}
+
+bool MediaStorage::space_left(uint64_t& left) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  bool sampled = false;
+  long ms = elapsed_ms(m_sample_time, now);
+  if (!m_space_valid || m_written >= MEDIA_STAT_BYTES ||
+      ms >= static_cast<long>(MEDIA_STAT_PERIOD)) {
+    sample_space(now);
+    sampled = true;
+  }
+
+  while (m_space_valid) {
+    // The trash being reclaimed is counted as free space.
+    uint64_t free_space = m_free_space > m_written ?
+                          m_free_space - m_written : 0;
+    free_space += m_trash_size->load();
+
+    // 10% of the media is reserved.
+    uint64_t reserved = m_total_space / 10;
+    left = free_space > reserved ? free_space - reserved : 0;
+
+    // Check the estimation before acting on a (nearly) full media.
+    if (sampled || left > m_ingest_rate * MEDIA_FULL_LEAD) {
+      return true;
     }
+    sample_space(now);
+    sampled = true;
   }
 
-  return is_full;
+  return false;
 }
 
+void MediaStorage::invalidate_space() { m_space_valid = false; }
+
 int MediaStorage::check_cp_quota(CpType ct, CpClass cp_class,
                                  uint64_t limit,
                                  uint64_t max_file,
@@ -200,29 +333,36 @@ int MediaStorage::check_cp_quota(CpType ct, CpClass cp_class,
     return 0;
   }
 
-  uint64_t log_size{0};
-  for (auto cp_set : m_log_dirs) {
-    if (cp_set->cp_class() == cp_class) {
-      CpDirectory* cp_dir = cp_set->get_cp_dir(ct);
-      if (!cp_dir) {
-        continue;
-      }
-      log_size += cp_dir->size();
-    }
-  }
+  uint64_t log_size = m_evict_index.size(cp_class, ct);
 
   int ret{};
+  // Size that must be trimmed for the log to go on
+  uint64_t need_size{};
   uint64_t trim_size{};
-  bool is_full = is_media_full();
+  uint64_t left;
+  bool space_known = space_left(left);
+  bool is_full = space_known && !left;
 
   if (overwrite) {
     // Check used capacity of the media
     if (is_full) {
-      trim_size = max_file;
+      need_size = max_file;
       info_log("media full: trim %lu",
+               static_cast<unsigned long>(need_size));
+    }
+    if (limit && log_size > limit && log_size - limit > need_size) {
+      need_size = log_size - limit;
+    }
+    trim_size = need_size;
+    // Trim ahead of ENOSPC when the media will be full within
+    // MEDIA_FULL_LEAD seconds at the current ingest rate. This is
+    // best effort since there is still free space.
+    if (!is_full && space_known &&
+        left <= m_ingest_rate * MEDIA_FULL_LEAD && max_file > trim_size) {
+      trim_size = max_file;
+      info_log("media full in %lu s: trim %lu",
+               static_cast<unsigned long>(left / m_ingest_rate),
                static_cast<unsigned long>(trim_size));
-    } else if (limit && log_size > limit) {
-      trim_size = log_size - limit;
     }
   } else {  // No overwrite
     if (is_full) {
@@ -233,24 +373,16 @@ int MediaStorage::check_cp_quota(CpType ct, CpClass cp_class,
   }
 
   // Need to make room for new log.
-  uint64_t n{0};
+  // The oldest files of all CP set directories are removed first.
   if (trim_size) {
-    for (auto cp_set : m_log_dirs) {
-      if (cp_set->cp_class() == cp_class) {
-        CpDirectory* cp_dir = cp_set->get_cp_dir(ct);
-        if (!cp_dir) {
-          continue;
-        }
-        n += cp_dir->trim(trim_size);
-        if (n >= trim_size) {
-          break;
-        }
-      }
-    }
-
-    if (n < trim_size) {
+    uint64_t trimmed = m_evict_index.trim(cp_class, ct, trim_size);
+    if (trimmed < need_size) {
       ret = -1;
     }
+    if (trimmed && !m_trash_size->load()) {
+      // Synchronously removed, sample the free space again.
+      invalidate_space();
+    }
   }
 
   return ret;
@@ -296,7 +428,10 @@ std::weak_ptr<LogFile> MediaStorage::create_file(CpType ct,
 
 void MediaStorage::clear() {
   for (auto csd : m_log_dirs) {
-    csd->remove();
+    // One rename per CP set directory, the files are removed later.
+    if (trash(csd->path(), csd->size())) {
+      csd->remove();
+    }
   }
   info_log("csd->remove()");
 
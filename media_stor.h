@@ -10,10 +10,13 @@
 #ifndef _MEDIA_STOR_H_
 #define _MEDIA_STOR_H_
 
+#include <atomic>
 #include <climits>
 #include <memory>
+#include <time.h>
 
 #include "cp_log_cmn.h"
+#include "evict_index.h"
 #include "log_file.h"
 
 class StorageManager;
@@ -86,6 +89,8 @@ class MediaStorage {
                                      bool& new_cp_dir, int flags = 0,
                                 const LogString& fname = LogString(""));
 
+  EvictionIndex& evict_index() { return m_evict_index; }
+
   uint64_t size() const { return m_size; }
   void add_size(size_t len);
   void dec_size(size_t len);
@@ -118,10 +123,44 @@ class MediaStorage {
 
   void clear();
 
+  /*  invalidate_space - make the next quota check sample the free space
+   *                     of the media.
+   */
+  void invalidate_space();
+
+  /*  trash - move the file or directory to the trash directory of the
+   *          media, from where it is removed in the background.
+   *  @path: path of the file or directory on the media.
+   *  @size: bytes freed when path is removed.
+   *
+   *  Return 0 on success, -1 on failure. On failure the caller shall
+   *  remove path by itself.
+   */
+  int trash(const LogString& path, uint64_t size);
+
  private:
   LogString class_to_path(CpClass cp_class);
 
-  bool is_media_full();
+  /*  sample_space - sample the free space of the media by statvfs().
+   *  @now: current CLOCK_MONOTONIC time.
+   */
+  void sample_space(const struct timespec& now);
+  /*  space_left - estimate the bytes that can be written before the
+   *               media is full.
+   *  @left: the estimated bytes.
+   *
+   *  The free space is sampled every MEDIA_STAT_PERIOD ms or after
+   *  MEDIA_STAT_BYTES are written, and estimated from the bytes written
+   *  since the last sample in between.
+   *
+   *  Return true on success, false if the free space is unknown.
+   */
+  bool space_left(uint64_t& left);
+
+  /*  reclaim_trash - queue the leftovers in the trash directory.
+   *  @log_path: log path of the storage.
+   */
+  void reclaim_trash(const LogString& log_path);
 
  private:
   StorageManager* m_stor_mgr;
@@ -133,6 +172,23 @@ class MediaStorage {
   FileWatcher* m_file_watcher;
   // priority of media path
   unsigned m_priority;
+  // Log files of all CpDirectory objects on the media
+  EvictionIndex m_evict_index;
+  // Bytes in the trash directory that are not removed yet
+  std::shared_ptr<std::atomic<uint64_t>> m_trash_size;
+  // Sequence number of the trash entries
+  unsigned m_trash_seq;
+  // Free space model of the media
+  bool m_space_valid;
+  // Total and free bytes of the last statvfs() sample
+  uint64_t m_total_space;
+  uint64_t m_free_space;
+  // Bytes written since the last sample
+  uint64_t m_written;
+  // CLOCK_MONOTONIC time of the last sample
+  struct timespec m_sample_time;
+  // Smoothed log ingest rate in bytes per second
+  uint64_t m_ingest_rate;
 };
 
 #endif  // !_MEDIA_STOR_H_
@@ -151,7 +151,7 @@ class ModemAtController : public DeviceFileHandler {
   IntResultCallback_t int_result_cb_;
   void* event_client_;
   EventCallback_t event_cb_;
-  TimerManager::Timer* cmd_timer_;
+  TimerManager::TimerHandle cmd_timer_;
 };
 
 #endif  // !MODEM_AT_CTRL_H_
@@ -35,7 +35,8 @@ ModemParseLibrarySave::ModemParseLibrarySave(TransactionManager* mgr,
                                              WanModemLogHandler* wan,
                                              CpDirectory* dir)
     : TransLogConvey{mgr, TransModem::MODEM_PARSE_LIB_SAVE,
-                     wan->controller()->convey_workshop()},
+                     wan->controller()->convey_workshop(),
+                     ConveyUnitBase::LivePath},
       wan_modem_{wan},
       modem_fd_{-1},
       new_sha1_{0},
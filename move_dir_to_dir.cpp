@@ -8,11 +8,79 @@
  * Initial version
  *
  */
+#include <cerrno>
+#include <cstdio>
+
 #include "cp_dir.h"
 #include "log_file.h"
 #include "move_dir_to_dir.h"
 
+MoveDirToDirUnit::~MoveDirToDirUnit() {
+  restore_moved_files();
+}
+
+bool MoveDirToDirUnit::convey_by_rename(const LogString& src_file_path,
+                                        std::unique_ptr<LogFile>& lf) {
+  LogString dest_file_path = lf->dir()->path() + "/" + lf->base_name();
+
+  if (rename(ls2cstring(src_file_path), ls2cstring(dest_file_path))) {
+    if (EXDEV != errno) {
+      err_log("fail to rename %s, errno %d",
+              ls2cstring(src_file_path), errno);
+    }
+    return false;
+  }
+
+  info_log("move %s to %s is finished",
+           ls2cstring(src_file_path), ls2cstring(lf->dir()->path()));
+  moved_dest_files_.push(std::move(lf));
+
+  return true;
+}
+
+void MoveDirToDirUnit::restore_moved_files() {
+  while (1) {
+    auto lf = moved_dest_files_.get_next(false);
+
+    if (nullptr == lf) {
+      break;
+    }
+
+    // The source file is still in the source directory's list.
+    LogString dest_file_path = lf->dir()->path() + "/" + lf->base_name();
+    LogString src_file_path = src_->path() + "/" + lf->base_name();
+
+    if (rename(ls2cstring(dest_file_path), ls2cstring(src_file_path))) {
+      err_log("fail to move %s back, errno %d",
+              ls2cstring(dest_file_path), errno);
+    }
+  }
+}
+
+void MoveDirToDirUnit::clear_result() {
+  restore_moved_files();
+  CopyDirToDirUnit::clear_result();
+}
+
 void MoveDirToDirUnit::post_convey() {
+  // The moved files are transferred from the source directory to the
+  // destination directory with their sizes.
+  while (1) {
+    auto lf = moved_dest_files_.get_next(false);
+
+    if (nullptr == lf) {
+      break;
+    }
+
+    if (0 == lf->get_size()) {
+      const_cast<CpDirectory*>(src_)->remove(lf->base_name());
+      lf->get_type();
+      lf->dir()->add_log_file(lf.release());
+    } else {
+      err_log("moved file %s vanished", ls2cstring(lf->base_name()));
+    }
+  }
+
   while (1) {
     auto lf = copied_dest_files_.get_next(false);
 
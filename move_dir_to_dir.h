@@ -30,8 +30,30 @@ class MoveDirToDirUnit : public CopyDirToDirUnit {
                    unsigned dest_priority = UINT_MAX)
       : CopyDirToDirUnit(sm, type, cpclass, src, src_priority,
                          dest, dest_priority) {}
+  ~MoveDirToDirUnit();
 
   void post_convey() override;
+  void clear_result() override;
+
+ protected:
+  /*
+   * convey_by_rename - rename the source file to the destination
+   *
+   * The rename fails with EXDEV when the source and the destination
+   * are on different file systems, then the file is copied.
+   */
+  bool convey_by_rename(const LogString& src_file_path,
+                        std::unique_ptr<LogFile>& lf) override;
+
+ private:
+  /*
+   * restore_moved_files - rename the moved files back to the source
+   */
+  void restore_moved_files();
+
+ private:
+  // Destination files renamed from the source files
+  ConcurrentQueue<LogFile> moved_dest_files_;
 };
 
 #endif
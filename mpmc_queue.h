@@ -0,0 +1,131 @@
+/*
+ * mpmc_queue.h - bounded lock-free multi-producer multi-consumer queue
+ *
+ * Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ * History:
+ * 2026-10-17
+ * Initial version
+ *
+ */
+
+#ifndef _MPMC_QUEUE_
+#define _MPMC_QUEUE_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * MpmcQueue - bounded lock-free queue of small values
+ *
+ * The queue is a ring of kCapacity cells. Each cell carries a
+ * sequence number telling whether it is ready for the next push or
+ * the next pop, so producers and consumers only contend on the
+ * position counters and nothing is allocated after construction.
+ *
+ * T shall be trivially copyable. kCapacity shall be a power of 2.
+ */
+template<typename T, size_t kCapacity>
+class MpmcQueue {
+  static_assert(kCapacity >= 2 && !(kCapacity & (kCapacity - 1)),
+                "MpmcQueue capacity shall be a power of 2");
+
+ public:
+  MpmcQueue() : enqueue_pos_{0}, dequeue_pos_{0} {
+    for (size_t i = 0; i < kCapacity; ++i) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+  /*
+   * push - add a new item to the tail
+   *
+   * @t: new item
+   *
+   * Return:
+   *  true if the item is added, false if the queue is full.
+   */
+  bool push(const T& t) {
+    Cell* cell;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+
+    while (true) {
+      cell = &cells_[pos & (kCapacity - 1)];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+      if (!dif) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {  // Full
+        return false;
+      } else {  // Another producer took the cell
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    cell->data = t;
+    cell->seq.store(pos + 1, std::memory_order_release);
+
+    return true;
+  }
+  /*
+   * pop - get the head item
+   *
+   * @t: the head item
+   *
+   * Return:
+   *  true if an item is got, false if the queue is empty.
+   */
+  bool pop(T& t) {
+    Cell* cell;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+
+    while (true) {
+      cell = &cells_[pos & (kCapacity - 1)];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t dif = static_cast<intptr_t>(seq) -
+                     static_cast<intptr_t>(pos + 1);
+
+      if (!dif) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {  // Empty
+        return false;
+      } else {  // Another consumer took the cell
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    t = cell->data;
+    cell->seq.store(pos + kCapacity, std::memory_order_release);
+
+    return true;
+  }
+
+ private:
+  static const size_t kCacheLine = 64;
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    T data;
+  };
+
+  Cell cells_[kCapacity];
+  // The producer and the consumer positions are kept in different
+  // cache lines.
+  char pad0_[kCacheLine];
+  std::atomic<size_t> enqueue_pos_;
+  char pad1_[kCacheLine - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> dequeue_pos_;
+  char pad2_[kCacheLine - sizeof(std::atomic<size_t>)];
+};
+
+#endif // !_MPMC_QUEUE_
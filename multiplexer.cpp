@@ -7,6 +7,7 @@
  *  2015-2-16 Zhang Ziyi
  *  Initial version.
  */
+#include <sys/timerfd.h>
 #include <unistd.h>
 
 #include "cp_log_cmn.h"
@@ -14,79 +15,168 @@
 
 Multiplexer::Multiplexer()
     : m_run{true},
-      m_dirty{true},
-      m_poll_arr_size{0},
+      m_epoll_fd{-1},
       m_current_num{0},
-      m_current_fds{0},
-      m_current_handlers{0} {}
+      m_timer_fd{-1},
+      m_timer_armed{false},
+      m_timer_due{0, 0} {
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (-1 == m_epoll_fd) {
+    err_log("epoll_create1 error");
+  }
+
+  m_timer_fd = timerfd_create(CLOCK_BOOTTIME, TFD_NONBLOCK | TFD_CLOEXEC);
+  if (-1 == m_timer_fd) {
+    // Fall back to the timeout of epoll_wait
+    err_log("timerfd_create error");
+  } else if (m_epoll_fd >= 0) {
+    struct epoll_event ev;
+
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_timer_fd, &ev)) {
+      err_log("add timerfd error");
+      ::close(m_timer_fd);
+      m_timer_fd = -1;
+    }
+  }
+}
 
 Multiplexer::~Multiplexer() {
-  delete [] m_current_fds;
-  delete [] m_current_handlers;
+  if (m_timer_fd >= 0) {
+    ::close(m_timer_fd);
+  }
+  if (m_epoll_fd >= 0) {
+    ::close(m_epoll_fd);
+  }
 }
 
-size_t Multiplexer::find_handler(FdHandler* handler) {
-  size_t i;
+int Multiplexer::update_epoll(FdHandler* handler, PollingEntry& e) {
+  // Like poll, a handler without events or fd is not watched at all.
+  int fd = e.events ? handler->fd() : -1;
+  int err = 0;
 
-  for (i = 0; i < m_polling_hdl.size(); ++i) {
-    if (m_polling_hdl[i].handler == handler) {
-      break;
+  if (e.fd >= 0 && e.fd != fd) {
+    remove_fd(handler, e);
+  }
+
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct epoll_event ev;
+
+  // The POLL* event bits have the same values as EPOLL* bits.
+  ev.events = static_cast<uint32_t>(e.events);
+  ev.data.ptr = handler;
+  if (e.fd == fd) {
+    err = epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    if (err && ENOENT == errno) {
+      // The old fd was closed and the number is reused.
+      err = epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
     }
+  } else {
+    FdMap::iterator it = m_fd_owner.find(fd);
+
+    if (it != m_fd_owner.end()) {
+      FdHandler* other = it->second;
+
+      if (other->fd() == fd) {
+        err_log("fd %d is watched for another handler", fd);
+        return -1;
+      }
+      // The other handler has closed the fd without detaching it.
+      m_polling_hdl[other].fd = -1;
+      m_fd_owner.erase(it);
+    }
+
+    err = epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    if (err && EEXIST == errno) {
+      // Left by the other handler through a duplicate of the fd
+      err = epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    }
+  }
+
+  if (err) {
+    err_log("epoll_ctl fd %d error %d", fd, errno);
+    if (e.fd >= 0) {
+      m_fd_owner.erase(e.fd);
+      e.fd = -1;
+    }
+    return -1;
   }
 
-  return i;
+  e.fd = fd;
+  m_fd_owner[fd] = handler;
+  return 0;
 }
 
-int Multiplexer::register_fd(FdHandler* handler, int events) {
-  // First find the entry
-  size_t i = find_handler(handler);
-  int ret = -1;
+void Multiplexer::remove_fd(FdHandler* handler, PollingEntry& e) {
+  FdMap::iterator it = m_fd_owner.find(e.fd);
 
-  if (i == m_polling_hdl.size()) {
-    PollingEntry e;
+  if (it != m_fd_owner.end() && it->second == handler) {
+    // The fd may have been closed, which removes it from the epoll set.
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, e.fd, nullptr);
+    m_fd_owner.erase(it);
+  }
+  e.fd = -1;
+}
 
-    e.handler = handler;
-    e.events = events;
-    m_polling_hdl.push_back(e);
-    m_dirty = true;
-    ret = 0;
+int Multiplexer::register_fd(FdHandler* handler, int events) {
+  if (m_polling_hdl.count(handler)) {
+    return -1;
   }
 
-  return ret;
+  PollingEntry& e = m_polling_hdl[handler];
+
+  e.fd = -1;
+  e.events = events;
+  update_epoll(handler, e);
+
+  return 0;
 }
 
 void Multiplexer::unregister_fd(FdHandler* handler) {
-  // First find the entry
-  size_t i = find_handler(handler);
+  HandlerMap::iterator it = m_polling_hdl.find(handler);
+
+  if (it != m_polling_hdl.end()) {
+    remove_cur_handler(handler);
+    if (it->second.fd >= 0) {
+      remove_fd(handler, it->second);
+    }
+    m_polling_hdl.erase(it);
+  }
+}
+
+void Multiplexer::detach_fd(FdHandler* handler) {
+  HandlerMap::iterator it = m_polling_hdl.find(handler);
 
-  if (i < m_polling_hdl.size()) {
+  if (it != m_polling_hdl.end() && it->second.fd >= 0) {
     remove_cur_handler(handler);
-    remove_at< LogVector<PollingEntry> >(m_polling_hdl, i);
-    m_dirty = true;
+    remove_fd(handler, it->second);
   }
 }
 
 void Multiplexer::remove_cur_handler(FdHandler* handler) {
   // Don't change m_current_num, just reset the entry
-  for (unsigned i = 0; i < m_current_num; ++i) {
-    if (m_current_handlers[i] == handler) {
-      m_current_handlers[i] = nullptr;
-      m_current_fds[i].revents = 0;
+  for (int i = 0; i < m_current_num; ++i) {
+    if (m_current_events[i].data.ptr == handler) {
+      m_current_events[i].data.ptr = nullptr;
+      m_current_events[i].events = 0;
       break;
     }
   }
 }
 
 int Multiplexer::add_events(FdHandler* handler, int events) {
-  // First find the entry
-  size_t i = find_handler(handler);
+  HandlerMap::iterator it = m_polling_hdl.find(handler);
   int ret = -1;
 
-  if (i < m_polling_hdl.size()) {
-    PollingEntry& e = item(m_polling_hdl, i);
-    if ((e.events & events) != events) {
+  if (it != m_polling_hdl.end()) {
+    PollingEntry& e = it->second;
+    if ((e.events & events) != events || e.fd != handler->fd()) {
       e.events |= events;
-      m_dirty = true;
+      update_epoll(handler, e);
     }
     ret = 0;
   }
@@ -95,16 +185,15 @@ int Multiplexer::add_events(FdHandler* handler, int events) {
 }
 
 int Multiplexer::del_events(FdHandler* handler, int events) {
-  // First find the entry
-  size_t i = find_handler(handler);
+  HandlerMap::iterator it = m_polling_hdl.find(handler);
   int ret = -1;
 
-  if (i < m_polling_hdl.size()) {
-    PollingEntry& e = item(m_polling_hdl, i);
+  if (it != m_polling_hdl.end()) {
+    PollingEntry& e = it->second;
     if (e.events & events) {
       clear_cur_events(handler, events);
       e.events &= ~events;
-      m_dirty = true;
+      update_epoll(handler, e);
     }
     ret = 0;
   }
@@ -113,79 +202,101 @@ int Multiplexer::del_events(FdHandler* handler, int events) {
 }
 
 void Multiplexer::clear_cur_events(FdHandler* handler, int events) {
-  for (unsigned i = 0; i < m_current_num; ++i) {
-    if (m_current_handlers[i] == handler) {
-      m_current_fds[i].revents &= ~events;
+  for (int i = 0; i < m_current_num; ++i) {
+    if (m_current_events[i].data.ptr == handler) {
+      m_current_events[i].events &= ~static_cast<uint32_t>(events);
       break;
     }
   }
 }
 
-void Multiplexer::prepare_polling_array() {
-  if (m_polling_hdl.size() > m_poll_arr_size) {
-    size_t step_times = (m_polling_hdl.size() + POLL_ARRAY_INC_STEP - 1)
-                          / POLL_ARRAY_INC_STEP;
-    size_t new_size = step_times * POLL_ARRAY_INC_STEP;
-    pollfd* new_poll = new pollfd[new_size];
+int Multiplexer::arm_timer() {
+  int to;
 
-    delete [] m_current_fds;
-    m_current_fds = new_poll;
+  if (m_timer_fd < 0) {
+    if (m_timer_mgr.next_time(to) < 0) {
+      to = -1;
+    }
+    return to;
+  }
 
-    FdHandler** new_hdl = new FdHandler*[new_size];
-    delete [] m_current_handlers;
-    m_current_handlers = new_hdl;
+  struct timespec due;
 
-    m_poll_arr_size = new_size;
-  }
+  if (m_timer_mgr.next_due_time(due)) {  // No timer
+    if (m_timer_armed) {
+      struct itimerspec its = {{0, 0}, {0, 0}};
 
-  nfds_t i;
-  size_t j = 0;
+      timerfd_settime(m_timer_fd, 0, &its, nullptr);
+      m_timer_armed = false;
+    }
+    return -1;
+  }
 
-  for (i = 0; i < m_polling_hdl.size(); ++i) {
-    int events = m_polling_hdl[i].events;
+  if (!m_timer_armed || due < m_timer_due || m_timer_due < due) {
+    struct itimerspec its;
 
-    if (events) {
-      m_current_fds[j].fd = m_polling_hdl[i].handler->fd();
-      m_current_fds[j].events = events;
-      m_current_fds[j].revents = 0;
-      m_current_handlers[j] = m_polling_hdl[i].handler;
-      ++j;
+    its.it_interval.tv_sec = 0;
+    its.it_interval.tv_nsec = 0;
+    its.it_value = due;
+    // A zero it_value disarms the timer.
+    if (!its.it_value.tv_sec && !its.it_value.tv_nsec) {
+      its.it_value.tv_nsec = 1;
     }
+    if (timerfd_settime(m_timer_fd, TFD_TIMER_ABSTIME, &its, nullptr)) {
+      err_log("timerfd_settime error");
+      if (m_timer_mgr.next_time(to) < 0) {
+        to = -1;
+      }
+      m_timer_armed = false;
+      return to;
+    }
+    m_timer_armed = true;
+    m_timer_due = due;
   }
 
-  m_current_num = j;
+  return -1;
 }
 
-int Multiplexer::run() {
-  while (m_run) {
-    if (m_dirty) {
-      // Fill m_current_fds, m_current_handlers according to
-      // m_polling_hdl
-      prepare_polling_array();
+void Multiplexer::process_timer_fd() {
+  uint64_t expirations;
 
-      m_dirty = false;
-    }
+  if (read(m_timer_fd, &expirations, sizeof expirations) > 0) {
+    m_timer_armed = false;
+  }
+}
 
-    int to;
+int Multiplexer::run() {
+  if (-1 == m_epoll_fd) {
+    return -1;
+  }
 
-    if (m_timer_mgr.next_time(to) < 0) {
-      to = -1;
-    }
+  while (m_run) {
+    int to = arm_timer();
+    int err = epoll_wait(m_epoll_fd, m_current_events, MAX_EVENTS, to);
 
-    int err = poll(m_current_fds, m_current_num, to);
+    m_current_num = err > 0 ? err : 0;
     m_timer_mgr.run();
     // Here process the events
-    if (err > 0) {
-      for (unsigned i = 0; i < m_current_num; ++i) {
-        short revents = m_current_fds[i].revents;
-        if (revents) {
-          m_current_handlers[i]->process(revents);
-          if (!m_run) {
-            break;
-          }
+    for (int i = 0; i < m_current_num; ++i) {
+      FdHandler* handler =
+          static_cast<FdHandler*>(m_current_events[i].data.ptr);
+      int revents = static_cast<int>(m_current_events[i].events);
+
+      if (!handler) {
+        // timerfd event or handler removed during dispatch
+        if (revents && m_timer_fd >= 0) {
+          process_timer_fd();
+        }
+        continue;
+      }
+      if (revents) {
+        handler->process(revents);
+        if (!m_run) {
+          break;
         }
       }
     }
+    m_current_num = 0;
   }
 
   return 0;
@@ -11,10 +11,24 @@
 #define _MULTIPLEXER_H_
 
 #include <poll.h>
+#include <sys/epoll.h>
+#include <unordered_map>
+
 #include "cp_log_cmn.h"
 #include "fd_hdl.h"
 #include "timer_mgr.h"
 
+/*  Multiplexer - the event loop of the daemon.
+ *
+ *  The file descriptors are watched by epoll, and the registered
+ *  handlers are kept in a hash map, so registering and changing the
+ *  events of a handler cost O(1) and don't rebuild the whole polling
+ *  set. The timers of the TimerManager are woken up by a timerfd.
+ *
+ *  Each fd in the epoll set is recorded with its handler, so a handler
+ *  whose fd number has been closed and reused by another handler never
+ *  removes or changes the other handler's registration.
+ */
 class Multiplexer {
  public:
   Multiplexer();
@@ -29,6 +43,14 @@ class Multiplexer {
    */
   int register_fd(FdHandler* handler, int events);
   void unregister_fd(FdHandler* handler);
+  /*  detach_fd - remove the fd of the handler from the epoll set.
+   *  @handler: the FdHandler object pointer
+   *
+   *  Called before the handler closes its fd. The handler stays
+   *  registered, and its events are applied to its next fd by
+   *  add_events().
+   */
+  void detach_fd(FdHandler* handler);
 
   /*  add_events - add events for a registered handler.
    *  @handler: the FdHandler object pointer
@@ -52,30 +74,52 @@ class Multiplexer {
   void shall_quit() { m_run = false; }
 
  private:
-  static const unsigned POLL_ARRAY_INC_STEP = 32;
+  // Max number of events got by one epoll_wait
+  static const int MAX_EVENTS = 32;
 
   struct PollingEntry {
-    FdHandler* handler;
+    // The file descriptor in the epoll set, -1 if not added
+    int fd;
     int events;
   };
 
+  typedef std::unordered_map<FdHandler*, PollingEntry> HandlerMap;
+  typedef std::unordered_map<int, FdHandler*> FdMap;
+
   bool m_run;
-  LogVector<PollingEntry> m_polling_hdl;
-  bool m_dirty;
-  size_t m_poll_arr_size;
-  nfds_t m_current_num;
-  pollfd* m_current_fds;
-  FdHandler** m_current_handlers;
+  int m_epoll_fd;
+  HandlerMap m_polling_hdl;
+  // Handler of each fd in the epoll set
+  FdMap m_fd_owner;
+  // Events being dispatched
+  int m_current_num;
+  struct epoll_event m_current_events[MAX_EVENTS];
 
   // Timer manager
   TimerManager m_timer_mgr;
+  // timerfd to wake up on the next due time, -1 if not available
+  int m_timer_fd;
+  // Due time m_timer_fd is armed with
+  bool m_timer_armed;
+  struct timespec m_timer_due;
 
-  // Find handler
-  size_t find_handler(FdHandler* handler);
-  void prepare_polling_array();
-  void call_check_callback();
+  /*  update_epoll - apply the events of the entry to the epoll set.
+   *
+   *  Return 0 on success, -1 on error.
+   */
+  int update_epoll(FdHandler* handler, PollingEntry& e);
+  /*  remove_fd - remove e.fd from the epoll set if it is still the
+   *              handler's.
+   */
+  void remove_fd(FdHandler* handler, PollingEntry& e);
   void remove_cur_handler(FdHandler* handler);
   void clear_cur_events(FdHandler* handler, int events);
+  /*  arm_timer - arm m_timer_fd with the next due time.
+   *
+   *  Return the timeout for epoll_wait.
+   */
+  int arm_timer();
+  void process_timer_fd();
 };
 
 #endif  // !_MULTIPLEXER_H_
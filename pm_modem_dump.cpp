@@ -76,17 +76,17 @@ void TransPmModemDump::recv_result(void* client, Transaction* trans) {
   TransPmModemDump* dump = static_cast<TransPmModemDump*>(client);
   int result{trans->result()};
 
+  delete trans;
+  dump->dump_rcv_ = nullptr;
+
   if (TRANS_R_SUCCESS != result) {
-    if (dump->save_mem_file()) {
-      result = TRANS_R_SUCCESS;
-    } else {
-      result = TRANS_R_FAILURE;
+    // Finished by on_dump_contents_copied().
+    if (!dump->save_mem_file()) {
+      return;
     }
+    result = TRANS_R_FAILURE;
   }
 
-  delete trans;
-  dump->dump_rcv_ = nullptr;
-
   dump->finish(result);
 }
 
@@ -98,19 +98,26 @@ void TransPmModemDump::ongoing_report(void* client) {
   }
 }
 
-bool TransPmModemDump::save_mem_file() {
-  bool ret{};
-
-  ret = copy_dump_content("memory", dump_path_);
+int TransPmModemDump::save_mem_file() {
+  DumpRegion regions[3];
+  size_t num = 0;
 
+  regions[num++] = DumpRegion{"memory", dump_path_, false};
   if (!access(AON_IRAM_FILE, F_OK)) {
-    copy_dump_content("aon-iram", AON_IRAM_FILE);
+    regions[num++] = DumpRegion{"aon-iram", AON_IRAM_FILE, false};
   }
   if (!access(PUBCP_IRAM_FILE, F_OK)) {
-    copy_dump_content("pubcp-iram", PUBCP_IRAM_FILE);
+    regions[num++] = DumpRegion{"pubcp-iram", PUBCP_IRAM_FILE, false};
   }
 
-  return ret;
+  // The regions are copied in parallel to shorten the time before
+  // the MODEM can be reset.
+  return start_copy_dump_contents(regions, num);
+}
+
+void TransPmModemDump::on_dump_contents_copied(const DumpRegion* regions,
+                                               size_t /*num*/) {
+  finish(regions[0].saved ? TRANS_R_SUCCESS : TRANS_R_FAILURE);
 }
 
 void TransPmModemDump::cancel() {
@@ -119,6 +126,10 @@ void TransPmModemDump::cancel() {
     delete dump_rcv_;
     dump_rcv_ = nullptr;
 
+    on_canceled();
+  } else if (copying_dump_contents()) {
+    wait_dump_contents();
+
     on_canceled();
   }
 }
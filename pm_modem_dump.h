@@ -46,8 +46,17 @@ class TransPmModemDump : public TransCpDump {
     ongoing_cb_ = cb;
   }
 
+ protected:
+  // TransCpDump::on_dump_contents_copied()
+  void on_dump_contents_copied(const DumpRegion* regions,
+                               size_t num) override;
+
 private:
-  bool save_mem_file();
+  /*  save_mem_file - start saving the memory regions.
+   *
+   *  Return 0 if started, -1 otherwise.
+   */
+  int save_mem_file();
   static void recv_result(void* client, Transaction* trans);
   static void ongoing_report(void* client);
 
@@ -102,7 +102,7 @@ class PmSensorhubLogHandler : public LogPipeHandler {
   // Control file (PM_LOG_CTRL) descriptor
   int ctrl_file_;
   // Timer for reenabling log output
-  TimerManager::Timer* reopen_timer_;
+  TimerManager::TimerHandle reopen_timer_;
 };
 
 #endif  // !PM_SENSORHUB_LOG_H_
@@ -14,11 +14,15 @@ LOCAL_CPPFLAGS += -fexceptions
 
 LOCAL_CFLAGS += -DINIT_CONF_DIR=\"/vendor/etc/\"
 
-LOCAL_SRC_FILES := client_hdl.cpp \
+LOCAL_SRC_FILES := async_file_wr.cpp \
+                   buf_pool.cpp \
+                   client_hdl.cpp \
                    client_hdl_miniap.cpp \
                    client_hdl_mipilog.cpp \
                    client_mgr.cpp \
                    client_req.cpp \
+                   commit_tuner.cpp \
+                   convey_throttle.cpp \
                    convey_unit.cpp \
                    convey_unit_base.cpp \
                    convey_workshop.cpp \
@@ -38,12 +42,15 @@ LOCAL_SRC_FILES := client_hdl.cpp \
                    dev_file_open.cpp \
                    diag_dev_hdl.cpp \
                    diag_stream_parser.cpp \
+                   evict_index.cpp \
                    evt_notifier.cpp \
                    ext_gnss_log.cpp \
                    ext_wcn_dump.cpp \
                    fd_hdl.cpp \
                    file_watcher.cpp \
+                   ingest_reactor.cpp \
                    io_chan.cpp \
+                   io_ring.cpp \
                    io_sched.cpp \
                    log_config.cpp \
                    log_config_with_modemtype.cpp \
@@ -51,8 +58,12 @@ LOCAL_SRC_FILES := client_hdl.cpp \
                    log_ctrl_miniap.cpp \
                    log_ctrl_mipilog.cpp \
                    log_file.cpp \
+                   log_frame.cpp \
+                   log_index.cpp \
                    log_pipe_dev.cpp \
                    log_pipe_hdl.cpp \
+                   log_reclaimer.cpp \
+                   lz4_block.cpp \
                    major_minor_num_a6.cpp \
                    media_stor.cpp \
                    media_stor_check.cpp \
@@ -146,6 +157,10 @@ ifeq ($(strip $(BOARD_SECURE_BOOT_ENABLE)), true)
     LOCAL_CFLAGS += -DSECURE_BOOT_ENABLE
 endif
 
+ifeq ($(strip $(SPRD_CP_LOG_IO_URING)), true)
+    LOCAL_CFLAGS += -DSUPPORT_IO_URING
+endif
+
 ifeq ($(strip $(USE_SPRD_ORCA_MODEM)), true)
     LOCAL_CFLAGS += -DUSE_ORCA_MODEM
     LOCAL_SRC_FILES += modem_utils.cpp \
@@ -0,0 +1,100 @@
+/*
+ * spsc_queue.h - bounded lock-free single-producer single-consumer queue
+ *
+ * Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ * History:
+ * 2026-10-17
+ * Initial version
+ *
+ */
+
+#ifndef _SPSC_QUEUE_
+#define _SPSC_QUEUE_
+
+#include <atomic>
+#include <cstddef>
+
+/*
+ * SpscQueue - bounded lock-free queue between two threads
+ *
+ * Only one thread may push and only one thread may pop. The producer
+ * publishes an item by advancing the tail with release semantics, so
+ * everything written before push() is visible to the consumer after
+ * pop().
+ *
+ * T shall be trivially copyable. kCapacity shall be a power of 2.
+ */
+template<typename T, size_t kCapacity>
+class SpscQueue {
+  static_assert(kCapacity >= 2 && !(kCapacity & (kCapacity - 1)),
+                "SpscQueue capacity shall be a power of 2");
+
+ public:
+  SpscQueue() : head_{0}, tail_{0} {}
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+  /*
+   * push - add a new item to the tail (producer only)
+   *
+   * @t: new item
+   *
+   * Return:
+   *  true if the item is added, false if the queue is full.
+   */
+  bool push(const T& t) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+      return false;
+    }
+    items_[tail & (kCapacity - 1)] = t;
+    tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+  /*
+   * pop - get the head item (consumer only)
+   *
+   * @t: the head item
+   *
+   * Return:
+   *  true if an item is got, false if the queue is empty.
+   */
+  bool pop(T& t) {
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    t = items_[head & (kCapacity - 1)];
+    head_.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+  /*
+   * size - number of items in the queue
+   *
+   * The result is exact only for the producer or the consumer when
+   * the other side is idle, otherwise it's a snapshot.
+   */
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static const size_t kCacheLine = 64;
+
+  T items_[kCapacity];
+  // The producer and the consumer positions are kept in different
+  // cache lines.
+  char pad0_[kCacheLine];
+  std::atomic<size_t> head_;
+  char pad1_[kCacheLine - sizeof(std::atomic<size_t>)];
+  std::atomic<size_t> tail_;
+  char pad2_[kCacheLine - sizeof(std::atomic<size_t>)];
+};
+
+#endif // !_SPSC_QUEUE_
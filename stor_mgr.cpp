@@ -21,7 +21,9 @@
 #include "cp_log_cmn.h"
 #include "cp_set_dir.h"
 #include "cp_stor.h"
+#include "def_config.h"
 #include "file_watcher.h"
+#include "io_chan.h"
 #include "log_pipe_hdl.h"
 #include "parse_utils.h"
 #include "stor_mgr.h"
@@ -33,16 +35,30 @@ StorageManager::StorageManager()
       m_media_storage{this, this},
       m_file_watcher{},
       m_use_ext_stor_fuse{true},
-      m_uevent_monitor{} {}
+      m_uevent_monitor{},
+      m_log_ctrl{},
+      m_multiplexer{},
+      m_io_chans{},
+      m_reclaimer_running{},
+      m_buf_pool{LOG_BUF_POOL_SHARED} {}
 
 StorageManager::~StorageManager() {
-  // delete m_file_watcher;
+  // Cancel the file watches of the CpDirectory objects before the
+  // FileWatcher is deleted.
+  for (int mt = MT_INT_STOR; mt < MT_STOR_END; ++mt) {
+    m_media_storage[mt].stop();
+  }
+  delete m_file_watcher;
   clear_ptr_container(m_event_clients);
   clear_ptr_container(m_umt_event_clients);
   clear_ptr_container(m_stor_check);
   // m_stor_check may depend on m_uevent_monitor, so destroy
   // m_uevent_monitor later.
   delete m_uevent_monitor;
+
+  for (int mt = MT_INT_STOR; mt < MT_STOR_END; ++mt) {
+    delete m_io_chans[mt];
+  }
 }
 
 int StorageManager::init(const LogString& internal_stor_pos,
@@ -51,6 +67,9 @@ int StorageManager::init(const LogString& internal_stor_pos,
                          bool ext_stor_active,
                          LogController* ctrl,
                          Multiplexer* multiplexer) {
+  m_log_ctrl = ctrl;
+  m_multiplexer = multiplexer;
+
   // initialisation of the uevnt monitor
   m_uevent_monitor = new UeventMonitor(ctrl, multiplexer);
   if (m_uevent_monitor->init()) {
@@ -59,6 +78,20 @@ int StorageManager::init(const LogString& internal_stor_pos,
     err_log("UeventMonitor init failed");
   }
 
+  // The current log files are watched for deletion
+  m_file_watcher = new FileWatcher(ctrl, multiplexer);
+  if (m_file_watcher->init() < 0) {
+    delete m_file_watcher;
+    m_file_watcher = nullptr;
+    err_log("FileWatcher init failed");
+  }
+
+  if (m_reclaimer.start()) {
+    err_log("LogReclaimer start failed, logs are removed synchronously");
+  } else {
+    m_reclaimer_running = true;
+  }
+
   m_stor_check.push_back(new MediaStorCheck{this,
                                             &m_media_storage[MT_INT_STOR],
                                             MT_INT_STOR,
@@ -111,6 +144,7 @@ CpStorage* StorageManager::create_storage(LogPipeHandler& cp_log,
 
   cp_stor->set_log_buffer_size(max_buf, max_num);
   cp_stor->set_log_commit_threshold(cmt_size);
+  cp_stor->set_buffer_pool(&m_buf_pool);
   if (!cp_stor->init()) {
     m_cp_handles.push_back(cp_stor);
   } else {
@@ -133,6 +167,27 @@ void StorageManager::delete_storage(CpStorage* stor) {
   }
 }
 
+IoChannel* StorageManager::io_channel(MediaType mt) {
+  if (mt >= MT_STOR_END) {
+    return nullptr;
+  }
+
+  if (!m_io_chans[mt]) {
+    unsigned num = MT_EXT_STOR == mt ? EXT_STOR_WRITER_NUM
+                                     : INT_STOR_WRITER_NUM;
+    IoChannel* chan = new IoChannel{m_log_ctrl, m_multiplexer, num};
+
+    if (chan->init()) {
+      err_log("init I/O channel for media %d failed", static_cast<int>(mt));
+      delete chan;
+    } else {
+      m_io_chans[mt] = chan;
+    }
+  }
+
+  return m_io_chans[mt];
+}
+
 void StorageManager::proc_working_dir_removed(MediaStorage* ms) {
   if (m_current_storage->ms() == ms) {
     stop_all_cps();
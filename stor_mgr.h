@@ -10,11 +10,14 @@
 #ifndef _STOR_MGR_H_
 #define _STOR_MGR_H_
 
+#include "buf_pool.h"
+#include "log_reclaimer.h"
 #include "uevent_monitor.h"
 #include "media_stor.h"
 
 class CpStorage;
 class FileWatcher;
+class IoChannel;
 class LogController;
 class LogPipeHandler;
 class MediaStorCheck;
@@ -95,6 +98,36 @@ class StorageManager {
                             size_t cmt_size);
   void delete_storage(CpStorage* stor);
 
+  /*  io_channel - get the log writer shared by all CpStorage objects
+   *               on the specified media.
+   *  @mt: the media type
+   *
+   *  The IoChannel is created on first use.
+   *
+   *  Return the IoChannel pointer on success, NULL on failure.
+   */
+  IoChannel* io_channel(MediaType mt);
+  /*  created_io_channel - get the IoChannel of the media if it has been
+   *                       created.
+   */
+  IoChannel* created_io_channel(MediaType mt) const {
+    return mt < MT_STOR_END ? m_io_chans[mt] : nullptr;
+  }
+
+  /*  reclaimer - get the LogReclaimer that removes the trash of the
+   *              media in the background.
+   *
+   *  Return nullptr if the reclaimer is not running.
+   */
+  LogReclaimer* reclaimer() {
+    return m_reclaimer_running ? &m_reclaimer : nullptr;
+  }
+
+  /*  buffer_pool - get the log buffer pool shared by all CpStorage
+   *                objects.
+   */
+  BufferPool& buffer_pool() { return m_buf_pool; }
+
   /* get_media_stor - get media storage (internal or external) according
    *                  to media type.
    * @MediaType: MT_INTERNAL or MT_SD_CARD
@@ -222,6 +255,15 @@ class StorageManager {
   bool m_use_ext_stor_fuse;
   // uevent monitor
   UeventMonitor* m_uevent_monitor;
+  LogController* m_log_ctrl;
+  Multiplexer* m_multiplexer;
+  // Log writers of the media
+  IoChannel* m_io_chans[MT_STOR_END];
+  // Background removal of the trash of the media
+  LogReclaimer m_reclaimer;
+  bool m_reclaimer_running;
+  // Log buffers of all CpStorage objects
+  BufferPool m_buf_pool;
 };
 
 #endif  // !_STOR_MGR_H_
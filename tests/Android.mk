@@ -0,0 +1,59 @@
+# Host tests and benchmarks of the slogmodem components
+LOCAL_PATH:= $(call my-dir)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := slogmodem_diag_parser_test
+LOCAL_MODULE_TAGS := tests
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_SRC_FILES := ../diag_stream_parser.cpp \
+                   diag_stream_parser_test.cpp
+LOCAL_CFLAGS += -DHOST_TEST_ -DUSE_STD_CPP_LIB_
+LOCAL_CPPFLAGS += -std=c++11
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := slogmodem_mpmc_queue_bench
+LOCAL_MODULE_TAGS := tests
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_SRC_FILES := mpmc_queue_bench.cpp
+LOCAL_CFLAGS += -DHOST_TEST_ -DUSE_STD_CPP_LIB_
+LOCAL_CPPFLAGS += -std=c++11
+LOCAL_LDLIBS += -lpthread
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := slogmodem_buf_pool_test
+LOCAL_MODULE_TAGS := tests
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_SRC_FILES := ../buf_pool.cpp \
+                   ../data_buf.cpp \
+                   buf_pool_test.cpp
+LOCAL_CFLAGS += -DHOST_TEST_ -DUSE_STD_CPP_LIB_
+LOCAL_CPPFLAGS += -std=c++11
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := slogmodem_log_index_test
+LOCAL_MODULE_TAGS := tests
+LOCAL_C_INCLUDES := $(LOCAL_PATH) $(LOCAL_PATH)/..
+LOCAL_SRC_FILES := ../cp_log_cmn.cpp \
+                   ../data_buf.cpp \
+                   ../log_file.cpp \
+                   ../log_index.cpp \
+                   ../parse_utils.cpp \
+                   fake_cp_dir.cpp \
+                   log_index_test.cpp
+LOCAL_CFLAGS += -DHOST_TEST_ -DUSE_STD_CPP_LIB_ \
+                -DWORK_CONF_DIR=\"/tmp/\"
+LOCAL_CPPFLAGS += -std=c++11
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE := slogmodem_timer_mgr_test
+LOCAL_MODULE_TAGS := tests
+LOCAL_C_INCLUDES := $(LOCAL_PATH)/..
+LOCAL_SRC_FILES := ../timer_mgr.cpp \
+                   timer_mgr_test.cpp
+LOCAL_CFLAGS += -DHOST_TEST_ -DUSE_STD_CPP_LIB_
+LOCAL_CPPFLAGS += -std=c++11
+include $(BUILD_HOST_EXECUTABLE)
@@ -0,0 +1,304 @@
+/*
+ *  buf_pool_test.cpp - host test of BufferPool and the comparison of
+ *                      the log drop with private buffers.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include "buf_pool.h"
+#include "host_test.h"
+
+// Times each client is notified
+static void buffer_avail(void* client) { ++*static_cast<unsigned*>(client); }
+
+static void test_borrow() {
+  const size_t kBlock = 1024;
+  BufferPool pool(2 * kBlock);
+  unsigned notified_a = 0;
+  unsigned notified_b = 0;
+  BufferPool::Client* a = pool.add_client(kBlock, 4, &notified_a,
+                                          buffer_avail);
+  BufferPool::Client* b = pool.add_client(kBlock, 2, &notified_b,
+                                          buffer_avail);
+  std::vector<DataBuffer*> bufs_a;
+  std::vector<DataBuffer*> bufs_b;
+
+  CHECK(8 * kBlock == pool.cap());
+  CHECK(6 * kBlock == pool.allocated());
+
+  // A takes its reserved buffers and the shared memory.
+  for (int i = 0; i < 6; ++i) {
+    bufs_a.push_back(pool.get(a));
+    CHECK(bufs_a.back());
+  }
+  CHECK(!pool.get(a));
+  CHECK(pool.allocated() == pool.cap());
+
+  // The reserved buffers of B are still available.
+  for (int i = 0; i < 2; ++i) {
+    bufs_b.push_back(pool.get(b));
+    CHECK(bufs_b.back());
+  }
+  CHECK(!pool.get(b));
+
+  // The borrowed buffer A frees goes to the waiting B.
+  pool.put(a, bufs_a.back());
+  bufs_a.pop_back();
+  CHECK(1 == notified_b);
+  bufs_b.push_back(pool.get(b));
+  CHECK(bufs_b.back());
+  CHECK(pool.allocated() == pool.cap());
+  CHECK(!b->waiting);
+
+  // With nobody waiting, A keeps the borrowed buffer it frees, and the
+  // buffer is released when B needs to borrow.
+  pool.put(a, bufs_a.back());
+  bufs_a.pop_back();
+  CHECK(1 == a->idle.size());
+  bufs_b.push_back(pool.get(b));
+  CHECK(bufs_b.back());
+  CHECK(a->idle.empty() && 4 == a->owned);
+  CHECK(pool.allocated() == pool.cap());
+
+  // The reserved buffers of A are never taken by B.
+  for (auto buf : bufs_a) {
+    pool.put(a, buf);
+  }
+  bufs_a.clear();
+  CHECK(!pool.get(b));
+  CHECK(4 == a->idle.size());
+  for (int i = 0; i < 4; ++i) {
+    bufs_a.push_back(pool.get(a));
+    CHECK(bufs_a.back());
+  }
+  CHECK(!pool.get(a));
+
+  // The borrowed buffer B frees goes to the waiting A.
+  unsigned notified = notified_a;
+
+  pool.put(b, bufs_b.back());
+  bufs_b.pop_back();
+  CHECK(notified + 1 == notified_a);
+  bufs_a.push_back(pool.get(a));
+  CHECK(bufs_a.back());
+
+  for (auto buf : bufs_a) {
+    pool.put(a, buf);
+  }
+  for (auto buf : bufs_b) {
+    pool.put(b, buf);
+  }
+  CHECK(!a->waiting && !b->waiting);
+  CHECK(pool.allocated() <= pool.cap());
+}
+
+static void test_resize() {
+  const size_t kBlock = 1024;
+  BufferPool pool(0);
+  BufferPool::Client* c = pool.add_client(kBlock, 4, nullptr, nullptr);
+  DataBuffer* old_buf = pool.get(c);
+
+  CHECK(old_buf);
+  CHECK(!pool.resize_client(c, 2 * kBlock, 2));
+  // The buffer of the previous size is still in use.
+  CHECK(5 * kBlock == pool.allocated());
+  CHECK(-1 == pool.resize_client(c, kBlock, 2));
+
+  DataBuffer* buf = pool.get(c);
+  CHECK(buf && 2 * kBlock == buf->buf_size);
+
+  // The buffer of the previous size is released when it is returned.
+  pool.put(c, old_buf);
+  CHECK(4 * kBlock == pool.allocated());
+  pool.put(c, buf);
+  CHECK(!pool.resize_client(c, kBlock, 2));
+  CHECK(2 * kBlock == pool.allocated() && 2 * kBlock == pool.cap());
+}
+
+static void test_random(TestRandom& rnd) {
+  const size_t kClients = 3;
+  const size_t block_sizes[kClients] = {4096, 1024, 2048};
+  const size_t reserved[kClients] = {4, 2, 3};
+  BufferPool pool(16 * 1024);
+  unsigned notified[kClients] = {};
+  BufferPool::Client* clients[kClients];
+  std::vector<DataBuffer*> in_use[kClients];
+
+  for (size_t i = 0; i < kClients; ++i) {
+    clients[i] = pool.add_client(block_sizes[i], reserved[i], &notified[i],
+                                 buffer_avail);
+  }
+
+  for (int n = 0; n < 100000; ++n) {
+    size_t i = rnd.below(kClients);
+    BufferPool::Client* c = clients[i];
+
+    if (in_use[i].empty() || rnd.below(2)) {
+      DataBuffer* buf = pool.get(c);
+
+      // The reserved buffers are always available.
+      CHECK(buf || in_use[i].size() >= reserved[i]);
+      CHECK(buf || c->waiting);
+      if (buf) {
+        CHECK(block_sizes[i] == buf->buf_size);
+        in_use[i].push_back(buf);
+      }
+    } else {
+      size_t k = rnd.below(in_use[i].size());
+
+      pool.put(c, in_use[i][k]);
+      in_use[i].erase(in_use[i].begin() + k);
+    }
+    CHECK(pool.allocated() <= pool.cap());
+  }
+
+  // All waiting clients are notified when the buffers are returned.
+  for (size_t i = 0; i < kClients; ++i) {
+    for (auto buf : in_use[i]) {
+      pool.put(clients[i], buf);
+    }
+  }
+  for (size_t i = 0; i < kClients; ++i) {
+    CHECK(!clients[i]->waiting);
+  }
+}
+
+/*  bench_mixed_burst - log dropped by private pools and the shared pool.
+ *
+ *  Three subsystems write to a 16 MB/s media. The WAN log bursts at
+ *  30 MB/s for 300 ms every 2 s. The data of each subsystem is dropped
+ *  when its 64 KB to 256 KB hardware FIFO overflows for lack of
+ *  buffers.
+ */
+static void bench_mixed_burst() {
+  struct Subsystem {
+    const char* name;
+    size_t block_size;
+    size_t reserved;
+    // Buffers are committed when they have this many bytes
+    size_t threshold;
+    size_t fifo_size;
+    // MB/s
+    double rate;
+    double burst_rate;
+    BufferPool::Client* client;
+    DataBuffer* cur;
+    size_t fifo;
+    size_t dropped;
+    size_t total;
+  };
+  struct Write {
+    Subsystem* sub;
+    DataBuffer* buf;
+  };
+  const size_t shared_sizes[] = {0, 2 << 20};
+  size_t wan_dropped[2];
+
+  for (int k = 0; k < 2; ++k) {
+    BufferPool pool(shared_sizes[k]);
+    Subsystem subs[] = {
+        {"WAN", 256 << 10, 12, 224 << 10, 256 << 10, 2, 30,
+         nullptr, nullptr, 0, 0, 0},
+        {"WCN", 160 << 10, 3, 144 << 10, 64 << 10, 0.5, 0.5,
+         nullptr, nullptr, 0, 0, 0},
+        {"AG-DSP", 160 << 10, 3, 128 << 10, 64 << 10, 0.3, 0.3,
+         nullptr, nullptr, 0, 0, 0},
+    };
+    std::deque<Write> writes;
+    // Bytes the media can write per ms
+    const double media_rate = 16e6 / 1000;
+    double media_left = 0;
+    size_t peak = 0;
+
+    for (auto& s : subs) {
+      s.client = pool.add_client(s.block_size, s.reserved, nullptr, nullptr);
+    }
+    for (int ms = 0; ms < 20000; ++ms) {
+      bool burst = ms % 2000 < 300;
+
+      for (auto& s : subs) {
+        size_t in = static_cast<size_t>((burst ? s.burst_rate : s.rate) *
+                                        1e6 / 1000);
+
+        s.total += in;
+        s.fifo += in;
+        if (s.fifo > s.fifo_size) {
+          s.dropped += s.fifo - s.fifo_size;
+          s.fifo = s.fifo_size;
+        }
+        while (s.fifo) {
+          if (!s.cur && !(s.cur = pool.get(s.client))) {
+            break;
+          }
+
+          size_t n = std::min(s.fifo, s.cur->buf_size - s.cur->data_len);
+
+          s.cur->data_len += n;
+          s.fifo -= n;
+          if (s.cur->data_len >= s.threshold) {
+            writes.push_back(Write{&s, s.cur});
+            s.cur = nullptr;
+          }
+        }
+      }
+
+      media_left += media_rate;
+      while (!writes.empty() &&
+             media_left >= writes.front().buf->data_len) {
+        Write& w = writes.front();
+
+        media_left -= w.buf->data_len;
+        w.buf->data_len = 0;
+        pool.put(w.sub->client, w.buf);
+        writes.pop_front();
+      }
+      if (writes.empty()) {
+        media_left = 0;
+      }
+      peak = std::max(peak, pool.allocated());
+    }
+
+    printf("%s:", k ? "shared pool" : "private pools");
+    for (auto& s : subs) {
+      printf(" %s %u/%u KB dropped", s.name,
+             static_cast<unsigned>(s.dropped >> 10),
+             static_cast<unsigned>(s.total >> 10));
+    }
+    printf(", peak %u KB\n", static_cast<unsigned>(peak >> 10));
+    CHECK(peak <= pool.cap());
+    wan_dropped[k] = subs[0].dropped;
+
+    for (auto& s : subs) {
+      if (s.cur) {
+        pool.put(s.client, s.cur);
+      }
+    }
+    for (auto& w : writes) {
+      pool.put(w.sub->client, w.buf);
+    }
+  }
+  CHECK(wan_dropped[1] < wan_dropped[0]);
+}
+
+int main(int argc, char** argv) {
+  uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0)
+                           : static_cast<uint64_t>(time(nullptr));
+  TestRandom rnd(seed);
+
+  printf("seed %llu\n", static_cast<unsigned long long>(seed));
+  test_borrow();
+  test_resize();
+  test_random(rnd);
+  bench_mixed_burst();
+
+  return test_result("buf_pool_test");
+}
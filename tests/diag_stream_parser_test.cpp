@@ -0,0 +1,321 @@
+/*
+ *  diag_stream_parser_test.cpp - host test and benchmark of
+ *                                DiagStreamParser.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "diag_cmd_def.h"
+#include "diag_stream_parser.h"
+#include "host_test.h"
+
+typedef std::vector<uint8_t> Bytes;
+typedef std::vector<Bytes> Frames;
+
+// Size of DiagStreamParser::m_pool
+static const size_t kMaxFrame = 64 * 1024;
+
+/*  RefParser - the diag stream parsed one byte at a time.
+ *
+ *  It has the same interface and frame size limit as DiagStreamParser.
+ */
+class RefParser {
+ public:
+  RefParser() : m_state{PPP_DOWN} {}
+
+  bool unescape(uint8_t* src_ptr, size_t src_len, uint8_t** dst_ptr,
+                size_t* dst_len, size_t* used_len) {
+    size_t i = 0;
+
+    while (i < src_len) {
+      uint8_t b = src_ptr[i];
+
+      switch (m_state) {
+        case PPP_DOWN:
+          if (FLAG_BYTE == b) {
+            m_state = PPP_READY;
+          }
+          ++i;
+          break;
+        case PPP_READY:
+          if (FLAG_BYTE == b) {
+            ++i;
+            break;
+          }
+          m_state = PPP_UP;
+          break;
+        case PPP_HALT:
+          if (!append(b ^ COMPLEMENT_BYTE)) {
+            break;
+          }
+          m_state = PPP_UP;
+          ++i;
+          break;
+        default:  // PPP_UP
+          if (FLAG_BYTE == b) {
+            m_state = PPP_DOWN;
+            m_frame.swap(m_data);
+            m_data.clear();
+            *dst_ptr = m_frame.data();
+            *dst_len = m_frame.size();
+            *used_len = i + 1;
+            return true;
+          }
+          if (ESCAPE_BYTE == b) {
+            m_state = PPP_HALT;
+            ++i;
+          } else if (append(b)) {
+            ++i;
+          }
+          break;
+      }
+    }
+
+    *used_len = src_len;
+    return false;
+  }
+
+ private:
+  DiagParseState m_state;
+  Bytes m_data;
+  Bytes m_frame;
+
+  /*  append - add a byte to the frame.
+   *
+   *  Return false if the frame is dropped for its length. The byte
+   *  is parsed again in the PPP_DOWN state.
+   */
+  bool append(uint8_t b) {
+    if (m_data.size() >= kMaxFrame) {
+      m_state = PPP_DOWN;
+      m_data.clear();
+      return false;
+    }
+    m_data.push_back(b);
+    return true;
+  }
+};
+
+/*  parse - feed the stream to the parser in pieces.
+ *  @cuts: end offsets of the pieces.
+ */
+template <typename P>
+static Frames parse(P& parser, Bytes& stream,
+                    const std::vector<size_t>& cuts) {
+  Frames frames;
+  size_t pos = 0;
+
+  for (size_t end : cuts) {
+    while (pos < end) {
+      uint8_t* frame;
+      size_t frame_len;
+      size_t used;
+
+      if (parser.unescape(&stream[pos], end - pos, &frame, &frame_len,
+                          &used)) {
+        frames.push_back(Bytes(frame, frame + frame_len));
+      }
+      pos += used;
+    }
+  }
+
+  return frames;
+}
+
+static void test_find_special(TestRandom& rnd) {
+  uint8_t buf[256 + 16];
+
+  // Every length, alignment and position of the special byte
+  for (size_t align = 0; align < 16; ++align) {
+    for (size_t len = 0; len <= 256; ++len) {
+      uint8_t* p = buf + align;
+
+      for (size_t i = 0; i < len; ++i) {
+        p[i] = static_cast<uint8_t>(rnd.next());
+        if (FLAG_BYTE == p[i] || ESCAPE_BYTE == p[i]) {
+          p[i] = 0;
+        }
+      }
+      CHECK(DiagStreamParser::find_special(p, len) == len);
+      for (size_t pos = 0; pos < len; ++pos) {
+        uint8_t save = p[pos];
+
+        p[pos] = pos & 1 ? FLAG_BYTE : ESCAPE_BYTE;
+        CHECK(DiagStreamParser::find_special(p, len) == pos);
+        p[pos] = save;
+      }
+    }
+  }
+
+  // Random data of random density
+  for (int n = 0; n < 100000; ++n) {
+    size_t len = rnd.below(sizeof buf - 15);
+    uint8_t* p = buf + rnd.below(16);
+    unsigned density = rnd.below(64) + 1;
+
+    for (size_t i = 0; i < len; ++i) {
+      p[i] = rnd.below(density * 16) ? static_cast<uint8_t>(rnd.next())
+                                     : FLAG_BYTE;
+    }
+    CHECK(DiagStreamParser::find_special(p, len) ==
+          DiagStreamParser::find_special_scalar(p, len));
+  }
+}
+
+/*  random_stream - random diag stream of frames and garbage.
+ */
+static Bytes random_stream(TestRandom& rnd, size_t len) {
+  Bytes s(len);
+  // Percentage of the special bytes
+  unsigned density = rnd.below(8);
+
+  for (auto& b : s) {
+    unsigned r = rnd.below(100);
+
+    if (r < density) {
+      b = r & 1 ? FLAG_BYTE : ESCAPE_BYTE;
+    } else {
+      b = static_cast<uint8_t>(rnd.next());
+    }
+  }
+
+  return s;
+}
+
+static void test_unescape(TestRandom& rnd) {
+  static DiagStreamParser parser;
+
+  for (int n = 0; n < 3000; ++n) {
+    Bytes s = random_stream(rnd, rnd.below(20000) + 1);
+    std::vector<size_t> cuts;
+    size_t end = 0;
+
+    while (end < s.size()) {
+      end += rnd.below(300) + 1;
+      if (end > s.size()) {
+        end = s.size();
+      }
+      cuts.push_back(end);
+    }
+
+    RefParser ref;
+
+    parser.reset();
+    CHECK(parse(parser, s, cuts) == parse(ref, s, cuts));
+  }
+}
+
+static void test_escape_across_buffers() {
+  static DiagStreamParser parser;
+  uint8_t payload[40];
+
+  for (size_t i = 0; i < sizeof payload; ++i) {
+    payload[i] = static_cast<uint8_t>(0x70 + i % 16);
+  }
+
+  uint8_t buf[DiagStreamParser::max_frame_len(sizeof payload)];
+  size_t len = DiagStreamParser::frame(1, 2, 3, payload, sizeof payload,
+                                       buf, sizeof buf);
+  CHECK(len > sizeof payload + sizeof(struct diag_cmd_head) + 2);
+
+  Bytes s(buf, buf + len);
+
+  // Split the frame at every position, including right after each
+  // ESCAPE_BYTE so that the parser is left in PPP_HALT.
+  for (size_t cut = 1; cut < len; ++cut) {
+    std::vector<size_t> cuts{cut, len};
+
+    parser.reset();
+    Frames frames = parse(parser, s, cuts);
+
+    CHECK(1 == frames.size());
+    if (1 == frames.size()) {
+      const Bytes& f = frames[0];
+
+      CHECK(f.size() == sizeof(struct diag_cmd_head) + sizeof payload);
+      CHECK(!memcmp(parser.get_payload(const_cast<uint8_t*>(f.data())),
+                    payload, sizeof payload));
+    }
+  }
+}
+
+static void test_long_frame() {
+  static DiagStreamParser parser;
+  RefParser ref;
+  // A frame longer than the pool followed by a short one
+  Bytes s(kMaxFrame + 100, 1);
+
+  s[0] = FLAG_BYTE;
+  s[kMaxFrame + 10] = FLAG_BYTE;
+  s[kMaxFrame + 11] = FLAG_BYTE;
+  s[kMaxFrame + 12] = 5;
+  s[kMaxFrame + 13] = FLAG_BYTE;
+
+  std::vector<size_t> cuts{s.size()};
+  Frames frames = parse(parser, s, cuts);
+
+  CHECK(1 == frames.size());
+  CHECK(1 == frames.size() && Bytes(1, 5) == frames[0]);
+  CHECK(frames == parse(ref, s, cuts));
+}
+
+template <typename P>
+static double parse_rate(P& parser, Bytes& s) {
+  std::vector<size_t> cuts;
+
+  for (size_t end = 65536; end <= s.size(); end += 65536) {
+    cuts.push_back(end);
+  }
+
+  double t0 = test_now();
+  parse(parser, s, cuts);
+  return s.size() / (test_now() - t0) / (1024 * 1024);
+}
+
+static void bench_unescape(TestRandom& rnd) {
+  // Log frames of about 4 KB with an escaped byte every 500 bytes
+  Bytes s(32 << 20);
+
+  for (size_t i = 0; i < s.size(); ++i) {
+    s[i] = static_cast<uint8_t>(rnd.next());
+    if (FLAG_BYTE == s[i] || ESCAPE_BYTE == s[i]) {
+      s[i] = 0;
+    }
+  }
+  for (size_t i = 0; i < s.size(); i += 4000) {
+    s[i] = FLAG_BYTE;
+  }
+  for (size_t i = 7; i < s.size(); i += 500) {
+    s[i] = ESCAPE_BYTE;
+  }
+
+  static DiagStreamParser parser;
+  RefParser ref;
+  double rate = parse_rate(parser, s);
+  double ref_rate = parse_rate(ref, s);
+
+  printf("unescape: %.0f MB/s, byte by byte %.0f MB/s\n", rate, ref_rate);
+}
+
+int main(int argc, char** argv) {
+  uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0)
+                           : static_cast<uint64_t>(time(nullptr));
+  TestRandom rnd(seed);
+
+  printf("seed %llu\n", static_cast<unsigned long long>(seed));
+  test_find_special(rnd);
+  test_unescape(rnd);
+  test_escape_across_buffers();
+  test_long_frame();
+  bench_unescape(rnd);
+
+  return test_result("diag_stream_parser_test");
+}
@@ -0,0 +1,27 @@
+/*
+ *  fake_cp_dir.cpp - CpDirectory of the host tests, which only keeps
+ *                    the size of the files.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include "cp_dir.h"
+
+CpDirectory::CpDirectory(CpSetDirectory* par_dir, CpType ct,
+                         const LogString& dir)
+    : m_cp_set_dir{par_dir},
+      m_ct{ct},
+      m_path(dir),
+      m_size{},
+      m_evict_group{},
+      m_log_watch{},
+      m_set_watch{},
+      m_store_full{} {}
+
+CpDirectory::~CpDirectory() {}
+
+void CpDirectory::add_size(size_t len) { m_size += len; }
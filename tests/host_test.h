@@ -0,0 +1,76 @@
+/*
+ *  host_test.h - helpers of the host tests.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _HOST_TEST_H_
+#define _HOST_TEST_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <time.h>
+
+/*  test_failures - number of the failed checks.
+ */
+inline unsigned& test_failures() {
+  static unsigned failures;
+  return failures;
+}
+
+#define CHECK(cond)                                             \
+  do {                                                          \
+    if (!(cond)) {                                              \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__,    \
+              __LINE__, #cond);                                 \
+      ++test_failures();                                        \
+    }                                                           \
+  } while (0)
+
+/*  test_result - print the result of the test program.
+ *
+ *  Return the exit code of the test program.
+ */
+inline int test_result(const char* name) {
+  if (test_failures()) {
+    printf("%s: %u checks FAILED\n", name, test_failures());
+    return 1;
+  }
+  printf("%s: PASSED\n", name);
+  return 0;
+}
+
+/*  test_now - CLOCK_MONOTONIC time in seconds.
+ */
+inline double test_now() {
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/*  TestRandom - xorshift generator so that a failure can be reproduced
+ *               from the printed seed.
+ */
+class TestRandom {
+ public:
+  explicit TestRandom(uint64_t seed) : m_state{seed ? seed : 1} {}
+
+  uint32_t next() {
+    m_state ^= m_state << 13;
+    m_state ^= m_state >> 7;
+    m_state ^= m_state << 17;
+    return static_cast<uint32_t>(m_state >> 16);
+  }
+  /*  below - random number in [0, n).
+   */
+  uint32_t below(uint32_t n) { return next() % n; }
+
+ private:
+  uint64_t m_state;
+};
+
+#endif  // !_HOST_TEST_H_
@@ -0,0 +1,314 @@
+/*
+ *  log_index_test.cpp - host test of LogIndex.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+#include "cp_dir.h"
+#include "def_config.h"
+#include "host_test.h"
+#include "log_file.h"
+#include "log_index.h"
+
+// Where the data of each write request starts
+struct DataInfo {
+  // Offset without compression
+  uint64_t offset;
+  uint64_t file_offset;
+  uint64_t stamp;
+};
+
+// CLOCK_BOOTTIME seconds returned by the time sync callback
+static uint32_t s_uptime;
+
+static bool time_sync_cb(void* /*client*/, time_sync& ts) {
+  ts.sys_cnt = 1000000;
+  ts.uptime = s_uptime;
+  return true;
+}
+
+static std::vector<uint8_t> read_file(const LogString& path) {
+  std::vector<uint8_t> data;
+  int fd = open(ls2cstring(path), O_RDONLY);
+
+  if (fd >= 0) {
+    uint8_t buf[4096];
+    ssize_t n;
+
+    while ((n = read(fd, buf, sizeof buf)) > 0) {
+      data.insert(data.end(), buf, buf + n);
+    }
+    ::close(fd);
+  }
+
+  return data;
+}
+
+static std::vector<LogIndexEntry> read_index(const LogString& path) {
+  std::vector<uint8_t> data = read_file(path);
+  std::vector<LogIndexEntry> entries;
+  LogIndexHeader hdr;
+
+  CHECK(data.size() >= sizeof hdr);
+  if (data.size() < sizeof hdr) {
+    return entries;
+  }
+  memcpy(&hdr, data.data(), sizeof hdr);
+  CHECK(LOG_INDEX_MAGIC == hdr.magic);
+  CHECK(LOG_INDEX_VERSION == hdr.version);
+  CHECK(sizeof(LogIndexEntry) == hdr.entry_len);
+  CHECK(LOG_INDEX_INTERVAL == hdr.interval);
+  CHECK(LOG_INDEX_PERIOD == hdr.period);
+  CHECK(!((data.size() - sizeof hdr) % sizeof(LogIndexEntry)));
+
+  for (size_t pos = sizeof hdr; pos + sizeof(LogIndexEntry) <= data.size();
+       pos += sizeof(LogIndexEntry)) {
+    LogIndexEntry e;
+
+    memcpy(&e, &data[pos], sizeof e);
+    entries.push_back(e);
+  }
+
+  return entries;
+}
+
+/*  check_entries - check the entries against the data written.
+ *  @data: the data that may be indexed, in the order of the offsets.
+ *
+ *  The first data shall be indexed, and the others shall be indexed if
+ *  and only if they are at least LOG_INDEX_INTERVAL bytes or
+ *  LOG_INDEX_PERIOD ms after the previous entry.
+ */
+static void check_entries(const std::vector<LogIndexEntry>& entries,
+                          const std::vector<DataInfo>& data) {
+  size_t k = 0;
+  const DataInfo* last = nullptr;
+
+  for (auto& d : data) {
+    bool due = !last || d.offset - last->offset >= LOG_INDEX_INTERVAL ||
+               d.stamp >= last->stamp + LOG_INDEX_PERIOD;
+
+    if (!due) {
+      CHECK(k == entries.size() || entries[k].offset != d.offset);
+      continue;
+    }
+    CHECK(k < entries.size());
+    if (k == entries.size()) {
+      return;
+    }
+
+    const LogIndexEntry& e = entries[k];
+
+    CHECK(e.offset == d.offset);
+    CHECK(e.file_offset == d.file_offset);
+    CHECK(e.flags & LOG_INDEX_SYS_CNT);
+    if (last) {
+      // The times of the entries are those when the data was read.
+      const LogIndexEntry& p = entries[k - 1];
+      int64_t dt = static_cast<int64_t>(d.stamp - last->stamp);
+      int64_t us = (static_cast<int64_t>(e.tv_sec) - p.tv_sec) * 1000000 +
+                   (static_cast<int64_t>(e.tv_usec) - p.tv_usec);
+      int64_t cnt = static_cast<int32_t>(e.sys_cnt - p.sys_cnt);
+
+      CHECK(llabs(us - dt * 1000) <= 5000);
+      CHECK(llabs(cnt - dt) <= 5);
+    }
+    last = &d;
+    ++k;
+  }
+  CHECK(k == entries.size());
+}
+
+static DataBuffer* new_buffer(TestRandom& rnd, uint64_t stamp) {
+  DataBuffer* buf = alloc_data_buf(8192);
+  size_t len = rnd.below(8192 - 64) + 64;
+
+  for (size_t i = 0; i < len; ++i) {
+    buf->buffer[i] = static_cast<uint8_t>(rnd.next());
+  }
+  buf->data_len = len;
+  buf->stamp = stamp;
+
+  return buf;
+}
+
+static void test_plain(TestRandom& rnd, CpDirectory& dir) {
+  LogString name = "md_20261017-100000.log";
+  LogFile log(name, &dir, LogFile::LT_LOG);
+  std::shared_ptr<LogFile> idx_file{
+      new LogFile(LogIndex::index_name(name), &dir, LogFile::LT_LOG_INDEX)};
+
+  CHECK(!log.create(O_TRUNC));
+  CHECK(!idx_file->create(O_TRUNC));
+
+  LogIndex index(idx_file, nullptr, time_sync_cb);
+  std::vector<DataInfo> data;
+  // The first buffers were read long ago.
+  uint64_t stamp = monotonic_ms() - 1000000;
+  char prologue[16] = "prologue";
+
+  CHECK(!index.start());
+  log.write_raw(prologue, sizeof prologue);
+  log.add_size(sizeof prologue);
+
+  for (int n = 0; n < 1000; ++n) {
+    std::vector<DataBuffer*> bufs(rnd.below(4) + 1);
+    size_t total = 0;
+
+    for (auto& buf : bufs) {
+      stamp += rnd.below(120);
+      buf = new_buffer(rnd, stamp);
+      total += buf->data_len;
+    }
+
+    // Some of the requests are partly written.
+    size_t written = total;
+    if (!rnd.below(10)) {
+      written -= rnd.below(bufs.back()->data_len);
+    }
+
+    uint64_t offset = log.size();
+    size_t len = written;
+
+    index.add(&log, bufs, written);
+    for (auto buf : bufs) {
+      size_t n = buf->data_len < len ? buf->data_len : len;
+
+      if (!n) {
+        break;
+      }
+      data.push_back(DataInfo{offset, offset, buf->stamp});
+      // Tag the data with its offset.
+      memcpy(buf->buffer, &offset, n < 8 ? n : 8);
+      log.write_raw(buf->buffer, n);
+      offset += n;
+      len -= n;
+    }
+    log.add_size(written);
+
+    for (auto buf : bufs) {
+      delete buf;
+    }
+  }
+
+  index.close();
+  log.close();
+
+  std::vector<LogIndexEntry> entries =
+      read_index(dir.path() + "/" + LogIndex::index_name(name));
+  std::vector<uint8_t> content = read_file(dir.path() + "/" + name);
+
+  CHECK(content.size() == log.size());
+  CHECK(!entries.empty() && sizeof prologue == entries[0].offset);
+  check_entries(entries, data);
+  // The entries point to the data they are added for.
+  for (auto& e : entries) {
+    uint64_t tag = 0;
+
+    if (e.offset + 8 <= content.size()) {
+      memcpy(&tag, &content[e.offset], 8);
+    }
+    CHECK(tag == e.offset);
+  }
+  printf("plain log: %u bytes, %u entries\n",
+         static_cast<unsigned>(log.size()),
+         static_cast<unsigned>(entries.size()));
+}
+
+static void test_compressed(TestRandom& rnd, CpDirectory& dir) {
+  LogString name = "md_20261017-110000.log";
+  LogFile log(name, &dir, LogFile::LT_LOG);
+  std::shared_ptr<LogFile> idx_file{
+      new LogFile(LogIndex::index_name(name), &dir, LogFile::LT_LOG_INDEX)};
+
+  CHECK(!log.create(O_TRUNC));
+  CHECK(!idx_file->create(O_TRUNC));
+
+  LogIndex index(idx_file, nullptr, time_sync_cb);
+  std::vector<DataInfo> data;
+  uint64_t stamp = monotonic_ms() - 1000000;
+  const size_t header_len = 48;
+  const size_t prologue_len = 16;
+  // Offset of the data without compression
+  uint64_t offset = prologue_len;
+
+  CHECK(!index.start());
+  log.set_compressed(header_len);
+  log.add_size(header_len + prologue_len);
+
+  for (int n = 0; n < 1000; ++n) {
+    std::vector<DataBuffer*> bufs(rnd.below(4) + 1);
+    size_t written = 0;
+
+    for (auto& buf : bufs) {
+      stamp += rnd.below(120);
+      buf = new_buffer(rnd, stamp);
+      written += buf->data_len;
+    }
+
+    // A frame is decoded from its start only.
+    data.push_back(DataInfo{offset, log.size(), bufs[0]->stamp});
+    index.add(&log, bufs, written);
+    // The size of the compressed frame
+    log.add_size(written / 3 + 20);
+    offset += written;
+
+    for (auto buf : bufs) {
+      delete buf;
+    }
+  }
+
+  index.close();
+  log.close();
+
+  std::vector<LogIndexEntry> entries =
+      read_index(dir.path() + "/" + LogIndex::index_name(name));
+
+  CHECK(!entries.empty() && prologue_len == entries[0].offset &&
+        header_len + prologue_len == entries[0].file_offset);
+  check_entries(entries, data);
+  printf("compressed log: %u entries\n",
+         static_cast<unsigned>(entries.size()));
+}
+
+int main(int argc, char** argv) {
+  uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0)
+                           : static_cast<uint64_t>(time(nullptr));
+  TestRandom rnd(seed);
+  char path[] = "/tmp/log_index_testXXXXXX";
+  struct timespec bt;
+
+  printf("seed %llu\n", static_cast<unsigned long long>(seed));
+  if (!mkdtemp(path)) {
+    perror("mkdtemp");
+    return 1;
+  }
+  clock_gettime(CLOCK_BOOTTIME, &bt);
+  s_uptime = static_cast<uint32_t>(bt.tv_sec);
+
+  {
+    CpDirectory dir(nullptr, CT_WCDMA, path);
+
+    test_plain(rnd, dir);
+    test_compressed(rnd, dir);
+  }
+
+  LogString cmd = LogString("rm -rf ") + path;
+  if (system(ls2cstring(cmd))) {
+    fprintf(stderr, "can not remove %s\n", path);
+  }
+
+  return test_result("log_index_test");
+}
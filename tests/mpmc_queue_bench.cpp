@@ -0,0 +1,104 @@
+/*
+ *  mpmc_queue_bench.cpp - contention benchmark of MpmcQueue and
+ *                         ConcurrentQueue.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "concurrent_queue.h"
+#include "host_test.h"
+#include "mpmc_queue.h"
+
+// Items pushed by each producer
+static const unsigned kItems = 200000;
+
+/*  run - pass the items from the producers to the consumers.
+ *  @threads: number of the producers, and of the consumers.
+ *  @push: push an item, return false if the queue is full.
+ *  @pop: pop an item, return false if the queue is empty.
+ *
+ *  Return the number of million items passed per second.
+ */
+template <typename Push, typename Pop>
+static double run(unsigned threads, Push push, Pop pop) {
+  std::atomic<unsigned> popped{0};
+  std::atomic<uint64_t> sum{0};
+  std::vector<std::thread> workers;
+  const unsigned total = kItems * threads;
+  double t0 = test_now();
+
+  for (unsigned i = 0; i < threads; ++i) {
+    workers.emplace_back([&push] {
+      for (unsigned v = 1; v <= kItems; ++v) {
+        while (!push(v)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+    workers.emplace_back([&] {
+      uint64_t s = 0;
+      unsigned v;
+
+      while (popped.load(std::memory_order_relaxed) < total) {
+        if (pop(v)) {
+          s += v;
+          popped.fetch_add(1, std::memory_order_relaxed);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+      sum += s;
+    });
+  }
+  for (auto& t : workers) {
+    t.join();
+  }
+
+  double t = test_now() - t0;
+
+  // Every item is popped once.
+  CHECK(total == popped.load());
+  CHECK(static_cast<uint64_t>(kItems) * (kItems + 1) / 2 * threads ==
+        sum.load());
+
+  return total / t / 1e6;
+}
+
+int main() {
+  for (unsigned threads : {1, 4, 8}) {
+    MpmcQueue<unsigned, 32> mpmc;
+    ConcurrentQueue<unsigned> cq;
+    double mpmc_rate = run(
+        threads, [&mpmc](unsigned v) { return mpmc.push(v); },
+        [&mpmc](unsigned& v) { return mpmc.pop(v); });
+    double cq_rate = run(
+        threads,
+        [&cq](unsigned v) {
+          cq.push(std::unique_ptr<unsigned>{new unsigned{v}});
+          return true;
+        },
+        [&cq](unsigned& v) {
+          std::unique_ptr<unsigned> p = cq.get_next(false);
+
+          if (p) {
+            v = *p;
+          }
+          return static_cast<bool>(p);
+        });
+
+    printf("%u producers and %u consumers: MpmcQueue %.2f Mops/s, "
+           "ConcurrentQueue %.2f Mops/s\n",
+           threads, threads, mpmc_rate, cq_rate);
+  }
+
+  return test_result("mpmc_queue_bench");
+}
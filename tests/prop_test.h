@@ -0,0 +1,41 @@
+/*
+ *  prop_test.h - system properties of the host tests.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef _PROP_TEST_H_
+#define _PROP_TEST_H_
+
+#include <cstring>
+
+#define PROPERTY_KEY_MAX 32
+#define PROPERTY_VALUE_MAX 92
+
+/*  property_get - no property is set on the host, so the default
+ *                 value is returned.
+ */
+inline int property_get(const char* /*key*/, char* value,
+                        const char* default_value) {
+  size_t len = 0;
+
+  if (default_value) {
+    len = strlen(default_value);
+    if (len >= PROPERTY_VALUE_MAX) {
+      len = PROPERTY_VALUE_MAX - 1;
+    }
+    memcpy(value, default_value, len);
+  }
+  value[len] = '\0';
+
+  return static_cast<int>(len);
+}
+
+inline int property_set(const char* /*key*/, const char* /*value*/) {
+  return 0;
+}
+
+#endif  // !_PROP_TEST_H_
@@ -0,0 +1,279 @@
+/*
+ *  timer_mgr_test.cpp - host test and benchmark of TimerManager.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "host_test.h"
+#include "timer_mgr.h"
+
+// Parameters of the timers in the order they expire
+static std::vector<uintptr_t> s_fired;
+
+static void record(void* param) {
+  s_fired.push_back(reinterpret_cast<uintptr_t>(param));
+}
+
+static void record_other(void* param) { record(param); }
+
+static void* tag(uintptr_t n) { return reinterpret_cast<void*>(n); }
+
+static void sleep_ms(unsigned ms) {
+  struct timespec t = {0, static_cast<long>(ms) * 1000000};
+
+  nanosleep(&t, nullptr);
+}
+
+/*  drain - run the timers until all of them expire.
+ */
+static void drain(TimerManager& tm) {
+  struct timespec due;
+  struct timespec prev = {0, 0};
+
+  while (!tm.next_due_time(due)) {
+    CHECK(!(due < prev));
+    prev = due;
+    sleep_ms(1);
+    tm.run();
+  }
+}
+
+static void test_order(TestRandom& rnd) {
+  TimerManager tm;
+  std::vector<TimerManager::TimerHandle> timers;
+  std::vector<unsigned> intervals;
+
+  tm.set_slack(0);
+  s_fired.clear();
+  for (uintptr_t i = 0; i < 1000; ++i) {
+    intervals.push_back(rnd.below(50));
+    timers.push_back(tm.create_timer(intervals.back(),
+                                     i % 3 ? record : record_other,
+                                     tag(i)));
+    CHECK(timers.back());
+  }
+  // Delete by the handle and by the callback.
+  for (size_t i = 0; i < timers.size(); i += 7) {
+    tm.del_timer(timers[i]);
+  }
+  tm.del_timer(record_other);
+  drain(tm);
+
+  size_t expected = 0;
+
+  for (size_t i = 0; i < timers.size(); ++i) {
+    if (i % 3 && i % 7) {
+      ++expected;
+    }
+  }
+  CHECK(expected == s_fired.size());
+  for (size_t k = 0; k < s_fired.size(); ++k) {
+    uintptr_t i = s_fired[k];
+
+    CHECK(i % 3 && i % 7);
+    // Timers expire in the order of the due time, and in the creation
+    // order for the same interval.
+    if (k) {
+      uintptr_t prev = s_fired[k - 1];
+
+      CHECK(intervals[prev] < intervals[i] ||
+            (intervals[prev] == intervals[i] && prev < i));
+    }
+  }
+}
+
+static void test_reschedule() {
+  TimerManager tm;
+
+  tm.set_slack(0);
+  s_fired.clear();
+
+  TimerManager::TimerHandle t1 = tm.create_timer(10, record, tag(1));
+
+  tm.create_timer(20, record, tag(2));
+  CHECK(!tm.set_new_due_time(t1, 30));
+  drain(tm);
+  CHECK(2 == s_fired.size() && 2 == s_fired[0] && 1 == s_fired[1]);
+
+  // The timers rescheduled to the same due time keep their order.
+  s_fired.clear();
+  t1 = tm.create_timer(10, record, tag(1));
+
+  TimerManager::TimerHandle t2 = tm.create_timer(10, record, tag(2));
+
+  CHECK(!tm.set_new_due_time(t2, 0));
+  CHECK(!tm.set_new_due_time(t1, 0));
+  drain(tm);
+  CHECK(2 == s_fired.size() && 2 == s_fired[0] && 1 == s_fired[1]);
+}
+
+static TimerManager* s_tm;
+static TimerManager::TimerHandle s_self;
+
+static void delete_self(void* param) {
+  // The running timer is no longer active.
+  s_tm->del_timer(s_self);
+  CHECK(-1 == s_tm->set_new_due_time(s_self, 0));
+  record(param);
+}
+
+static void test_stale_handle() {
+  TimerManager tm;
+  struct timespec due;
+  struct timespec due2;
+
+  tm.set_slack(0);
+  s_fired.clear();
+
+  // The null handle
+  TimerManager::TimerHandle t0;
+
+  CHECK(!t0 && t0 == nullptr);
+  tm.del_timer(t0);
+  CHECK(-1 == tm.set_new_due_time(t0, 10));
+
+  // The slot of the deleted timer is reused by the next timer.
+  TimerManager::TimerHandle t1 = tm.create_timer(10, record, tag(1));
+
+  tm.del_timer(t1);
+
+  TimerManager::TimerHandle t2 = tm.create_timer(1000, record, tag(2));
+
+  CHECK(t1 && t2 && t1 != t2);
+  CHECK(-1 == tm.set_new_due_time(t1, 0));
+  CHECK(!tm.next_due_time(due));
+  tm.del_timer(t1);
+  CHECK(!tm.next_due_time(due2) && !(due < due2) && !(due2 < due));
+  CHECK(!tm.set_new_due_time(t2, 0));
+  drain(tm);
+  CHECK(1 == s_fired.size() && 2 == s_fired[0]);
+
+  // The handle of the expired timer
+  s_fired.clear();
+  tm.del_timer(t2);
+
+  TimerManager::TimerHandle t3 = tm.create_timer(0, record, tag(3));
+
+  tm.del_timer(t2);
+  CHECK(-1 == tm.set_new_due_time(t2, 1000));
+  drain(tm);
+  CHECK(1 == s_fired.size() && 3 == s_fired[0]);
+
+  // The timer deleting itself in the callback
+  s_fired.clear();
+  s_tm = &tm;
+  s_self = tm.create_timer(0, delete_self, tag(4));
+  tm.create_timer(0, record, tag(5));
+  drain(tm);
+  CHECK(2 == s_fired.size() && 4 == s_fired[0] && 5 == s_fired[1]);
+  tm.del_timer(t3);
+  tm.del_timer(s_self);
+  CHECK(tm.next_due_time(due));
+}
+
+static void test_slack() {
+  TimerManager tm;
+
+  s_fired.clear();
+  tm.set_slack(0);
+  tm.create_timer(0, record, tag(1));
+  tm.create_timer(100, record, tag(2));
+  tm.run();
+  CHECK(1 == s_fired.size());
+  tm.del_timer(record);
+
+  // Timers due within the slack run on the same wakeup.
+  s_fired.clear();
+  tm.set_slack(200);
+  tm.create_timer(0, record, tag(1));
+  tm.create_timer(100, record, tag(2));
+  tm.create_timer(1000, record, tag(3));
+  tm.run();
+  CHECK(2 == s_fired.size());
+
+  int span;
+
+  CHECK(!tm.next_time(span) && span > 500 && span <= 1000);
+}
+
+/*  bench - time the timer operations with n timers.
+ *
+ *  The timers are inserted with random due times, then deleted in
+ *  random order, then inserted again and expired.
+ */
+static void bench(TestRandom& rnd, unsigned n) {
+  TimerManager tm;
+  std::vector<TimerManager::TimerHandle> timers(n);
+  unsigned rounds = 1000000 / n;
+  double insert_time = 0;
+  double cancel_time = 0;
+  double expire_time = 0;
+
+  for (unsigned r = 0; r < rounds; ++r) {
+    double t0 = test_now();
+
+    for (auto& t : timers) {
+      t = tm.create_timer(rnd.below(10000) + 1000, record, nullptr);
+    }
+
+    double t1 = test_now();
+
+    for (unsigned i = n; i > 1; --i) {
+      std::swap(timers[i - 1], timers[rnd.below(i)]);
+    }
+
+    double t2 = test_now();
+
+    for (auto t : timers) {
+      tm.del_timer(t);
+    }
+
+    double t3 = test_now();
+
+    for (unsigned i = 0; i < n; ++i) {
+      tm.create_timer(0, record_other, nullptr);
+    }
+    s_fired.clear();
+
+    double t4 = test_now();
+
+    tm.run();
+
+    double t5 = test_now();
+
+    CHECK(n == s_fired.size());
+    insert_time += t1 - t0;
+    cancel_time += t3 - t2;
+    expire_time += t5 - t4;
+  }
+
+  double ops = static_cast<double>(rounds) * n / 1e9;
+
+  printf("%u timers: insert %.0f ns, cancel %.0f ns, expire %.0f ns\n", n,
+         insert_time / ops, cancel_time / ops, expire_time / ops);
+}
+
+int main(int argc, char** argv) {
+  uint64_t seed = argc > 1 ? strtoull(argv[1], nullptr, 0)
+                           : static_cast<uint64_t>(time(nullptr));
+  TestRandom rnd(seed);
+
+  printf("seed %llu\n", static_cast<unsigned long long>(seed));
+  test_order(rnd);
+  test_reschedule();
+  test_stale_handle();
+  test_slack();
+  for (unsigned n : {10, 100, 1000}) {
+    bench(rnd, n);
+  }
+
+  return test_result("timer_mgr_test");
+}
@@ -9,96 +9,177 @@
  */
 #include "timer_mgr.h"
 
+TimerManager::TimerManager() : m_seq{0}, m_slack{DEFAULT_SLACK} {}
+
 TimerManager::~TimerManager() { clear(); }
 
 void TimerManager::clear() {
-  LogList<Timer*>::iterator it;
+  for (auto t : m_timers) {
+    delete t;
+  }
+  m_timers.clear();
+  m_heap.clear();
+  m_free_timers.clear();
+}
 
-  for (it = m_timers.begin(); it != m_timers.end(); ++it) {
-    delete *it;
+TimerManager::Timer* TimerManager::get_timer(TimerHandle h) const {
+  if (h.m_slot >= m_timers.size()) {
+    return nullptr;
   }
 
-  m_timers.clear();
+  Timer* t = m_timers[h.m_slot];
+
+  return t->gen == h.m_gen && owns(t) ? t : nullptr;
 }
 
-int TimerManager::add_timer(unsigned interval, timer_callback cb, void* param) {
-  struct timespec tnow;
+TimerManager::Timer* TimerManager::alloc_timer() {
+  Timer* t;
 
-  if (-1 == clock_gettime(CLOCK_BOOTTIME, &tnow)) {
-    err_log("clock_gettime CLOCK_BOOTTIME error");
-    return -1;
+  if (m_free_timers.empty()) {
+    t = new Timer;
+    t->slot = static_cast<uint32_t>(m_timers.size());
+    t->gen = 1;
+    m_timers.push_back(t);
+  } else {
+    t = m_free_timers.back();
+    m_free_timers.pop_back();
   }
-  Timer* p = new Timer;
 
-  p->due_time = tnow + interval;
-  p->cb = cb;
-  p->param = param;
+  return t;
+}
 
-  insert_timer(p);
-  return 0;
+void TimerManager::free_timer(Timer* t) {
+  t->index = static_cast<size_t>(-1);
+  // The handles of the timer become stale. Generation 0 is the null
+  // handle.
+  if (!++t->gen) {
+    t->gen = 1;
+  }
+  m_free_timers.push_back(t);
+}
+
+bool TimerManager::earlier(const Timer* t1, const Timer* t2) {
+  if (t1->due_time < t2->due_time) {
+    return true;
+  }
+  if (t2->due_time < t1->due_time) {
+    return false;
+  }
+  return t1->seq < t2->seq;
+}
+
+void TimerManager::place(Timer* t, size_t i) {
+  m_heap[i] = t;
+  t->index = i;
 }
 
-TimerManager::Timer* TimerManager::create_timer(unsigned interval,
-                                                timer_callback cb,
-                                                void* param) {
+void TimerManager::sift_up(size_t i) {
+  Timer* t = m_heap[i];
+
+  while (i) {
+    size_t parent = (i - 1) / 2;
+
+    if (!earlier(t, m_heap[parent])) {
+      break;
+    }
+    place(m_heap[parent], i);
+    i = parent;
+  }
+  place(t, i);
+}
+
+void TimerManager::sift_down(size_t i) {
+  Timer* t = m_heap[i];
+  size_t n = m_heap.size();
+
+  while (true) {
+    size_t child = 2 * i + 1;
+
+    if (child >= n) {
+      break;
+    }
+    if (child + 1 < n && earlier(m_heap[child + 1], m_heap[child])) {
+      ++child;
+    }
+    if (!earlier(m_heap[child], t)) {
+      break;
+    }
+    place(m_heap[child], i);
+    i = child;
+  }
+  place(t, i);
+}
+
+int TimerManager::add_timer(unsigned interval, timer_callback cb, void* param) {
+  return create_timer(interval, cb, param) ? 0 : -1;
+}
+
+TimerManager::TimerHandle TimerManager::create_timer(unsigned interval,
+                                                      timer_callback cb,
+                                                      void* param) {
   struct timespec tnow;
 
   if (-1 == clock_gettime(CLOCK_BOOTTIME, &tnow)) {
-    return 0;
+    err_log("clock_gettime CLOCK_BOOTTIME error");
+    return TimerHandle{};
   }
-  Timer* p = new Timer;
+  Timer* p = alloc_timer();
 
   p->due_time = tnow + interval;
   p->cb = cb;
   p->param = param;
 
   insert_timer(p);
-  return p;
+  return TimerHandle{p->slot, p->gen};
 }
 
 void TimerManager::insert_timer(Timer* pt) {
-  LogList<Timer*>::iterator it;
+  pt->seq = m_seq++;
+  m_heap.push_back(pt);
+  sift_up(m_heap.size() - 1);
+}
 
-  for (it = m_timers.begin(); it != m_timers.end(); ++it) {
-    if (pt->due_time < (*it)->due_time) {
-      break;
+void TimerManager::remove_at(size_t i) {
+  Timer* last = m_heap.back();
+
+  m_heap.pop_back();
+  if (i < m_heap.size()) {
+    place(last, i);
+    if (i && earlier(last, m_heap[(i - 1) / 2])) {
+      sift_up(i);
+    } else {
+      sift_down(i);
     }
   }
-
-  m_timers.insert(it, pt);
 }
 
 void TimerManager::del_timer(timer_callback cb) {
-  LogList<Timer*>::iterator it = m_timers.begin();
+  size_t n = 0;
 
-  while (it != m_timers.end()) {
-    Timer* pt = *it;
+  for (size_t i = 0; i < m_heap.size(); ++i) {
+    Timer* pt = m_heap[i];
 
     if (pt->cb == cb) {
-      it = m_timers.erase(it);
-      delete pt;
+      free_timer(pt);
     } else {
-      ++it;
+      place(pt, n);
+      ++n;
     }
   }
-}
-
-LogList<TimerManager::Timer*>::iterator TimerManager::find(
-    TimerManager::Timer* t) {
-  LogList<Timer*>::iterator it;
 
-  for (it = m_timers.begin(); it != m_timers.end(); ++it) {
-    if (t == (*it)) {
-      break;
+  if (n < m_heap.size()) {
+    // Rebuild the heap
+    m_heap.resize(n);
+    for (size_t i = n / 2; i > 0; --i) {
+      sift_down(i - 1);
     }
   }
-
-  return it;
 }
 
-int TimerManager::set_new_due_time(TimerManager::Timer* t, unsigned interval) {
-  LogList<Timer*>::iterator it = find(t);
-  if (it == m_timers.end()) {
+int TimerManager::set_new_due_time(TimerHandle h, unsigned interval) {
+  Timer* t = get_timer(h);
+
+  if (!t) {
     return -1;
   }
 
@@ -108,28 +189,24 @@ int TimerManager::set_new_due_time(TimerManager::Timer* t, unsigned interval) {
     return -1;
   }
 
+  // Rescheduled timers go after the timers of the same due time.
+  remove_at(t->index);
   t->due_time = t_now + interval;
-  it = m_timers.erase(it);
-  while (it != m_timers.end()) {
-    if (t->due_time < (*it)->due_time) {
-      break;
-    }
-    ++it;
-  }
-  m_timers.insert(it, t);
+  insert_timer(t);
   return 0;
 }
 
-void TimerManager::del_timer(TimerManager::Timer* t) {
-  LogList<Timer*>::iterator it = find(t);
-  if (it != m_timers.end()) {
-    m_timers.erase(it);
-    delete t;
+void TimerManager::del_timer(TimerHandle h) {
+  Timer* t = get_timer(h);
+
+  if (t) {
+    remove_at(t->index);
+    free_timer(t);
   }
 }
 
 int TimerManager::next_time(int& time_span) const {
-  if (m_timers.empty()) {
+  if (m_heap.empty()) {
     time_span = -1;
     return 0;
   }
@@ -140,8 +217,7 @@ int TimerManager::next_time(int& time_span) const {
     return -1;
   }
 
-  LogList<Timer*>::const_iterator it = m_timers.begin();
-  const Timer* pt = *it;
+  const Timer* pt = m_heap.front();
   time_span = pt->due_time - tnow;
   if (time_span < 0) {
     time_span = 0;
@@ -149,8 +225,17 @@ int TimerManager::next_time(int& time_span) const {
   return 0;
 }
 
+int TimerManager::next_due_time(struct timespec& due) const {
+  if (m_heap.empty()) {
+    return -1;
+  }
+
+  due = m_heap.front()->due_time;
+  return 0;
+}
+
 void TimerManager::run() {
-  if (m_timers.empty()) {
+  if (m_heap.empty()) {
     return;
   }
 
@@ -160,15 +245,20 @@ void TimerManager::run() {
     return;
   }
 
-  while (!m_timers.empty()) {
-    Timer* p = m_timers.front();
+  // Run the timers due within the slack too, so that they don't
+  // need another wakeup.
+  struct timespec tlimit = tnow + static_cast<int>(m_slack);
+
+  while (!m_heap.empty()) {
+    Timer* p = m_heap.front();
 
-    if (tnow < p->due_time) {
+    if (tlimit < p->due_time) {
       break;
     }
-    m_timers.pop_front();
+    remove_at(0);
+    p->index = static_cast<size_t>(-1);
     p->cb(p->param);
-    delete p;
+    free_timer(p);
   }
 }
 
@@ -10,22 +10,65 @@
 #ifndef _TIMER_MGR_H_
 #define _TIMER_MGR_H_
 
+#include <cstddef>
+#include <stdint.h>
 #include <time.h>
+#include <vector>
 
 #include "cp_log_cmn.h"
 
+/*  TimerManager - one-shot timers of the event loop.
+ *
+ *  The timers are kept in a binary min-heap ordered by due time (and
+ *  by creation order for equal due times), and each Timer records its
+ *  position in the heap, so adding, deleting and rescheduling a timer
+ *  cost O(log n). Timer objects are recycled through a free list and
+ *  are only freed on destruction.
+ *
+ *  create_timer() returns a TimerHandle of {slot index, generation}.
+ *  The generation of a slot is advanced when its timer expires or is
+ *  deleted, so a stale handle never refers to the next timer of the
+ *  slot, and operations on stale handles are no-ops.
+ *
+ *  Timers due within the coalescing slack of the current time are run
+ *  on the same wakeup.
+ */
 class TimerManager {
  public:
   typedef void (*timer_callback)(void* param);
 
-  struct Timer {
-    struct timespec due_time;
-    timer_callback cb;
-    void* param;
+  /*  TimerHandle - the handle of a timer, or the null handle.
+   */
+  class TimerHandle {
+   public:
+    TimerHandle() : m_slot{0}, m_gen{0} {}
+    TimerHandle(std::nullptr_t) : m_slot{0}, m_gen{0} {}
+
+    explicit operator bool() const { return m_gen; }
+    bool operator==(const TimerHandle& h) const {
+      return m_slot == h.m_slot && m_gen == h.m_gen;
+    }
+    bool operator!=(const TimerHandle& h) const { return !(*this == h); }
+
+   private:
+    friend class TimerManager;
+
+    TimerHandle(uint32_t slot, uint32_t gen) : m_slot{slot}, m_gen{gen} {}
+
+    uint32_t m_slot;
+    // Generation of the slot, 0 for the null handle
+    uint32_t m_gen;
   };
 
+  TimerManager();
   ~TimerManager();
 
+  /*  set_slack - set the coalescing slack.
+   *  @slack: timers due within slack milliseconds from now are run
+   *          together with the due timers.
+   */
+  void set_slack(unsigned slack) { m_slack = slack; }
+
   /*  add_timer - create an one-shot timer and add it to the timer
    *              list.
    *  @interval: timer interval in millisecond.
@@ -42,25 +85,29 @@ class TimerManager {
    *  @cb: timer callback function.
    *  @param: parameter to pass to the callback function.
    *
-   *  Return the timer object pointer on success, NULL on error.
+   *  Return the timer handle on success, the null handle on error.
    */
-  Timer* create_timer(unsigned interval, timer_callback cb, void* param);
+  TimerHandle create_timer(unsigned interval, timer_callback cb, void* param);
 
   /*  del_timer - delete a timer.
    *  @cb: the timer callback function.
    */
   void del_timer(timer_callback cb);
 
-  void del_timer(Timer* t);
+  /*  del_timer - delete a timer.
+   *  @h: the timer handle. Null and stale handles are ignored.
+   */
+  void del_timer(TimerHandle h);
 
   /*  set_new_due_time - update the due time of the timer.
-   *  @t: the Timer pointer
+   *  @h: the timer handle.
    *  @interval: the new due time shall be set to the current
    *             time plus interval.
    *
-   *  Return 0 on success, -1 on error.
+   *  Return 0 on success, -1 if the handle is null or stale or on
+   *  error.
    */
-  int set_new_due_time(Timer* t, unsigned interval);
+  int set_new_due_time(TimerHandle h, unsigned interval);
 
   /*  run - process the timers.
    *
@@ -79,11 +126,56 @@ class TimerManager {
    */
   int next_time(int& time_span) const;
 
+  /*  next_due_time - get the next due time (CLOCK_BOOTTIME).
+   *  @due: the function will put the next due time in the variable.
+   *
+   *  Return 0 on success, -1 if there is no timer.
+   */
+  int next_due_time(struct timespec& due) const;
+
  private:
-  LogList<Timer*> m_timers;
+  // Default coalescing slack in millisecond
+  static const unsigned DEFAULT_SLACK = 5;
+
+  struct Timer {
+    struct timespec due_time;
+    timer_callback cb;
+    void* param;
+    // Position in m_heap
+    size_t index;
+    // Creation sequence number to keep FIFO order of equal due times
+    uint64_t seq;
+    // Position in m_timers
+    uint32_t slot;
+    // Generation of the slot, advanced when the timer is freed
+    uint32_t gen;
+  };
 
-  LogList<Timer*>::iterator find(Timer* t);
+  // All Timer objects, indexed by the slot
+  std::vector<Timer*> m_timers;
+  std::vector<Timer*> m_heap;
+  std::vector<Timer*> m_free_timers;
+  uint64_t m_seq;
+  unsigned m_slack;
+
+  // Whether t is an active timer
+  bool owns(const Timer* t) const {
+    return t && t->index < m_heap.size() && m_heap[t->index] == t;
+  }
+  /*  get_timer - get the active timer of the handle.
+   *
+   *  Return nullptr if the handle is null or stale, or if the timer is
+   *  running its callback.
+   */
+  Timer* get_timer(TimerHandle h) const;
+  Timer* alloc_timer();
+  void free_timer(Timer* t);
+  static bool earlier(const Timer* t1, const Timer* t2);
+  void place(Timer* t, size_t i);
+  void sift_up(size_t i);
+  void sift_down(size_t i);
   void insert_timer(Timer* pt);
+  void remove_at(size_t i);
   void clear();
 };
 
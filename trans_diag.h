@@ -33,8 +33,8 @@ class TransDiagDevice : public TransModem {
    *  @buffer: data buffer.
    *
    *  Return Value:
-   *    If the transaction is finished, return true; otherwise return
-   *    false.
+   *    If the transaction is finished or the device shall not be read
+   *    for now, return true; otherwise return false.
    */
   virtual bool process(DataBuffer& buffer) = 0;
 
@@ -105,17 +105,14 @@ bool TransDumpReceiver::process(DataBuffer& buffer) {
 
   TimerManager& tmgr = diag_handler()->multiplexer()->timer_mgr();
 
-  ssize_t n = 0;
-  LogFile* f = dump_file();
   bool fail{};
 
-  if (f) {
-    n = f->write(buffer.buffer + buffer.data_start, buffer.data_len);
-    if (static_cast<size_t>(n) != buffer.data_len) {  // Write file failed.
+  if (dump_file()) {
+    if (write_dump(buffer.buffer + buffer.data_start, buffer.data_len)) {
+      // Write file failed.
       remove_dump_file();
-      err_log("need to write %lu, write returns %d",
-              static_cast<unsigned long>(buffer.data_len),
-              static_cast<int>(n));
+      err_log("write %lu bytes to dump file failed",
+              static_cast<unsigned long>(buffer.data_len));
       fail = true;
     }
   } else {  // The file has been removed.
@@ -124,6 +121,11 @@ bool TransDumpReceiver::process(DataBuffer& buffer) {
     fail = true;
   }
 
+  if (!fail && found && close_dump_file()) {
+    err_log("dump file incomplete");
+    fail = true;
+  }
+
   if (fail) {
     tmgr.del_timer(m_timer);
     m_timer = nullptr;
@@ -140,7 +142,6 @@ bool TransDumpReceiver::process(DataBuffer& buffer) {
       tmgr.del_timer(m_timer);
       m_timer = nullptr;
 
-      close_dump_file();
       storage().unsubscribe_stor_inactive_evt(this);
 
       subsys()->stop_diag_trans();
@@ -148,6 +149,9 @@ bool TransDumpReceiver::process(DataBuffer& buffer) {
       finish(TRANS_R_SUCCESS);
       info_log("dump complete");
       ret = true;
+    } else if (dump_throttled()) {
+      // Stop reading until the queued data is written.
+      ret = true;
     }
   }
 
@@ -164,8 +168,9 @@ void TransDumpReceiver::dump_read_check(void* param) {
     dump->on_going_cb_(dump->client_);
   }
 
-  // Check whether silent period is too long.
-  if (dump->dump_ongoing_) {
+  // Check whether silent period is too long. The MODEM is not silent
+  // when the diag device is not read because of slow storage.
+  if (dump->dump_ongoing_ || dump->dump_throttled()) {
     dump->silent_wins_ = 0;
   } else {
     ++dump->silent_wins_;
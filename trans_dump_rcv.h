@@ -69,7 +69,7 @@ class TransDumpReceiver : public TransCpDump {
   static void dump_read_check(void* param);
 
  private:
-  TimerManager::Timer* m_timer;
+  TimerManager::TimerHandle m_timer;
   DiagStreamParser parser_;
   const char* m_end_of_content;
   size_t m_end_content_size;
@@ -34,7 +34,7 @@ class TransIntWcnLogCollect : public TransGlobal {
 
  private:
   IntWcnLogHandler* int_wcn_;
-  TimerManager::Timer* dump_timer_;
+  TimerManager::TimerHandle dump_timer_;
 };
 
 #endif  // !TRANS_INT_WCN_COL_H_
@@ -32,7 +32,7 @@ class TransModemLastLog : public TransModem {
 
  private:
   WanModemLogHandler* wan_modem_;
-  TimerManager::Timer* last_log_timer_;
+  TimerManager::TimerHandle last_log_timer_;
 };
 
 #endif  // !TRANS_LAST_LOG_H_
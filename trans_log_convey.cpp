@@ -14,11 +14,13 @@
 
 TransLogConvey::TransLogConvey(TransactionManager* tmgr,
                                TransModem::Type type,
-                               ConveyWorkshop* workshop)
+                               ConveyWorkshop* workshop,
+                               ConveyUnitBase::Priority prio)
     : TransModem{tmgr, type},
       workshop_{workshop},
       item_num_{0},
-      fail_num_{0} {}
+      fail_num_{0},
+      priority_{prio} {}
 
 TransLogConvey::~TransLogConvey() {
   TransLogConvey::cancel();
@@ -27,6 +29,7 @@ TransLogConvey::~TransLogConvey() {
 void TransLogConvey::add_units(LogVector<std::unique_ptr<ConveyUnitBase>>& items) {
   for (auto it = items.begin(); it != items.end(); ++it) {
     auto item = std::move(*it);
+    item->set_priority(priority_);
 
     if (item->auto_dest()) {
       if (false == item->pre_convey()) {
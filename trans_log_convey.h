@@ -14,16 +14,17 @@
 
 #include <memory>
 
+#include "convey_unit_base.h"
 #include "cp_log_cmn.h"
 #include "trans_modem.h"
 
-class ConveyUnitBase;
 class ConveyWorkshop;
 
 class TransLogConvey : public TransModem {
  public:
   TransLogConvey(TransactionManager* tmgr, TransModem::Type type,
-                 ConveyWorkshop* workshop);
+                 ConveyWorkshop* workshop,
+                 ConveyUnitBase::Priority prio = ConveyUnitBase::Background);
   TransLogConvey(const TransLogConvey&) = delete;
   ~TransLogConvey();
   TransLogConvey& operator=(const TransLogConvey&) = delete;
@@ -45,6 +46,8 @@ class TransLogConvey : public TransModem {
   LogList<std::unique_ptr<ConveyUnitBase>> trans_list_;
   unsigned item_num_;
   unsigned fail_num_;
+  // scheduling class of the units
+  ConveyUnitBase::Priority priority_;
 };
 
 #endif //!_TRANS_LOG_CONVEY_
@@ -36,7 +36,7 @@ class TransModemLogCollect : public TransModem {
  private:
   WanModemLogHandler* wan_modem_;
   TransLogConvey* modem_convey_;
-  TimerManager::Timer* last_collect_timer_;
+  TimerManager::TimerHandle last_collect_timer_;
 };
 
 #endif  // !TRANS_MODEM_COL_H_
@@ -52,7 +52,7 @@ class TransWanModemVerQuery : public TransDiagDevice {
   // Failed times
   int m_failed_times;
   // Version query timeout
-  TimerManager::Timer* m_timer;
+  TimerManager::TimerHandle m_timer;
   // MODEM version
   size_t m_ver_len;
   char* m_modem_ver;
@@ -59,7 +59,7 @@ class TransOrcaEtb : public TransCpDump {
 
    private:
     struct tm time_;
-    TimerManager::Timer* m_timer;
+    TimerManager::TimerHandle m_timer;
     DiagStreamParser parser_;
     const char* prefix_;
     CpStateHandler::CpEvent evt_;
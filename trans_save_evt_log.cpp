@@ -37,6 +37,7 @@ TransSaveEventLog::TransSaveEventLog(WanModemLogHandler* wan,
      time_alignment_{0x12345678, 0, 0, 0},
      read_timer_{},
      idle_timer_{},
+     writer_{kDataBufSize},
      at_finished_{},
      at_result_{},
      data_finished_{},
@@ -70,8 +71,9 @@ int TransSaveEventLog::execute() {
     return TRANS_E_SUCCESS;
   }
 
+  writer_.open(f, storage_.io_channel(), this);
   if (has_ta_) {
-    f->write(&time_alignment_, sizeof time_alignment_);
+    writer_.write(&time_alignment_, sizeof time_alignment_);
   }
 
   // Get ready for the diag data
@@ -116,7 +118,19 @@ std::weak_ptr<LogFile> TransSaveEventLog::create_file() {
   return storage_.create_file(fn, LogFile::LT_UNKNOWN);
 }
 
+int TransSaveEventLog::close_file() {
+  int ret = writer_.close();
+
+  if (auto f = evt_file_.lock()) {
+    f->close();
+    evt_file_.reset();
+  }
+
+  return ret;
+}
+
 void TransSaveEventLog::close_rm_file() {
+  writer_.discard();
   if (auto f = evt_file_.lock()) {
     f->close();
     f->dir()->remove(f);
@@ -188,12 +202,9 @@ bool TransSaveEventLog::process_data(DataBuffer& buffer) {
   uint8_t* p = buffer.buffer + buffer.data_start;
   size_t dlen = buffer.data_len;
 
-  auto f = evt_file_.lock();
-  if (f) {
-    ssize_t nw = f->write(p, dlen);
-    if (static_cast<size_t>(nw) != dlen) {  // Write error
-      err_log("write event log file error %d",
-              static_cast<int>(nw));
+  if (!evt_file_.expired()) {
+    if (writer_.write(p, dlen)) {  // Write error
+      err_log("write event log file error");
       close_rm_file();
       data_finished_ = true;
     } else {
@@ -201,11 +212,7 @@ bool TransSaveEventLog::process_data(DataBuffer& buffer) {
           find_str(p, dlen,
                    reinterpret_cast<const uint8_t*>("EVT LOG END"),
                    11)) {
-        data_ok_ = true;
-
-        f->close();
-        evt_file_.reset();
-
+        data_ok_ = !close_file();
         data_finished_ = true;
       }
     }
@@ -236,16 +243,23 @@ bool TransSaveEventLog::process_data(DataBuffer& buffer) {
     }
   }
 
-  return data_finished_;
+  // Stop reading until the queued data is written.
+  return data_finished_ || writer_.throttled();
 }
 
 void TransSaveEventLog::evt_log_read_timeout(void* param) {
   TransSaveEventLog* evt_log = static_cast<TransSaveEventLog*>(param);
+  TimerManager& tmgr = evt_log->wan_modem_->multiplexer()->timer_mgr();
 
-  // Stop all timers
   evt_log->read_timer_ = nullptr;
+  if (evt_log->writer_.throttled()) {
+    // The log device is not read because of slow storage.
+    evt_log->read_timer_ = tmgr.create_timer(1500, evt_log_read_timeout,
+                                             evt_log);
+    return;
+  }
 
-  TimerManager& tmgr = evt_log->wan_modem_->multiplexer()->timer_mgr();
+  // Stop all timers
   tmgr.del_timer(evt_log->idle_timer_);
   evt_log->idle_timer_ = nullptr;
 
@@ -254,11 +268,17 @@ void TransSaveEventLog::evt_log_read_timeout(void* param) {
 
 void TransSaveEventLog::data_idle_timeout(void* param) {
   TransSaveEventLog* evt_log = static_cast<TransSaveEventLog*>(param);
+  TimerManager& tmgr = evt_log->wan_modem_->multiplexer()->timer_mgr();
 
-  // Stop all timers
   evt_log->idle_timer_ = nullptr;
+  if (evt_log->writer_.throttled()) {
+    // The log device is not read because of slow storage.
+    evt_log->idle_timer_ = tmgr.create_timer(1000, data_idle_timeout,
+                                             evt_log);
+    return;
+  }
 
-  TimerManager& tmgr = evt_log->wan_modem_->multiplexer()->timer_mgr();
+  // Stop all timers
   tmgr.del_timer(evt_log->read_timer_);
   evt_log->read_timer_ = nullptr;
 
@@ -266,10 +286,7 @@ void TransSaveEventLog::data_idle_timeout(void* param) {
 }
 
 void TransSaveEventLog::on_timeout() {
-  if (auto f = evt_file_.lock()) {
-    f->close();
-    evt_file_.reset();
-  }
+  close_file();
   data_finished_ = true;
 
   if (log_size_) {
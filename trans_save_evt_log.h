@@ -12,6 +12,7 @@
 #ifndef TRANS_SAVE_EVT_LOG_H_
 #define TRANS_SAVE_EVT_LOG_H_
 
+#include "async_file_wr.h"
 #include "dev_file_hdl.h"
 #include "modem_at_ctrl.h"
 #include "timer_mgr.h"
@@ -50,6 +51,11 @@ class TransSaveEventLog : public TransModem,
   };
 
   std::weak_ptr<LogFile> create_file();
+  /*  close_file - write the queued data and close the file.
+   *
+   *  Return 0 if all data is written, -1 otherwise.
+   */
+  int close_file();
   void close_rm_file();
   int send_command();
 
@@ -75,10 +81,11 @@ class TransSaveEventLog : public TransModem,
   modem_timestamp time_alignment_;
   //DiagStreamParser parser_;
   // The timer for max read time
-  TimerManager::Timer* read_timer_;
+  TimerManager::TimerHandle read_timer_;
   // Data idle timer
-  TimerManager::Timer* idle_timer_;
+  TimerManager::TimerHandle idle_timer_;
   std::weak_ptr<LogFile> evt_file_;
+  AsyncFileWriter writer_;
   bool at_finished_;
   int at_result_;
   // Data export finished
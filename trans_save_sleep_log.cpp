@@ -62,16 +62,18 @@ int TransSaveSleepLog::execute() {
 
 int TransSaveSleepLog::start() {
   m_file = open_file();
-  if (0 == m_file.use_count()) {
+  auto f = m_file.lock();
+  if (!f) {
     return -1;
   }
+  m_writer.open(f, storage_.io_channel(), diag_handler());
 
-  uint8_t* buf;
-  size_t len;
-  parser_.frame(DIAG_READ_SLEEP_LOG, DIAG_REQ_SLEEP_LOG, NULL, 0, &buf, &len);
+  uint8_t buf[32];
+  size_t len = DiagStreamParser::frame(DIAG_READ_SLEEP_LOG,
+                                       DIAG_REQ_SLEEP_LOG, nullptr, 0,
+                                       buf, sizeof buf);
   DiagDeviceHandler* dev = diag_handler();
   ssize_t n = write(dev->fd(), buf, len);
-  delete[] buf;
   if (static_cast<size_t>(n) != len) {
     close_rm_file();
     return -1;
@@ -107,21 +109,16 @@ bool TransSaveSleepLog::process(DataBuffer& buffer) {
         if (DIAG_RSP_SLEEP_LOG_OK == subtype) {
           tmgr.del_timer(m_timer);
           m_timer = nullptr;
-          close_file();
+          int res = close_file() ? TRANS_R_FAILURE : TRANS_R_SUCCESS;
           wan_modem_->stop_diag_trans();
-          finish(TRANS_R_SUCCESS);
+          finish(res);
           ret = true;
           break;
         } else if (DIAG_DATA_SLEEP_LOG == subtype) {
           uint8_t* data_ptr = parser_.get_payload(dst_ptr);
           size_t data_len = dst_len - parser_.get_head_size();
-          auto f = m_file.lock();
-          ssize_t n = 0;
-          if (f) {
-            n = f->write(data_ptr, data_len);
-          }
 
-          if (static_cast<size_t>(n) != data_len) {
+          if (m_file.expired() || m_writer.write(data_ptr, data_len)) {
             tmgr.del_timer(m_timer);
             m_timer = nullptr;
             close_rm_file();
@@ -153,16 +150,24 @@ bool TransSaveSleepLog::process(DataBuffer& buffer) {
   if (!ret) {
     buffer.data_start = 0;
     buffer.data_len = 0;
+    // Stop reading until the queued data is written.
+    ret = m_writer.throttled();
   }
   return ret;
 }
 
 void TransSaveSleepLog::sleep_log_read_timeout(void* param) {
-  err_log("read sleep log timeout");
-
   TransSaveSleepLog* trans = static_cast<TransSaveSleepLog*>(param);
 
   trans->m_timer = nullptr;
+  if (trans->m_writer.throttled()) {
+    // The diag device is not read because of slow storage.
+    TimerManager& tmgr = trans->diag_handler()->multiplexer()->timer_mgr();
+    trans->m_timer = tmgr.create_timer(3000, sleep_log_read_timeout, trans);
+    return;
+  }
+
+  err_log("read sleep log timeout");
   trans->close_file();
   trans->wan_modem_->stop_diag_trans();
   trans->finish(TRANS_R_FAILURE);
@@ -210,14 +215,19 @@ std::weak_ptr<LogFile> TransSaveSleepLog::open_file() {
   return f;
 }
 
-void TransSaveSleepLog::close_file() {
+int TransSaveSleepLog::close_file() {
+  int ret = m_writer.close();
+
   if (auto f = m_file.lock()) {
     f->close();
     m_file.reset();
   }
+
+  return ret;
 }
 
 void TransSaveSleepLog::close_rm_file() {
+  m_writer.discard();
   if (auto f = m_file.lock()) {
     f->close();
     f->dir()->remove(f);
@@ -14,6 +14,7 @@
 
 #include <memory>
 
+#include "async_file_wr.h"
 #include "diag_stream_parser.h"
 #include "timer_mgr.h"
 #include "trans_diag.h"
@@ -41,7 +42,11 @@ class TransSaveSleepLog : public TransDiagDevice {
  private:
   int start();
   std::weak_ptr<LogFile> open_file();
-  void close_file();
+  /*  close_file - write the queued data and close the file.
+   *
+   *  Return 0 if all data is written, -1 otherwise.
+   */
+  int close_file();
   void close_rm_file();
 
   static void sleep_log_read_timeout(void* param);
@@ -50,8 +55,9 @@ class TransSaveSleepLog : public TransDiagDevice {
   WanModemLogHandler* wan_modem_;
   CpStorage& storage_;
   DiagStreamParser parser_;
-  TimerManager::Timer* m_timer;
+  TimerManager::TimerHandle m_timer;
   std::weak_ptr<LogFile> m_file;
+  AsyncFileWriter m_writer;
 };
 
 #endif  // !TRANS_SAVE_SLEEP_LOG_H_
@@ -35,7 +35,7 @@ class TransWcnLastLog : public TransGlobal {
  private:
   LogController* log_ctrl_;
   LogPipeHandler* wcn_;
-  TimerManager::Timer* last_log_timer_;
+  TimerManager::TimerHandle last_log_timer_;
 };
 
 #endif  // !TRANS_WCN_LAST_LOG_H_
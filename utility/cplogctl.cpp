@@ -26,6 +26,8 @@
  *      <subsys> may only be 5mode or wcdma. <subsysn> may be 5mode,
  *      wcn, gnss, pmsh or agdsp.
  *    flush  (no arguments)
+ *    getbufgeometry <subsys>
+ *      <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.
  *    getstor  (no arguments)
  *    getcpcapacity <subsys> <storage>
  *      <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.
@@ -42,6 +44,10 @@
  *      save last modem log.
  *    setagpcm <enable>
  *      <enable> may be on or off.
+ *    setbufgeometry <subsys> <buf size> <buf num> <log commit>
+ *                   <buf commit>
+ *      <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.
+ *      sizes are in bytes. 0 keeps the current value.
  *    setcpcapacity <subsys> <storage> <size>
  *      <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.
  *      <storage> maybe internal, external
@@ -71,6 +77,7 @@
 #include "cplogctl_cmn.h"
 #include "en_evt_req.h"
 #include "flush_req.h"
+#include "get_buf_geometry.h"
 #include "get_cp_max_size.h"
 #include "get_log_file_size.h"
 #include "get_mipi_log.h"
@@ -82,6 +89,7 @@
 #include "save_last_log_req.h"
 #include "set_ag_log_dest.h"
 #include "set_ag_pcm.h"
+#include "set_buf_geometry.h"
 #include "set_cp_max_size.h"
 #include "set_log_file_size.h"
 #include "set_mini_ap.h"
@@ -116,6 +124,15 @@ void usage() {
           "  flush  (no arguments)\n"
           "    flush all buffered logs.\n"
           "\n"
+          "  getbufgeometry <subsys>\n"
+          "    get the log buffer geometry of specified subsystem.\n"
+          "    <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.\n"
+          "    query result format:\n"
+          "      buffer size: <size> bytes\n"
+          "      buffer number: <num>\n"
+          "      log commit threshold: <size> bytes\n"
+          "      buffer commit threshold: <size> bytes\n"
+          "\n"
           "  getcpcapacity <subsys> <storage>\n"
           "    get max size of specified subsystem for log saving.\n"
           "    <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.\n"
@@ -155,6 +172,16 @@ void usage() {
           "    enable/disable AG-DSP PCM dump.\n"
           "    <enable> may be on or off.\n"
           "\n"
+          "  setbufgeometry <subsys> <buf size> <buf num> <log commit> "
+          "<buf commit>\n"
+          "    set the log buffer geometry of specified subsystem.\n"
+          "    <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.\n"
+          "    <buf size> is the size of one buffer in bytes.\n"
+          "    <buf num> is the number of buffers.\n"
+          "    <log commit> is the data size in bytes to start a write.\n"
+          "    <buf commit> is the data size in bytes to queue a buffer.\n"
+          "    0 keeps the current value.\n"
+          "\n"
           "  setcpcapacity <subsys> <storage> <size>\n"
           "    set max size of specified subsystem for log saving.\n"
           "    <subsys> may be 5mode, wcn, gnss, pmsh or agdsp.\n"
@@ -258,6 +285,53 @@ SlogmRequest* proc_set_file_size(char** argv, int argc) {
   return set_size;
 }
 
+SlogmRequest* proc_set_buf_geometry(char** argv, int argc) {
+  if (5 != argc) {
+    fprintf(stderr, "invalid parameters\n");
+    usage();
+    return nullptr;
+  }
+
+  LogVector<CpType> types;
+
+  if (parse_subsys(argv, 1, types)) {
+    fprintf(stderr, "wrong cp name provided\n");
+    return nullptr;
+  }
+
+  unsigned vals[4];
+
+  for (int i = 0; i < 4; ++i) {
+    unsigned long n;
+    const char* endp;
+
+    if (!non_negative_number(argv[i + 1], n, endp) || !spaces_only(endp)) {
+      fprintf(stderr, "invalid parameter %s\n", argv[i + 1]);
+      usage();
+      return nullptr;
+    }
+    vals[i] = static_cast<unsigned>(n);
+  }
+
+  return new SetBufGeometry{types[0], vals[0], vals[1], vals[2], vals[3]};
+}
+
+SlogmRequest* proc_get_buf_geometry(char** argv, int argc) {
+  if (1 != argc) {
+    fprintf(stderr, "Invalid command argument\n");
+    return nullptr;
+  }
+
+  LogVector<CpType> types;
+
+  if (parse_subsys(argv, argc, types)) {
+    fprintf(stderr, "wrong cp name provided\n");
+    return nullptr;
+  }
+
+  return new GetBufGeometry{types[0]};
+}
+
 SlogmRequest* proc_set_cp_max_size(char** argv, int argc) {
   if (3 != argc) {
     fprintf(stderr, "invalid parameters\n");
@@ -679,6 +753,8 @@ int main(int argc, char** argv) {
     } else {
       req = new FlushRequest;
     }
+  } else if (!strcmp(argv[1], "getbufgeometry")) {
+    req = proc_get_buf_geometry(argv + 2, argc - 2);
   } else if (!strcmp(argv[1], "getcpcapacity")) {
     req = proc_get_cp_max_size(argv + 2, argc - 2);
   } else if (!strcmp(argv[1], "getfilesize")) {
@@ -699,6 +775,8 @@ int main(int argc, char** argv) {
     req = proc_agdsp_log_dest(argv + 2, argc - 2);
   } else if (!strcmp(argv[1], "setagpcm")) {
     req = proc_agdsp_pcm(argv + 2, argc - 2);
+  } else if (!strcmp(argv[1], "setbufgeometry")) {
+    req = proc_set_buf_geometry(argv + 2, argc - 2);
   } else if (!strcmp(argv[1], "setcpcapacity")) {
     req = proc_set_cp_max_size(argv + 2, argc - 2);
   } else if (!strcmp(argv[1], "setfilesize")) {
@@ -0,0 +1,183 @@
+/*
+ *  cplogunpack.cpp - decompress the compressed CP log files on the host.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "log_frame.h"
+
+/*  read_file - read the whole file into data.
+ *
+ *  Return 0 on success, -1 on failure.
+ */
+static int read_file(const char* path, std::vector<uint8_t>& data) {
+  FILE* pf = fopen(path, "rb");
+
+  if (!pf) {
+    fprintf(stderr, "can not open %s\n", path);
+    return -1;
+  }
+
+  uint8_t buf[1024 * 64];
+  size_t n;
+
+  while ((n = fread(buf, 1, sizeof buf, pf)) > 0) {
+    data.insert(data.end(), buf, buf + n);
+  }
+
+  int ret = ferror(pf) ? -1 : 0;
+  if (ret) {
+    fprintf(stderr, "read %s error\n", path);
+  }
+  fclose(pf);
+
+  return ret;
+}
+
+/*  frame_at - check whether a complete frame starts at pos.
+ */
+static bool frame_at(const std::vector<uint8_t>& data, size_t pos,
+                     LogFrameHeader& hdr) {
+  if (data.size() - pos < sizeof hdr) {
+    return false;
+  }
+  memcpy(&hdr, data.data() + pos, sizeof hdr);
+
+  return valid_frame_header(hdr) &&
+         data.size() - pos - sizeof hdr >= hdr.data_len;
+}
+
+/*  next_frame - find the next frame from pos.
+ *
+ *  Return the position of the frame, data.size() if there is none.
+ */
+static size_t next_frame(const std::vector<uint8_t>& data, size_t pos) {
+  LogFrameHeader hdr;
+
+  while (pos < data.size() && !frame_at(data, pos, hdr)) {
+    ++pos;
+  }
+
+  return pos;
+}
+
+static void usage() {
+  fprintf(stderr,
+          "Usage: cplogunpack <compressed log> <output file>\n"
+          "  Decompress the log file written by slogmodem in the\n"
+          "  compressed mode. The output is the same as the log file\n"
+          "  written without compression. Corrupted frames are skipped.\n");
+}
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    usage();
+    return 1;
+  }
+
+  std::vector<uint8_t> data;
+  if (read_file(argv[1], data)) {
+    return 1;
+  }
+
+  LogFileHeader fhdr;
+  if (data.size() < sizeof fhdr) {
+    fprintf(stderr, "%s is not a compressed log file\n", argv[1]);
+    return 1;
+  }
+  memcpy(&fhdr, data.data(), sizeof fhdr);
+  if (LOG_FILE_MAGIC != fhdr.magic || fhdr.header_len < sizeof fhdr ||
+      fhdr.header_len > data.size()) {
+    fprintf(stderr, "%s is not a compressed log file\n", argv[1]);
+    return 1;
+  }
+  if (fhdr.version > LOG_FILE_VERSION) {
+    fprintf(stderr, "unsupported version %u\n",
+            static_cast<unsigned>(fhdr.version));
+    return 1;
+  }
+
+  FILE* out = fopen(argv[2], "wb");
+  if (!out) {
+    fprintf(stderr, "can not create %s\n", argv[2]);
+    return 1;
+  }
+
+  // The prologue is kept raw. If the start of the frames is not
+  // recorded, the prologue ends at the first frame.
+  size_t pos = fhdr.header_len;
+  size_t data_start = fhdr.data_start;
+  LogFrameHeader hdr;
+
+  if (data_start < pos || data_start > data.size() ||
+      (data_start < data.size() && !frame_at(data, data_start, hdr))) {
+    data_start = next_frame(data, pos);
+  }
+
+  int ret = 0;
+  unsigned long long raw_total = data_start - pos;
+  unsigned long long skipped = 0;
+  unsigned frames = 0;
+  unsigned bad_frames = 0;
+  std::vector<uint8_t> raw(LOG_FRAME_MAX_RAW);
+
+  if (fwrite(data.data() + pos, 1, data_start - pos, out) !=
+      data_start - pos) {
+    ret = -1;
+  }
+  pos = data_start;
+
+  while (!ret && pos < data.size()) {
+    if (!frame_at(data, pos, hdr)) {
+      // Truncated or corrupted: resynchronize on the next frame.
+      size_t next = next_frame(data, pos + 1);
+      skipped += next - pos;
+      pos = next;
+      continue;
+    }
+
+    const uint8_t* payload = data.data() + pos + sizeof hdr;
+    const uint8_t* p = payload;
+    ssize_t len = hdr.raw_len;
+
+    if (hdr.data_len < hdr.raw_len) {
+      len = Lz4Block::decompress(payload, hdr.data_len, raw.data(),
+                                 hdr.raw_len);
+      p = raw.data();
+    }
+    if (len != static_cast<ssize_t>(hdr.raw_len)) {
+      ++bad_frames;
+      skipped += sizeof hdr + hdr.data_len;
+    } else if (fwrite(p, 1, len, out) != static_cast<size_t>(len)) {
+      ret = -1;
+    } else {
+      ++frames;
+      raw_total += len;
+    }
+    pos += sizeof hdr + hdr.data_len;
+  }
+
+  if (fclose(out) || ret) {
+    fprintf(stderr, "write %s error\n", argv[2]);
+    return 1;
+  }
+
+  fprintf(stderr, "%u frames, %llu bytes -> %llu bytes (%.1f%%)\n",
+          frames, static_cast<unsigned long long>(data.size()), raw_total,
+          raw_total ? data.size() * 100.0 / raw_total : 100.0);
+  if (skipped || bad_frames) {
+    fprintf(stderr, "%u corrupted frames, %llu bytes skipped\n",
+            bad_frames, skipped);
+    return 2;
+  }
+
+  return 0;
+}
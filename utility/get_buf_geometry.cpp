@@ -0,0 +1,113 @@
+/*
+ *  get_buf_geometry.cpp - get the log buffer geometry of a subsystem.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#include "cplogctl_cmn.h"
+#include "get_buf_geometry.h"
+
+GetBufGeometry::GetBufGeometry(CpType type)
+    : type_{type} {}
+
+int GetBufGeometry::do_request() {
+  // GET_BUF_GEOMETRY <cp_name>\n
+  uint8_t buf[48];
+
+  memcpy(buf, "GET_BUF_GEOMETRY ", 17);
+
+  uint8_t* p = buf + 17;
+  size_t rlen = sizeof buf - 17;
+  size_t tlen = 0;
+  int err = put_cp_type(p, rlen, type_, tlen);
+
+  if (err || (rlen == tlen)) {
+    fprintf(stderr,
+            "Can not make the subsystem parameter of GET_BUF_GEOMETRY\n");
+    return -1;
+  }
+
+  p += tlen;
+  *p = '\n';
+  err = send_req(buf, tlen + 18);
+
+  if (err) {
+    report_error(RE_SEND_CMD_ERROR);
+    return -1;
+  }
+
+  return parse_query_result();
+}
+
+int GetBufGeometry::parse_query_result() {
+  char resp[SLOGM_RSP_LENGTH];
+  size_t rlen = SLOGM_RSP_LENGTH;
+
+  int ret = wait_response(resp, rlen, DEFAULT_RSP_TIME);
+
+  if (ret) {
+    report_error(RE_WAIT_RSP_ERROR);
+    return -1;
+  }
+
+  ResponseErrorCode err_code;
+  const void* stop_ptr;
+
+  ret = parse_result(resp, rlen, err_code, stop_ptr);
+  if (ret) {
+    LogString sd;
+
+    str_assign(sd, resp, rlen);
+    fprintf(stderr, "Invalid response: %s\n", ls2cstring(sd));
+    err_log("invalid response: %s", ls2cstring(sd));
+    return -1;
+  }
+
+  if (REC_SUCCESS != err_code) {
+    const char* err_str = resp_code_to_string(err_code);
+    fprintf(stderr, "Error: %d(%s)\n", static_cast<int>(err_code),
+            err_str);
+    err_log("error: %d(%s)", static_cast<int>(err_code), err_str);
+    return -1;
+  }
+
+  // OK <buf size> <buf num> <log commit> <buf commit>
+  static const char* const kFieldNames[] = {
+      "buffer size", "buffer number", "log commit threshold",
+      "buffer commit threshold"};
+  static const char* const kFieldUnits[] = {" bytes", "", " bytes",
+                                            " bytes"};
+  const char* res = static_cast<const char*>(stop_ptr);
+  size_t res_len = static_cast<size_t>(rlen - (res - &resp[0]));
+  LogString str_res;
+  unsigned long vals[4];
+
+  str_assign(str_res, res, res_len);
+
+  const char* s = ls2cstring(str_res);
+  for (auto& val : vals) {
+    const char* endp;
+
+    if (!non_negative_number(s, val, endp)) {
+      fprintf(stderr, "Invalid response: %s\n", ls2cstring(str_res));
+      err_log("invalid response: %s", ls2cstring(str_res));
+      return -1;
+    }
+    s = endp;
+  }
+  if (!spaces_only(s)) {
+    fprintf(stderr, "Invalid response: %s\n", ls2cstring(str_res));
+    err_log("invalid response: %s", ls2cstring(str_res));
+    return -1;
+  }
+
+  for (size_t i = 0; i < 4; ++i) {
+    fprintf(stdout, "%s: %lu%s\n", kFieldNames[i], vals[i],
+            kFieldUnits[i]);
+  }
+
+  return 0;
+}
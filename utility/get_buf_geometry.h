@@ -0,0 +1,35 @@
+/*
+ *  get_buf_geometry.h - get the log buffer geometry of a subsystem.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef GET_BUF_GEOMETRY_H_
+#define GET_BUF_GEOMETRY_H_
+
+#include "slogm_req.h"
+
+class GetBufGeometry : public SlogmRequest {
+ public:
+  GetBufGeometry(CpType type);
+  GetBufGeometry(const GetBufGeometry&) = delete;
+
+  GetBufGeometry& operator = (const GetBufGeometry&) = delete;
+
+ protected:
+  /*  do_request - implement the request.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int do_request() override;
+
+ private:
+  CpType type_;
+
+  int parse_query_result();
+};
+
+#endif  // !GET_BUF_GEOMETRY_H_
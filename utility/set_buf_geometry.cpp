@@ -0,0 +1,54 @@
+/*
+ *  set_buf_geometry.cpp - set the log buffer geometry of a subsystem.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+
+#include "set_buf_geometry.h"
+
+SetBufGeometry::SetBufGeometry(CpType type, unsigned buf_size,
+                               unsigned buf_num, unsigned log_commit,
+                               unsigned buf_commit)
+    : type_{type},
+      m_buf_size{buf_size},
+      m_buf_num{buf_num},
+      m_log_commit{log_commit},
+      m_buf_commit{buf_commit} {}
+
+int SetBufGeometry::do_request() {
+  // SET_BUF_GEOMETRY <cp name> <buf size> <buf num> <log commit>
+  //                  <buf commit>
+  uint8_t buf[128];
+
+  memcpy(buf, "SET_BUF_GEOMETRY ", 17);
+
+  uint8_t* p = buf + 17;
+  size_t rlen = sizeof buf - 17;
+  size_t tlen = 0;
+  int err = put_cp_type(p, rlen, type_, tlen);
+
+  if (err || (rlen == tlen)) {
+    fprintf(stderr,
+            "Can not make the subsystem parameter of SET_BUF_GEOMETRY\n");
+    return -1;
+  }
+
+  p += tlen;
+
+  size_t len = snprintf(reinterpret_cast<char*>(p),
+                        sizeof buf - 17 - tlen, " %u %u %u %u\n",
+                        m_buf_size, m_buf_num, m_log_commit, m_buf_commit);
+
+  err = send_req(buf, 17 + tlen + len);
+
+  if (err) {
+    report_error(RE_SEND_CMD_ERROR);
+    return -1;
+  }
+
+  return wait_simple_response(DEFAULT_RSP_TIME);
+}
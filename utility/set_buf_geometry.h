@@ -0,0 +1,40 @@
+/*
+ *  set_buf_geometry.h - set the log buffer geometry of a subsystem.
+ *
+ *  Copyright (C) 2026 Spreadtrum Communications Inc.
+ *
+ *  History:
+ *  2026-10-17
+ *  Initial version.
+ */
+#ifndef SET_BUF_GEOMETRY_H_
+#define SET_BUF_GEOMETRY_H_
+
+#include "cp_log_cmn.h"
+#include "slogm_req.h"
+
+class SetBufGeometry : public SlogmRequest {
+ public:
+  /*  Zero values keep the current settings of slogmodem.
+   */
+  SetBufGeometry(CpType type, unsigned buf_size, unsigned buf_num,
+                 unsigned log_commit, unsigned buf_commit);
+  SetBufGeometry(const SetBufGeometry&) = delete;
+  SetBufGeometry& operator= (const SetBufGeometry&) = delete;
+
+ protected:
+  /*  do_request - implement the request.
+   *
+   *  Return 0 on success, -1 on failure.
+   */
+  int do_request() override;
+
+ private:
+  CpType type_;
+  unsigned m_buf_size;
+  unsigned m_buf_num;
+  unsigned m_log_commit;
+  unsigned m_buf_commit;
+};
+
+#endif  // !SET_BUF_GEOMETRY_H_
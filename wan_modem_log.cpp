@@ -397,6 +397,7 @@ int WanModemLogHandler::create_storage() {
 
   if (!ret) {
     storage()->set_new_log_callback(new_log_callback);
+    storage()->set_time_sync_callback(time_sync_callback);
   }
 
   return ret;
@@ -502,14 +503,10 @@ uint8_t* WanModemLogHandler::frame_noversion_and_reserve(size_t& length) {
     length = (PRE_MODEM_VERSION_LEN << 1) + 18;
     ret = new uint8_t[length];
 
-    size_t framed_len;
-    uint8_t* diag_frame =
+    size_t framed_len =
         DiagStreamParser::frame(0xffffffff, 0, 0,
-                                reinterpret_cast<uint8_t*>(
-                                    const_cast<char*>(unavailable)),
-                                strlen(unavailable), framed_len);
-    memcpy(ret, diag_frame, framed_len);
-    delete [] diag_frame;
+                                reinterpret_cast<const uint8_t*>(unavailable),
+                                strlen(unavailable), ret, length);
     memset(ret + framed_len, 0x7e, length - framed_len);
   } else {
     // Keep the place holder for smp frame
@@ -533,16 +530,21 @@ uint8_t* WanModemLogHandler::frame_version_info(const uint8_t* payload,
   uint8_t* ret = nullptr;
 
   if (log_diag_dev_same()) {
-    ret = DiagStreamParser::frame(0xffffffff, 0, 0, payload,
-                                  pl_len, frame_len);
-    if (len_reserved && (frame_len > len_reserved)) {
-      // if framed info is larger than preserved, the next diag frame will
-      // be destroyed.
+    size_t max_len = DiagStreamParser::max_frame_len(pl_len);
+
+    // if framed info is larger than preserved, the next diag frame will
+    // be destroyed.
+    if (len_reserved && max_len > len_reserved) {
+      max_len = len_reserved;
+    }
+    ret = new uint8_t[max_len];
+    frame_len = DiagStreamParser::frame(0xffffffff, 0, 0, payload,
+                                        pl_len, ret, max_len);
+    if (!frame_len) {
       delete [] ret;
       ret = nullptr;
-      err_log("reserved length %u is less than needed %u",
-              static_cast<unsigned>(len_reserved),
-              static_cast<unsigned>(frame_len));
+      err_log("reserved length %u is less than needed",
+              static_cast<unsigned>(len_reserved));
     }
   } else {
     if (len_reserved) {
@@ -691,6 +693,10 @@ void WanModemLogHandler::on_new_log_file(LogFile* f) {
   }
 }
 
+bool WanModemLogHandler::get_time_sync(time_sync& ts) {
+  return time_sync_mgr_ && time_sync_mgr_->get_time_sync_info(ts);
+}
+
 void WanModemLogHandler::notify_modem_time_update(void* client,
     const time_sync& ts) {
   WanModemLogHandler* wan = static_cast<WanModemLogHandler*>(client);
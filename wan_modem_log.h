@@ -320,6 +320,7 @@ class WanModemLogHandler : public LogPipeHandler {
   void save_sipc_and_minidump(const struct tm& lt);
 
   void on_new_log_file(LogFile* f) override;
+  bool get_time_sync(time_sync& ts) override;
   /*  start_dump - WAN MODEM memory dump.
    *  Return Value:
    *    Return 0 if the dump transaction is started successfully,
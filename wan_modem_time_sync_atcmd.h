@@ -52,7 +52,7 @@ class WanModemTimeSyncAtCmd : public WanModemTimeSync {
   bool in_query_;
   ClientTransState trans_state_;
   TransModemTimeSync* trans_ts_;
-  TimerManager::Timer* timer_;
+  TimerManager::TimerHandle timer_;
   WanModemLogHandler* wan_modem_;
 };
 
@@ -29,12 +29,12 @@
 WanModemTimeSyncRefnotify::WanModemTimeSyncRefnotify(LogController* ctrl,
     Multiplexer* multi)
     : DataProcessHandler(-1, ctrl, multi, WAN_MODEM_TIME_SYNC_BUF_SIZE),
-      m_timer{0} {}
+      m_timer{nullptr} {}
 
 WanModemTimeSyncRefnotify::~WanModemTimeSyncRefnotify() {
   if (m_timer) {
     multiplexer()->timer_mgr().del_timer(m_timer);
-    m_timer = 0;
+    m_timer = nullptr;
   }
 }
 
@@ -64,7 +64,7 @@ int WanModemTimeSyncRefnotify::start() {
 void WanModemTimeSyncRefnotify::connect_server(void* param) {
   WanModemTimeSyncRefnotify* p = static_cast<WanModemTimeSyncRefnotify*>(param);
 
-  p->m_timer = 0;
+  p->m_timer = nullptr;
   p->start();
 }
 
@@ -46,7 +46,7 @@ class WanModemTimeSyncRefnotify :
   static const size_t WAN_MODEM_TIME_SYNC_BUF_SIZE = 64;
 
  private:
-  TimerManager::Timer* m_timer;
+  TimerManager::TimerHandle m_timer;
 
   int process_data() override;
   void process_conn_closed() override;
@@ -134,6 +134,7 @@ void WriteToLogFile::convey_method(std::function<unsigned(bool)> inspector,
       err_log("fail to write to %s",
               ls2cstring(dest_->dir()->path() + "/" + dest_->base_name()));
     } else {
+      io_done(size_);
       unit_done(Done);
       info_log("write file %s finished",
                ls2cstring(dest_->dir()->path() + "/" + dest_->base_name()));